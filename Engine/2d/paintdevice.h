@@ -38,7 +38,8 @@ class PaintDevice {
     enum Blend : uint8_t {
       NoBlend,
       Alpha,
-      Add
+      Add,
+      Premultiplied
       };
 
     struct Point {
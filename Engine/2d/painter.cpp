@@ -5,6 +5,7 @@
 #include <Tempest/Event>
 #include <Tempest/Brush>
 #include <Tempest/Pen>
+#include <Tempest/Profiler>
 
 #include "../utility/utf8_helper.h"
 
@@ -454,6 +455,7 @@ void Painter::popState() {
 void Painter::drawText(int x, int y, const char *txt) {
   if(txt==nullptr)
     return;
+  T_PROFILE_ZONE("Painter::drawText");
   auto pb=s.br;
   Utf8Iterator i(txt);
   while(i.hasData()) {
@@ -477,6 +479,7 @@ void Painter::drawText(int x, int y, const char *txt) {
 void Painter::drawText(int x, int y, const char16_t *txt) {
   if(txt==nullptr)
     return;
+  T_PROFILE_ZONE("Painter::drawText");
   auto pb=s.br;
 
   for(;*txt;++txt) {
@@ -20,6 +20,7 @@ class Painter {
     constexpr static auto NoBlend=Blend::NoBlend;
     constexpr static auto Alpha  =Blend::Alpha;
     constexpr static auto Add    =Blend::Add;
+    constexpr static auto Premultiplied=Blend::Premultiplied;
 
     Painter(PaintEvent& ev, Mode m=Preserve);
     Painter(const Painter&)=delete;
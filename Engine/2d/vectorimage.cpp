@@ -5,6 +5,7 @@
 #include <Tempest/Painter>
 #include <Tempest/Event>
 #include <Tempest/Encoder>
+#include <Tempest/Profiler>
 
 #define  NANOSVG_IMPLEMENTATION
 #include "thirdparty/nanosvg.h"
@@ -98,6 +99,14 @@ void VectorImage::clear() {
   slock.clear();
   }
 
+void VectorImage::setPremultipliedTarget(bool p) {
+  if(premulTarget==p)
+    return;
+  premulTarget = p;
+  for(auto& b:blocks)
+    b.pipeline = PipePtr();
+  }
+
 void VectorImage::addPoint(const PaintDevice::Point &p) {
   buf.push_back(p);
   blocks.back().size++;
@@ -114,6 +123,7 @@ void VectorImage::commitPoints() {
   }
 
 void VectorImage::makeActual(Device &dev,Swapchain& sw) {
+  T_PROFILE_ZONE("VectorImage::makeActual");
   if(!frame || frameCount!=dev.maxFramesInFlight()) {
     uint8_t count=dev.maxFramesInFlight();
     frame.reset(new PerFrame[count]);
@@ -171,37 +181,21 @@ void VectorImage::makeActual(Device &dev,Swapchain& sw) {
   }
 
 const RenderPipeline& VectorImage::pipelineOf(Device& dev, const VectorImage::Block& b) {
-  const RenderPipeline* p;
-  if(b.hasImg) {
-    if(b.tp==Triangles){
-      if(b.blend==NoBlend)
-        p=&dev.builtin().texture2d().brush; else
-      if(b.blend==Alpha)
-        p=&dev.builtin().texture2d().brushB; else
-        p=&dev.builtin().texture2d().brushA;
-      } else {
-      if(b.blend==NoBlend)
-        p=&dev.builtin().texture2d().pen; else
-      if(b.blend==Alpha)
-        p=&dev.builtin().texture2d().penB; else
-        p=&dev.builtin().texture2d().penA;
-      }
-    } else {
-    if(b.tp==Triangles) {
-      if(b.blend==NoBlend)
-        p=&dev.builtin().empty().brush; else
-      if(b.blend==Alpha)
-        p=&dev.builtin().empty().brushB; else
-        p=&dev.builtin().empty().brushA;
-      } else {
-      if(b.blend==NoBlend)
-        p=&dev.builtin().empty().pen; else
-      if(b.blend==Alpha)
-        p=&dev.builtin().empty().penB; else
-        p=&dev.builtin().empty().penA;
-      }
+  auto& it = b.hasImg ? dev.builtin().texture2d() : dev.builtin().empty();
+  const bool tri = (b.tp==Triangles);
+  switch(b.blend) {
+    case NoBlend:
+      return tri ? it.brush  : it.pen;
+    case Alpha:
+      if(premulTarget)
+        return tri ? it.brushL : it.penL;
+      return tri ? it.brushB : it.penB;
+    case Add:
+      return tri ? it.brushA : it.penA;
+    case Premultiplied:
+      return tri ? it.brushP : it.penP;
     }
-  return *p;
+  return tri ? it.brush : it.pen;
   }
 
 void VectorImage::draw(Device& dev, Swapchain& sw, Encoder<CommandBuffer> &cmd) {
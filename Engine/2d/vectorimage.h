@@ -25,6 +25,9 @@ class VectorImage : public Tempest::PaintDevice {
     bool     load(const char* path);
     void     clear() override;
 
+    //! target is cleared to transparent and later composited as premultiplied alpha
+    void     setPremultipliedTarget(bool p);
+
   private:
     void   addPoint(const Point& p) override;
     void   commitPoints() override;
@@ -120,6 +123,7 @@ class VectorImage : public Tempest::PaintDevice {
       };
     Info   info;
     size_t paintScope = 0;
+    bool   premulTarget = false;
 
     void makeActual(Device& dev, Swapchain& sw);
 
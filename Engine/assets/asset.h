@@ -10,6 +10,7 @@ class Asset {
   public:
     Asset()=default;
 
+    // content stays valid while any handle to this asset is alive
     template<class T>
     const T& get() const {
       using CleanT=typename std::remove_reference<typename std::remove_cv<T>::type>::type;
@@ -58,6 +59,7 @@ class Asset {
     size_t                hash=0;
 
   friend class Assets;
+  friend class AsyncAsset;
   };
 
 }
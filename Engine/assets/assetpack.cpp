@@ -0,0 +1,235 @@
+#include "assetpack.h"
+
+#include <Tempest/ODevice>
+#include <Tempest/Except>
+
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+static_assert(sizeof(AssetPack::Header)==32, "unexpected AssetPack::Header layout");
+static_assert(sizeof(AssetPack::Entry) ==40, "unexpected AssetPack::Entry layout");
+
+static const char     packMagic[4] = {'T','P','A','K'};
+static const uint32_t packVersion  = 1;
+
+static bool extIs(const char* name, const char* ext) {
+  const char* dot = std::strrchr(name,'.');
+  if(dot==nullptr)
+    return false;
+  ++dot;
+  for(;*dot && *ext;++dot,++ext) {
+    char c = *dot;
+    if('A'<=c && c<='Z')
+      c = char(c+'a'-'A');
+    if(c!=*ext)
+      return false;
+    }
+  return *dot=='\0' && *ext=='\0';
+  }
+
+AssetPack::AssetPack(const char* path)
+  :file(path) {
+  validate();
+  }
+
+AssetPack::AssetPack(const char16_t* path)
+  :file(path) {
+  validate();
+  }
+
+void AssetPack::validate() {
+  const uint8_t* d  = file.data();
+  const size_t   sz = file.size();
+  if(sz<sizeof(Header))
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  auto& h = *reinterpret_cast<const Header*>(d);
+  if(std::memcmp(h.magic,packMagic,4)!=0 || h.version!=packVersion)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  const uint64_t indexSz = uint64_t(h.count)*sizeof(Entry);
+  if(indexSz>sz-sizeof(Header) || h.namesSize>sz-sizeof(Header)-indexSz)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  index = reinterpret_cast<const Entry*>(d+sizeof(Header));
+  names = reinterpret_cast<const char*>(d+sizeof(Header)+indexSz);
+  count = h.count;
+
+  for(size_t i=0;i<count;++i) {
+    auto& e = index[i];
+    if(e.offset>sz || e.size>sz-e.offset || uint64_t(e.name)+e.nameLen>h.namesSize)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    if(e.compression==None && e.size!=e.rawSize)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    }
+  }
+
+const AssetPack::Entry* AssetPack::find(const char* name) const {
+  const size_t   len = std::strlen(name);
+  const uint64_t h   = hash(name,len);
+
+  auto it = std::lower_bound(index,index+count,h,[](const Entry& e,uint64_t h){
+    return e.hash<h;
+    });
+  for(;it!=index+count && it->hash==h;++it) {
+    if(it->nameLen==len && std::memcmp(names+it->name,name,len)==0)
+      return it;
+    }
+  return nullptr;
+  }
+
+std::string AssetPack::name(const Entry& e) const {
+  return std::string(names+e.name,e.nameLen);
+  }
+
+const uint8_t* AssetPack::data(const Entry& e) const {
+  if(e.compression!=None)
+    return nullptr;
+  return file.data()+e.offset;
+  }
+
+void AssetPack::read(const Entry& e, std::vector<uint8_t>& out) const {
+  const uint8_t* src = file.data()+e.offset;
+  out.resize(size_t(e.rawSize));
+
+  switch(e.compression) {
+    case None:
+      std::memcpy(out.data(),src,size_t(e.size));
+      return;
+    case Zlib: {
+      uLongf dstSz = uLongf(e.rawSize);
+      if(uncompress(out.data(),&dstSz,src,uLong(e.size))!=Z_OK || dstSz!=e.rawSize)
+        throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+      return;
+      }
+    }
+  throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+  }
+
+uint64_t AssetPack::hash(const char* name, size_t len) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ull;
+  for(size_t i=0;i<len;++i) {
+    h ^= uint8_t(name[i]);
+    h *= 1099511628211ull;
+    }
+  return h;
+  }
+
+AssetPack::Type AssetPack::detectType(const char* name, const uint8_t* d, size_t sz) {
+  if(sz>=4) {
+    if(std::memcmp(d,"DDS ",4)==0 || std::memcmp(d,"\x89PNG",4)==0 ||
+       std::memcmp(d,"GIF8",4)==0 || std::memcmp(d,"\xFF\xD8\xFF",3)==0)
+      return Image;
+    if(std::memcmp(d,"\x00\x01\x00\x00",4)==0 || std::memcmp(d,"OTTO",4)==0 ||
+       std::memcmp(d,"true",4)==0)
+      return Font;
+    if(std::memcmp(d,"\x03\x02\x23\x07",4)==0)
+      return Shader;
+    }
+  // formats without reliable magic
+  if(extIs(name,"bmp") || extIs(name,"tga") || extIs(name,"psd") ||
+     extIs(name,"hdr") || extIs(name,"pic") || extIs(name,"pnm"))
+    return Image;
+  return Unknown;
+  }
+
+AssetPack::Writer::Writer(uint32_t align)
+  :align(std::max(align,8u)) {
+  }
+
+void AssetPack::Writer::add(const char* name, const void* data, size_t size, Type type, Compression c) {
+  Item it;
+  it.name    = name;
+  if(it.name.size()>0xFFFF)
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+  it.hash    = hash(name,it.name.size());
+  it.rawSize = size;
+  it.type    = type;
+
+  if(c==Zlib && size>0) {
+    uLongf dstSz = compressBound(uLong(size));
+    it.data.resize(dstSz);
+    // keep compressed only if it's worth inflate on load
+    if(compress2(it.data.data(),&dstSz,reinterpret_cast<const Bytef*>(data),uLong(size),Z_BEST_COMPRESSION)==Z_OK &&
+       dstSz+dstSz/8<size) {
+      it.data.resize(dstSz);
+      it.compression = Zlib;
+      }
+    }
+
+  if(it.compression==None) {
+    auto d = reinterpret_cast<const uint8_t*>(data);
+    it.data.assign(d,d+size);
+    }
+  items.emplace_back(std::move(it));
+  }
+
+void AssetPack::Writer::save(ODevice& out) const {
+  std::vector<const Item*> sorted(items.size());
+  for(size_t i=0;i<items.size();++i)
+    sorted[i] = &items[i];
+  std::sort(sorted.begin(),sorted.end(),[](const Item* a,const Item* b){
+    if(a->hash!=b->hash)
+      return a->hash<b->hash;
+    return a->name<b->name;
+    });
+
+  std::vector<Entry> index(sorted.size());
+  std::string        names;
+  for(size_t i=0;i<sorted.size();++i) {
+    auto& e = index[i];
+    e.hash        = sorted[i]->hash;
+    e.size        = sorted[i]->data.size();
+    e.rawSize     = sorted[i]->rawSize;
+    e.name        = uint32_t(names.size());
+    e.nameLen     = uint16_t(sorted[i]->name.size());
+    e.type        = sorted[i]->type;
+    e.compression = sorted[i]->compression;
+    names        += sorted[i]->name;
+    }
+
+  Header h = {};
+  std::memcpy(h.magic,packMagic,4);
+  h.version   = packVersion;
+  h.count     = uint32_t(index.size());
+  h.align     = align;
+  h.namesSize = names.size();
+
+  uint64_t pos = sizeof(Header) + index.size()*sizeof(Entry) + names.size();
+  for(auto& e:index) {
+    pos      = (pos+align-1)/align*align;
+    e.offset = pos;
+    pos     += e.size;
+    }
+
+  static const uint8_t zero[64] = {};
+  auto pad = [&](uint64_t& at, uint64_t to) {
+    while(at<to) {
+      size_t n = size_t(std::min<uint64_t>(to-at,sizeof(zero)));
+      if(out.write(zero,n)!=n)
+        throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+      at += n;
+      }
+    };
+
+  if(out.write(&h,sizeof(h))!=sizeof(h) ||
+     out.write(index.data(),index.size()*sizeof(Entry))!=index.size()*sizeof(Entry) ||
+     out.write(names.data(),names.size())!=names.size())
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+
+  pos = sizeof(Header) + index.size()*sizeof(Entry) + names.size();
+  for(size_t i=0;i<index.size();++i) {
+    pad(pos,index[i].offset);
+    auto& d = sorted[i]->data;
+    if(out.write(d.data(),d.size())!=d.size())
+      throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+    pos += d.size();
+    }
+  if(!out.flush())
+    throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
+  }
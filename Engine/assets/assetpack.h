@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Tempest/File>
+
+#include <string>
+#include <vector>
+
+namespace Tempest {
+
+class ODevice;
+
+namespace Detail {
+
+// Packed asset archive:
+//   Header | Entry[count] (sorted by hash, then name) | names | data (each blob aligned)
+// all integers are little-endian
+class AssetPack final {
+  public:
+    enum Type : uint8_t {
+      Unknown = 0,
+      Image   = 1,
+      Font    = 2,
+      Shader  = 3,
+      };
+
+    enum Compression : uint8_t {
+      None = 0,
+      Zlib = 1,
+      };
+
+    struct Header {
+      char     magic[4];
+      uint32_t version;
+      uint32_t count;
+      uint32_t align;
+      uint64_t namesSize;
+      uint64_t reserved;
+      };
+
+    struct Entry {
+      uint64_t hash;
+      uint64_t offset;
+      uint64_t size;
+      uint64_t rawSize;
+      uint32_t name;
+      uint16_t nameLen;
+      uint8_t  type;
+      uint8_t  compression;
+      };
+
+    explicit AssetPack(const char*     path);
+    explicit AssetPack(const char16_t* path);
+
+    size_t         size() const { return count; }
+    const Entry&   operator[](size_t i) const { return index[i]; }
+    const Entry*   find(const char* name) const;
+    std::string    name(const Entry& e) const;
+
+    // direct view into mapping, nullptr for compressed entries
+    const uint8_t* data(const Entry& e) const;
+    void           read(const Entry& e, std::vector<uint8_t>& out) const;
+
+    static uint64_t hash(const char* name, size_t len);
+    static Type     detectType(const char* name, const uint8_t* data, size_t size);
+
+    class Writer final {
+      public:
+        explicit Writer(uint32_t align=16);
+
+        void add(const char* name, const void* data, size_t size, Type type, Compression c);
+        void save(ODevice& out) const;
+
+      private:
+        struct Item {
+          std::string          name;
+          uint64_t             hash=0;
+          std::vector<uint8_t> data;
+          uint64_t             rawSize=0;
+          Type                 type=Unknown;
+          Compression          compression=None;
+          };
+        std::vector<Item> items;
+        uint32_t          align=16;
+      };
+
+  private:
+    void            validate();
+
+    MappedFile      file;
+    const Entry*    index=nullptr;
+    const char*     names=nullptr;
+    size_t          count=0;
+  };
+
+}
+}
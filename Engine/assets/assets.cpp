@@ -11,34 +11,65 @@
 #include <unistd.h>
 #endif
 
+#ifndef __WINDOWS__
+#include <sys/stat.h>
+#endif
+
 #include <Tempest/Device>
 #include <Tempest/Pixmap>
 #include <Tempest/Texture2d>
 #include <Tempest/Sprite>
 #include <Tempest/Font>
 #include <Tempest/TextCodec>
+#include <Tempest/MemReader>
+
+#include "assetpack.h"
+#include "filewatcher.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
 
 using namespace Tempest;
 
-struct Assets::TextureFile : Asset::Impl {
-  TextureFile(Pixmap&& p,Assets::str_path&& path,Directory& owner)
-    :owner(owner),fpath(path),value(std::move(p)) {}
+struct Assets::AssetFile : Asset::Impl {
+  // takes content of freshly loaded copy of same file; called from owner thread
+  virtual void replace(AssetFile& fresh)=0;
+  };
+
+struct Assets::TextureFile : AssetFile {
+  TextureFile(Pixmap&& p,Assets::str_path&& path,Storage& owner)
+    :owner(owner),fpath(path) {
+    setValue(std::move(p));
+    touch();
+    }
+
+  ~TextureFile() override {
+    setValue(Pixmap());
+    setTexture(Texture2d());
+    }
 
   const void* get(const std::type_info& t) override {
-    if(t==typeid(Pixmap))
-      return &getValue();
+    touch();
+
+    if(t==typeid(Pixmap)) {
+      auto& ret = getValue();
+      owner.enforceBudget();
+      return &ret;
+      }
 
     if(t==typeid(Texture2d)) {
       if(tex.isEmpty())
-        tex = owner.device.loadTexture(getValue(),true);
-      value=Pixmap();
+        setTexture(owner.device.loadTexture(getValue(),true));
+      setValue(Pixmap());
+      owner.enforceBudget();
       return &tex;
       }
 
     if(t==typeid(Sprite)) {
       if(spr.isEmpty())
         spr = owner.atlas.load(getValue());
-      value=Pixmap();
+      setValue(Pixmap());
       return &spr;
       }
 
@@ -53,7 +84,7 @@ struct Assets::TextureFile : Asset::Impl {
     if(!value.isEmpty())
       return value;
     try {
-      value=Pixmap(fpath);
+      setValue(owner.reload(fpath));
       return value;
       }
     catch(...) {
@@ -63,15 +94,69 @@ struct Assets::TextureFile : Asset::Impl {
       }
     }
 
-  Directory&             owner;
+  void setValue(Pixmap&& p) {
+    owner.pixmapBytes -= value.dataSize();
+    value = std::move(p);
+    owner.pixmapBytes += value.dataSize();
+    }
+
+  void setTexture(Texture2d&& t) {
+    owner.textureBytes -= texBytes;
+    tex      = std::move(t);
+    // estimate: with mip chain
+    texBytes = tex.isEmpty() ? 0 : value.dataSize()*4/3;
+    owner.textureBytes += texBytes;
+    }
+
+  void replace(AssetFile& f) override {
+    auto fresh = dynamic_cast<TextureFile*>(&f);
+    if(fresh==nullptr)
+      return;
+    const bool hadTex = !tex.isEmpty();
+    const bool hadSpr = !spr.isEmpty();
+
+    setValue(fresh->takeValue());
+    // references to tex/spr are live, so reupload right away
+    if(hadTex)
+      setTexture(owner.device.loadTexture(value,true));
+    if(hadSpr)
+      spr = owner.atlas.load(value);
+    if(hadTex || hadSpr)
+      setValue(Pixmap());
+    }
+
+  Pixmap takeValue() {
+    owner.pixmapBytes -= value.dataSize();
+    Pixmap ret(std::move(value));
+    value = Pixmap();
+    return ret;
+    }
+
+  void touch() {
+    lastUse.store(owner.tick(),std::memory_order_relaxed);
+    }
+
+  bool isResident() const {
+    return !value.isEmpty() || !tex.isEmpty();
+    }
+
+  // called under owner.sync, only when nobody else holds this asset; next get() reloads
+  void evict() {
+    setValue(Pixmap());
+    setTexture(Texture2d());
+    }
+
+  Storage&               owner;
   const Assets::str_path fpath;
   Pixmap                 value;
   Texture2d              tex;
+  size_t                 texBytes=0;
+  std::atomic<uint64_t>  lastUse{0};
   Sprite                 spr;
   };
 
-struct Assets::FontFile : Asset::Impl {
-  FontFile(Font&& f,Assets::str_path&& path,Directory& owner)
+struct Assets::FontFile : AssetFile {
+  FontFile(Font&& f,Assets::str_path&& path,Storage& owner)
     :owner(owner),fpath(path),fnt(std::move(f)) {}
 
   const void* get(const std::type_info& t) override {
@@ -80,21 +165,26 @@ struct Assets::FontFile : Asset::Impl {
     return nullptr;
     }
 
+  void replace(AssetFile& f) override {
+    if(auto fresh = dynamic_cast<FontFile*>(&f))
+      fnt = std::move(fresh->fnt);
+    }
+
   const str_path& path() const override {
     return fpath;
     }
 
-  Directory&             owner;
+  Storage&               owner;
   const Assets::str_path fpath;
   Font                   fnt;
   };
 
-struct Assets::ShaderFile : Asset::Impl {
-  ShaderFile(Shader&& p,Assets::str_path&& path,Directory& owner)
+struct Assets::ShaderFile : AssetFile {
+  ShaderFile(Shader&& p,Assets::str_path&& path,Storage& owner)
     :owner(owner),fpath(path),value(std::move(p)) {
     }
 
-  static Shader tryOpen(Directory& owner,const Assets::str_path& fpath) {
+  static Shader tryOpen(Storage& owner,const Assets::str_path& fpath) {
     return owner.device.loadShader(fpath.c_str());
     }
 
@@ -104,30 +194,425 @@ struct Assets::ShaderFile : Asset::Impl {
     return nullptr;
     }
 
+  void replace(AssetFile& f) override {
+    // NOTE: pipelines keep using old shader, until recreated
+    if(auto fresh = dynamic_cast<ShaderFile*>(&f))
+      value = std::move(fresh->value);
+    }
+
   const str_path& path() const override {
     return fpath;
     }
 
-  Directory&             owner;
+  Storage&               owner;
   const Assets::str_path fpath;
   Shader                 value;
   };
 
+struct AsyncAsset::State {
+  enum Status : uint8_t {
+    Pending,
+    Loading,
+    Ready,
+    Failed,
+    Cancelled,
+    };
+
+  std::string            name;
+  std::atomic<uint8_t>   status{Pending};
+  Asset                  asset;
+  std::weak_ptr<Ticket>  ticket;
+  };
+
+struct AsyncAsset::Ticket {
+  Ticket(std::shared_ptr<State> st, std::weak_ptr<Assets::Loader> loader):state(std::move(st)),loader(std::move(loader)){}
+  ~Ticket() {
+    // nobody waits for result anymore
+    cancel();
+    }
+  void cancel();
+
+  std::shared_ptr<State>        state;
+  std::weak_ptr<Assets::Loader> loader;
+  };
+
+AsyncAsset::AsyncAsset(std::shared_ptr<Ticket> t)
+  :ticket(std::move(t)) {
+  }
+
+const Asset* AsyncAsset::implAsset() const {
+  if(ticket==nullptr || ticket->state->status.load(std::memory_order_acquire)!=State::Ready)
+    return nullptr;
+  return &ticket->state->asset;
+  }
+
+Asset AsyncAsset::asset() const {
+  if(auto a = implAsset())
+    return *a;
+  return Asset();
+  }
+
+const char* AsyncAsset::name() const {
+  if(ticket==nullptr)
+    return "";
+  return ticket->state->name.c_str();
+  }
+
+bool AsyncAsset::isReady() const {
+  return implAsset()!=nullptr;
+  }
+
+bool AsyncAsset::isFailed() const {
+  return ticket!=nullptr && ticket->state->status.load(std::memory_order_acquire)==State::Failed;
+  }
+
+void AsyncAsset::cancel() {
+  if(ticket!=nullptr)
+    ticket->cancel();
+  }
+
+struct Assets::Loader {
+  struct Job {
+    std::shared_ptr<AsyncAsset::State> state;
+    Priority                           priority=Normal;
+    uint64_t                           seq=0;
+    bool                               prefetch=false;
+
+    bool operator < (const Job& other) const {
+      if(priority!=other.priority)
+        return priority<other.priority;
+      return seq>other.seq;
+      }
+    };
+
+  explicit Loader(Provider& provider):provider(provider) {
+    size_t cnt = std::thread::hardware_concurrency();
+    cnt = std::max<size_t>(1,std::min<size_t>(cnt>1 ? cnt-1 : 1,MaxThreads));
+    for(size_t i=0;i<cnt;++i)
+      th.emplace_back([this]() noexcept { workerLoop(); });
+    }
+
+  ~Loader() {
+    shutdown();
+    }
+
+  void shutdown() {
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    stop = true;
+    }
+    cv.notify_all();
+    for(auto& i:th)
+      i.join();
+    th.clear();
+    }
+
+  void push(std::shared_ptr<AsyncAsset::State>&& st, Priority p, bool prefetch) {
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    Job j;
+    j.state    = std::move(st);
+    j.priority = p;
+    j.seq      = seq++;
+    j.prefetch = prefetch;
+    queue.push_back(std::move(j));
+    std::push_heap(queue.begin(),queue.end());
+    }
+    cv.notify_one();
+    }
+
+  void cancel(const AsyncAsset::State* st) {
+    std::lock_guard<std::mutex> guard(sync);
+    auto it = std::find_if(queue.begin(),queue.end(),[st](const Job& j){ return j.state.get()==st; });
+    if(it==queue.end())
+      return;
+    queue.erase(it);
+    std::make_heap(queue.begin(),queue.end());
+    }
+
+  void cancelPrefetch() {
+    std::lock_guard<std::mutex> guard(sync);
+    queue.erase(std::remove_if(queue.begin(),queue.end(),[](const Job& j){ return j.prefetch; }),queue.end());
+    std::make_heap(queue.begin(),queue.end());
+    }
+
+  std::vector<std::shared_ptr<AsyncAsset::State>> takeDone() {
+    std::vector<std::shared_ptr<AsyncAsset::State>> ret;
+    std::lock_guard<std::mutex> guard(sync);
+    ret.swap(done);
+    return ret;
+    }
+
+  void workerLoop() {
+    while(true) {
+      Job j;
+      {
+      std::unique_lock<std::mutex> guard(sync);
+      cv.wait(guard,[this](){ return stop || !queue.empty(); });
+      if(stop)
+        return;
+      std::pop_heap(queue.begin(),queue.end());
+      j = std::move(queue.back());
+      queue.pop_back();
+      }
+
+      auto&   st = *j.state;
+      uint8_t s  = AsyncAsset::State::Pending;
+      if(!st.status.compare_exchange_strong(s,AsyncAsset::State::Loading))
+        continue; // cancelled
+
+      try {
+        st.asset = provider.open(st.name.c_str());
+        }
+      catch(...) {
+        st.asset = Asset();
+        }
+      st.status.store(st.asset.impl!=nullptr ? AsyncAsset::State::Ready : AsyncAsset::State::Failed,
+                      std::memory_order_release);
+      if(j.prefetch)
+        continue;
+
+      std::lock_guard<std::mutex> guard(sync);
+      done.emplace_back(std::move(j.state));
+      }
+    }
+
+  enum { MaxThreads=4 };
+
+  Provider&                                       provider;
+  std::mutex                                      sync;
+  std::condition_variable                         cv;
+  std::vector<Job>                                queue;
+  uint64_t                                        seq=0;
+  bool                                            stop=false;
+  std::vector<std::shared_ptr<AsyncAsset::State>> done;
+  std::vector<std::thread>                        th;
+  };
+
+void AsyncAsset::Ticket::cancel() {
+  uint8_t s = State::Pending;
+  if(!state->status.compare_exchange_strong(s,State::Cancelled))
+    return;
+  if(auto l = loader.lock())
+    l->cancel(state.get());
+  }
+
+struct Assets::Archive : Storage {
+  Archive(const str_path& path, Device& dev)
+    :Storage(dev),pack(path.c_str()),files(pack.size()) {
+    }
+
+  Asset open(const char* file) override {
+    auto e = pack.find(file);
+    if(e==nullptr)
+      return Asset();
+    const size_t id = size_t(e-&pack[0]);
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    if(files[id].impl!=nullptr) {
+      hits.fetch_add(1,std::memory_order_relaxed);
+      return files[id];
+      }
+    }
+
+    misses.fetch_add(1,std::memory_order_relaxed);
+    Asset a = implOpen(*e);
+    std::lock_guard<std::mutex> guard(sync);
+    if(files[id].impl==nullptr)
+      files[id] = a;
+    return files[id];
+    }
+
+  void collect(std::vector<Asset*>& out) override {
+    for(auto& i:files)
+      if(i.impl!=nullptr)
+        out.push_back(&i);
+    }
+
+  Pixmap reload(const str_path& path) override {
+#ifndef __WINDOWS__
+    auto e = pack.find(path.c_str());
+#else
+    auto e = pack.find(TextCodec::toUtf8(path).c_str());
+#endif
+    if(e==nullptr || e->type!=Detail::AssetPack::Image)
+      return Pixmap();
+    std::vector<uint8_t> buf;
+    MemReader rd(view(*e,buf),size_t(e->rawSize));
+    return Pixmap(rd);
+    }
+
+  Asset implOpen(const Detail::AssetPack::Entry& e) {
+#ifndef __WINDOWS__
+    str_path fpath = pack.name(e);
+#else
+    str_path fpath = TextCodec::toUtf16(pack.name(e));
+#endif
+    try {
+      std::vector<uint8_t> buf;
+      const uint8_t*       data = view(e,buf);
+      MemReader            rd(data,size_t(e.rawSize));
+      // type is known from index, no need to probe loaders
+      switch(e.type) {
+        case Detail::AssetPack::Image: {
+          Pixmap p(rd);
+          return Asset(std::make_shared<TextureFile>(std::move(p),std::move(fpath),*this));
+          }
+        case Detail::AssetPack::Font: {
+          Font f(rd);
+          return Asset(std::make_shared<FontFile>(std::move(f),std::move(fpath),*this));
+          }
+        case Detail::AssetPack::Shader: {
+          Shader sh = device.shader(data,size_t(e.rawSize));
+          return Asset(std::make_shared<ShaderFile>(std::move(sh),std::move(fpath),*this));
+          }
+        }
+      }
+    catch(...) {
+      // broken entry
+      }
+    return Asset();
+    }
+
+  const uint8_t* view(const Detail::AssetPack::Entry& e,std::vector<uint8_t>& buf) {
+    if(auto d = pack.data(e))
+      return d;
+    pack.read(e,buf);
+    return buf.data();
+    }
+
+  Detail::AssetPack  pack;
+  std::vector<Asset> files;
+  };
+
 Assets::Assets(const char* path, Tempest::Device &dev) {
-  impl.reset(new Directory(path,dev));
+#ifndef __WINDOWS__
+  str_path full = Storage::modulePath()+path;
+  struct stat st={};
+  const bool isFile = (::stat(full.c_str(),&st)==0 && S_ISREG(st.st_mode));
+#else
+  str_path full = Storage::modulePath()+TextCodec::toUtf16(path);
+  DWORD attr = GetFileAttributesW(reinterpret_cast<const wchar_t*>(full.c_str()));
+  const bool isFile = (attr!=INVALID_FILE_ATTRIBUTES && (attr&FILE_ATTRIBUTE_DIRECTORY)==0);
+#endif
+  if(isFile)
+    impl.reset(new Archive(full,dev)); else
+    impl.reset(new Directory(path,dev));
   }
 
-Assets::~Assets() {}
+Assets::~Assets() {
+  // workers refer to impl; handles may still hold loader
+  if(loader!=nullptr)
+    loader->shutdown();
+  loader.reset();
+  }
 
 Asset Assets::operator[](const char* file) const {
   return impl->open(file);
   }
 
+Assets::Stats Assets::stats() const {
+  Stats s;
+  s.hits         = impl->hits.load();
+  s.misses       = impl->misses.load();
+  s.evictions    = impl->evictions.load();
+  s.pixmapBytes  = impl->pixmapBytes.load();
+  s.textureBytes = impl->textureBytes.load();
+  return s;
+  }
+
+void Assets::setBudget(size_t cpuBytes, size_t gpuBytes) {
+  {
+  std::lock_guard<std::mutex> guard(impl->sync);
+  impl->cpuBudget = cpuBytes;
+  impl->gpuBudget = gpuBytes;
+  }
+  impl->enforceBudget();
+  }
+
+AsyncAsset Assets::loadAsync(const char* file, Priority p) {
+  if(loader==nullptr)
+    loader = std::make_shared<Loader>(*impl);
+
+  auto st = std::make_shared<AsyncAsset::State>();
+  st->name = file;
+  auto t = std::make_shared<AsyncAsset::Ticket>(st,loader);
+  st->ticket = t;
+  loader->push(std::move(st),p,false);
+  return AsyncAsset(std::move(t));
+  }
+
+void Assets::prefetch(const char* file, Priority p) {
+  if(loader==nullptr)
+    loader = std::make_shared<Loader>(*impl);
+
+  auto st = std::make_shared<AsyncAsset::State>();
+  st->name = file;
+  loader->push(std::move(st),p,true);
+  }
+
+void Assets::cancelPrefetch() {
+  if(loader!=nullptr)
+    loader->cancelPrefetch();
+  }
+
+void Assets::setHotReload(bool enable) {
+  impl->setHotReload(enable);
+  }
+
+void Assets::dispatchLoaded() {
+  impl->applyReloaded();
+
+  if(loader==nullptr)
+    return;
+  auto done = loader->takeDone();
+  for(auto& i:done) {
+    if(auto t = i->ticket.lock())
+      onLoaded(AsyncAsset(std::move(t)));
+    }
+  }
+
+Assets::Storage::Storage(Device &dev)
+  :device(dev),atlas(dev) {
+  }
+
+void Assets::Storage::enforceBudget() {
+  std::lock_guard<std::mutex> guard(sync);
+  auto overCpu = [this](){ return cpuBudget>0 && pixmapBytes.load()>cpuBudget;  };
+  auto overGpu = [this](){ return gpuBudget>0 && textureBytes.load()>gpuBudget; };
+  if(!overCpu() && !overGpu())
+    return;
+
+  std::vector<Asset*> all;
+  collect(all);
+
+  std::vector<TextureFile*> lru;
+  for(auto i:all) {
+    // use_count==1: no Asset handle is alive, so content is unreferenced
+    // and no get() can run concurrently
+    if(i->impl.use_count()!=1)
+      continue;
+    auto tx = dynamic_cast<TextureFile*>(i->impl.get());
+    if(tx!=nullptr && tx->isResident())
+      lru.push_back(tx);
+    }
+  std::sort(lru.begin(),lru.end(),[](const TextureFile* a,const TextureFile* b){
+    return a->lastUse.load(std::memory_order_relaxed)<b->lastUse.load(std::memory_order_relaxed);
+    });
+
+  for(auto i:lru) {
+    if(!overCpu() && !overGpu())
+      break;
+    i->evict();
+    evictions.fetch_add(1,std::memory_order_relaxed);
+    }
+  }
+
 Assets::Directory::Directory(const char *name, Device &dev)
 #ifndef __WINDOWS__
-  :path(modulePath()+name),device(dev),atlas(dev) {
+  :Storage(dev),path(modulePath()+name) {
 #else
-  :device(dev),atlas(dev){
+  :Storage(dev){
   path = modulePath()+TextCodec::toUtf16(name);
 #endif
   if(path.size()!=0 && path.back()!='/')
@@ -146,17 +631,29 @@ Asset Assets::Directory::open(const char *file) {
   MultiByteToWideChar(CP_UTF8,0,file,-1,reinterpret_cast<wchar_t*>(&fpath[path.size()]),len-1);
 #endif
 
-  AssetHash ah;
-  auto hash=ah(fpath);
-
-  for(auto& i:files){
-    if(i.hash==hash && i.impl && i.impl->path()==fpath)
-      return i;
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  auto it = files.find(fpath);
+  if(it!=files.end()) {
+    hits.fetch_add(1,std::memory_order_relaxed);
+    return it->second;
     }
+  }
+
+  misses.fetch_add(1,std::memory_order_relaxed);
+  // decode without lock: other files can be loaded in parallel
+  Asset a=implOpen(str_path(fpath));
+  if(a.impl==nullptr)
+    return a;
+
+  std::lock_guard<std::mutex> guard(sync);
+  // emplace keeps asset, that was loaded concurrently
+  return files.emplace(std::move(fpath),std::move(a)).first->second;
+  }
 
-  Asset a=implOpen(std::move(fpath));
-  files.emplace_back(a);
-  return a;
+void Assets::Directory::collect(std::vector<Asset*>& out) {
+  for(auto& i:files)
+    out.push_back(&i.second);
   }
 
 Asset Assets::Directory::implOpen(str_path&& fpath) {
@@ -178,6 +675,60 @@ Asset Assets::Directory::implOpen(str_path&& fpath) {
   return Asset();
   }
 
+void Assets::Directory::setHotReload(bool enable) {
+#ifdef __LINUX__
+  if(!enable) {
+    watcher.reset();
+    return;
+    }
+  if(watcher==nullptr)
+    watcher.reset(new Detail::FileWatcher(path,[this](std::vector<std::string>&& f){ onChanged(std::move(f)); }));
+#else
+  (void)enable;
+#endif
+  }
+
+void Assets::Directory::onChanged(std::vector<std::string>&& changed) {
+  for(auto& i:changed) {
+    str_path fpath = path + i;
+    Asset    cur;
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    auto it = files.find(fpath);
+    if(it==files.end())
+      continue; // never requested, nothing to update
+    cur = it->second;
+    }
+
+    // decode here, on watcher thread
+    Asset fresh = implOpen(std::move(fpath));
+    if(fresh.impl==nullptr)
+      continue;
+
+    std::lock_guard<std::mutex> guard(sync);
+    reloaded.emplace_back(std::move(cur),std::move(fresh));
+    }
+  }
+
+void Assets::Directory::applyReloaded() {
+  std::vector<std::pair<Asset,Asset>> r;
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  if(reloaded.empty())
+    return;
+  r.swap(reloaded);
+  }
+  for(auto& i:r) {
+    auto& cur   = static_cast<AssetFile&>(*i.first.impl);
+    auto& fresh = static_cast<AssetFile&>(*i.second.impl);
+    cur.replace(fresh);
+    }
+  }
+
+Pixmap Assets::Directory::reload(const str_path& fpath) {
+  return Pixmap(fpath);
+  }
+
 #if defined(__WINDOWS__)
 static int32_t implMouleFileName(char16_t* out,size_t maxPath){
   DWORD len = GetModuleFileNameW(nullptr, reinterpret_cast<wchar_t*>(out), DWORD(maxPath));
@@ -192,7 +743,7 @@ static ssize_t implMouleFileName(char* out,size_t maxPath){
 #endif
   }
 
-Assets::str_path Assets::Directory::modulePath() {
+Assets::str_path Assets::Storage::modulePath() {
   str_path str;
   size_t sz=0;
   while(true) {
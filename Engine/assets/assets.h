@@ -3,13 +3,56 @@
 #include <Tempest/Platform>
 #include <Tempest/Asset>
 #include <Tempest/TextureAtlas>
+#include <Tempest/Signal>
 
 #include <memory>
-#include <unordered_set>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace Tempest {
 
 class Device;
+class Pixmap;
+class Assets;
+
+namespace Detail {
+class FileWatcher;
+}
+
+class AsyncAsset final {
+  public:
+    AsyncAsset()=default;
+
+    // non blocking: nullptr until loaded, or if asset can't be represented as T
+    template<class T>
+    const T* tryGet() const {
+      using CleanT=typename std::remove_reference<typename std::remove_cv<T>::type>::type;
+      auto a = implAsset();
+      if(a==nullptr || a->impl==nullptr)
+        return nullptr;
+      return reinterpret_cast<const T*>(a->impl->get(typeid(CleanT)));
+      }
+
+    // non blocking, empty until loaded
+    Asset       asset() const;
+    const char* name() const;
+
+    bool        isReady() const;
+    bool        isFailed() const;
+    void        cancel();
+
+  private:
+    struct State;
+    struct Ticket;
+
+    explicit AsyncAsset(std::shared_ptr<Ticket> t);
+    const Asset* implAsset() const;
+
+    std::shared_ptr<Ticket> ticket;
+
+  friend class Assets;
+  };
 
 class Assets final {
 #ifdef __WINDOWS__
@@ -18,10 +61,44 @@ class Assets final {
   using str_path=std::string;
 #endif
   public:
+    // path is either directory or packed archive, relative to executable
     Assets(const char *path,Tempest::Device& dev);
     ~Assets();
 
-    Asset operator[](const char* file) const;
+    enum Priority : uint8_t {
+      Low,
+      Normal,
+      High,
+      };
+
+    struct Stats {
+      uint64_t hits         = 0;
+      uint64_t misses       = 0;
+      uint64_t evictions    = 0;
+      size_t   pixmapBytes  = 0;
+      size_t   textureBytes = 0;
+      };
+
+    Asset      operator[](const char* file) const;
+
+    Stats      stats() const;
+    // 0 means unlimited; pixmaps and textures, that are not held by any Asset handle,
+    // are evicted in LRU order and reloaded on next get<T>()
+    void       setBudget(size_t cpuBytes, size_t gpuBytes);
+
+    // decoded on worker threads; dropping all handles or cancel() removes pending load from queue
+    AsyncAsset loadAsync(const char* file, Priority p=Normal);
+    // loads into cache, without handle
+    void       prefetch(const char* file, Priority p=Low);
+    void       cancelPrefetch();
+
+    // re-read files, modified on disk (linux only); live assets are updated in dispatchLoaded
+    void       setHotReload(bool enable);
+
+    // emits onLoaded for finished loads and applies hot-reloaded files;
+    // must be called from owner thread, once per frame
+    void       dispatchLoaded();
+    Signal<void(const AsyncAsset&)> onLoaded;
 
     struct Provider {
       virtual ~Provider(){}
@@ -39,12 +116,43 @@ class Assets final {
         }
       };
 
-    struct Directory:Provider {
+    struct Storage:Provider {
+      Storage(Tempest::Device &dev);
+
+      // pixmap is dropped after upload to gpu, so it may need to be read again
+      virtual Pixmap                     reload(const str_path& path)=0;
+      // all cached assets; called under sync
+      virtual void                       collect(std::vector<Asset*>& out)=0;
+      virtual void                       setHotReload(bool /*enable*/){}
+      virtual void                       applyReloaded(){}
+
+      uint64_t                           tick() { return clock.fetch_add(1,std::memory_order_relaxed); }
+      void                               enforceBudget();
+
+      Tempest::Device&                   device;
+      Tempest::TextureAtlas              atlas;
+      // guards cache, so open() can be called from loader threads
+      std::mutex                         sync;
+
+      std::atomic<uint64_t>              clock{0};
+      std::atomic<uint64_t>              hits{0}, misses{0}, evictions{0};
+      std::atomic<size_t>                pixmapBytes{0}, textureBytes{0};
+      size_t                             cpuBudget=0, gpuBudget=0;
+
+      static str_path                    modulePath();
+      };
+
+    struct Directory:Storage {
       Directory(const char* path,Tempest::Device &dev);
       ~Directory() override=default;
 
-      Asset open(const char* file) override;
-      Asset implOpen(str_path &&path);
+      Asset  open(const char* file) override;
+      Asset  implOpen(str_path &&path);
+      Pixmap reload(const str_path& path) override;
+      void   collect(std::vector<Asset*>& out) override;
+      void   setHotReload(bool enable) override;
+      void   applyReloaded() override;
+      void   onChanged(std::vector<std::string>&& changed);
 
       template<class ClsAsset,class File>
       std::pair<Asset,bool> implOpenTry(str_path &path);
@@ -52,18 +160,25 @@ class Assets final {
       template<class File>
       std::pair<Asset,bool> implOpenTry(str_path &path);
 
-      str_path                           path;
-      Tempest::Device&                   device;
-      Tempest::TextureAtlas              atlas;
-      std::vector<Asset>                 files;
-      str_path                           modulePath();
+      str_path                                     path;
+      std::unordered_map<str_path,Asset,AssetHash> files;
+      std::vector<std::pair<Asset,Asset>>          reloaded;
+      std::unique_ptr<Detail::FileWatcher>         watcher;
       };
 
+    struct Archive;
+
+    struct AssetFile;
     struct TextureFile;
     struct FontFile;
     struct ShaderFile;
 
-    std::unique_ptr<Provider> impl;
+    struct Loader;
+
+    std::unique_ptr<Storage>  impl;
+    std::shared_ptr<Loader>   loader;
+
+  friend class AsyncAsset;
   };
 
 }
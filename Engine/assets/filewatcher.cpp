@@ -0,0 +1,147 @@
+#include "filewatcher.h"
+
+#include <Tempest/Dir>
+#include <Tempest/Log>
+
+#include <algorithm>
+
+#ifdef __LINUX__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+#ifdef __LINUX__
+FileWatcher::FileWatcher(const std::string& root, Callback cb)
+  :root(root), cb(std::move(cb)) {
+  if(!this->root.empty() && this->root.back()=='/')
+    this->root.pop_back();
+
+  fd     = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+  stopFd = eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+  if(fd<0 || stopFd<0) {
+    Log::e("FileWatcher: unable to init inotify");
+    return;
+    }
+  addWatch("");
+  th = std::thread([this]() noexcept { threadFunc(); });
+  }
+
+FileWatcher::~FileWatcher() {
+  if(th.joinable()) {
+    uint64_t one = 1;
+    if(write(stopFd,&one,sizeof(one))!=sizeof(one))
+      Log::e("FileWatcher: unable to stop watcher thread");
+    th.join();
+    }
+  if(fd>=0)
+    close(fd);
+  if(stopFd>=0)
+    close(stopFd);
+  }
+
+bool FileWatcher::isSupported() {
+  return true;
+  }
+
+void FileWatcher::addWatch(const std::string& rel) {
+  const std::string path = rel.empty() ? root : root+"/"+rel;
+  int wd = inotify_add_watch(fd,path.c_str(),IN_CLOSE_WRITE|IN_MOVED_TO|IN_CREATE);
+  if(wd<0)
+    return;
+  dirs[wd] = rel;
+
+  Dir::scan(path,[&](const std::string& name,Dir::FileType t){
+    if(t!=Dir::FT_Dir || name=="." || name=="..")
+      return;
+    addWatch(rel.empty() ? name : rel+"/"+name);
+    });
+  }
+
+void FileWatcher::readEvents(std::vector<std::string>& pending) {
+  alignas(inotify_event) char buf[4096];
+  while(true) {
+    ssize_t len = read(fd,buf,sizeof(buf));
+    if(len<=0)
+      return;
+
+    for(char* p=buf; p<buf+len; ) {
+      auto& ev = *reinterpret_cast<inotify_event*>(p);
+      p += sizeof(inotify_event)+ev.len;
+
+      auto dir = dirs.find(ev.wd);
+      if(dir==dirs.end() || ev.len==0)
+        continue;
+
+      std::string rel = dir->second.empty() ? ev.name : dir->second+"/"+ev.name;
+      if(ev.mask & IN_ISDIR) {
+        if(ev.mask & (IN_CREATE|IN_MOVED_TO))
+          addWatch(rel);
+        continue;
+        }
+      // IN_CREATE alone is followed by IN_CLOSE_WRITE
+      if(ev.mask & (IN_CLOSE_WRITE|IN_MOVED_TO))
+        pending.emplace_back(std::move(rel));
+      }
+    }
+  }
+
+void FileWatcher::threadFunc() {
+  std::vector<std::string> pending;
+  pollfd fds[2] = {};
+  fds[0].fd     = fd;
+  fds[0].events = POLLIN;
+  fds[1].fd     = stopFd;
+  fds[1].events = POLLIN;
+
+  while(true) {
+    // editors write files in several steps: wait until burst is over
+    int ret = poll(fds,2,pending.empty() ? -1 : int(QuietTimeMs));
+    if(ret<0)
+      continue;
+    if(fds[1].revents & POLLIN)
+      return;
+
+    if(ret>0 && (fds[0].revents & POLLIN)) {
+      readEvents(pending);
+      continue;
+      }
+
+    if(ret==0 && !pending.empty()) {
+      std::sort(pending.begin(),pending.end());
+      pending.erase(std::unique(pending.begin(),pending.end()),pending.end());
+      try {
+        cb(std::move(pending));
+        }
+      catch(...) {
+        Log::e("FileWatcher: reload failed");
+        }
+      pending.clear();
+      }
+    }
+  }
+#else
+FileWatcher::FileWatcher(const std::string& root, Callback cb)
+  :root(root), cb(std::move(cb)) {
+  }
+
+FileWatcher::~FileWatcher() {
+  }
+
+bool FileWatcher::isSupported() {
+  return false;
+  }
+
+void FileWatcher::threadFunc() {
+  }
+
+void FileWatcher::addWatch(const std::string&) {
+  }
+
+void FileWatcher::readEvents(std::vector<std::string>&) {
+  }
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Tempest/Platform>
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// watches directory tree for modified files; implemented with inotify on linux, no-op elsewhere
+class FileWatcher final {
+  public:
+    // callback is called from watcher thread with paths relative to root, after changes settled
+    using Callback = std::function<void(std::vector<std::string>&& changed)>;
+
+    FileWatcher(const std::string& root, Callback cb);
+    ~FileWatcher();
+
+    static bool isSupported();
+
+  private:
+    enum { QuietTimeMs = 100 };
+
+    void        threadFunc();
+    void        addWatch(const std::string& rel);
+    void        readEvents(std::vector<std::string>& pending);
+
+    std::string                          root;
+    Callback                             cb;
+    int                                  fd    = -1;
+    int                                  stopFd= -1;
+    std::unordered_map<int,std::string>  dirs;
+    std::thread                          th;
+  };
+
+}
+}
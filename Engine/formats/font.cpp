@@ -4,6 +4,7 @@
 #include <Tempest/Painter>
 #include <Tempest/Platform>
 #include <Tempest/Log>
+#include <Tempest/Profiler>
 #include "../utility/utf8_helper.h"
 #include "thirdparty/stb_truetype.h"
 
@@ -116,23 +117,27 @@ struct FontElement::Impl {
     if(filename==nullptr)
       return;
 
-    RFile file(filename);
-    size = uint32_t(file.size());
-    data = new uint8_t[size];
+    // stb_truetype parses font in place, so mapping is shared with page cache, instead of private copy
+    file.reset(new MappedFile(filename));
+    size = uint32_t(file->size());
+    data = file->data();
 
-    if(file.read(data,size)!=size) {
-      delete[] data;
+    if(data==nullptr || stbtt_InitFont(&info,data,0)==0)
       throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
-      }
-    if(stbtt_InitFont(&info,data,0)==0) {
-      delete[] data;
+    stbtt_GetFontVMetrics(&info,&metrics0.ascent,&metrics0.descent,&lineGap);
+    }
+
+  explicit Impl(IDevice& input) {
+    size = uint32_t(input.size());
+    own.reset(new uint8_t[size]);
+    data = own.get();
+
+    if(input.read(own.get(),size)!=size || stbtt_InitFont(&info,data,0)==0)
       throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
-      }
     stbtt_GetFontVMetrics(&info,&metrics0.ascent,&metrics0.descent,&lineGap);
     }
 
   ~Impl() {
-    delete[] data;
     std::free(rasterBuf);
     }
 
@@ -216,6 +221,9 @@ struct FontElement::Impl {
 
     Sprite spr;
     if(tex!=nullptr){
+      T_PROFILE_ZONE("Font::rasterize");
+      T_PROFILE_COUNTER(glyphs,"glyphs");
+      T_PROFILE_ADD(glyphs,1);
       std::lock_guard<std::mutex> guard(syncMem);
       uint8_t* bitmap=getGlyphBitmapSubpixel(&info,scale,index,w,h,dx,dy);
       if(bitmap!=nullptr)
@@ -273,7 +281,9 @@ struct FontElement::Impl {
     return m;
     }
 
-  uint8_t*       data=nullptr;
+  std::unique_ptr<MappedFile> file;
+  std::unique_ptr<uint8_t[]>  own;
+  const uint8_t* data=nullptr;
   uint32_t       size=0;
   stbtt_fontinfo info={};
 
@@ -318,6 +328,10 @@ FontElement::FontElement(const std::u16string& file)
   :FontElement(file.c_str(),std::true_type()) {
   }
 
+FontElement::FontElement(IDevice& input)
+  :ptr(std::make_shared<Impl>(input)) {
+  }
+
 const FontElement::LetterGeometry& FontElement::letterGeometry(char32_t ch, float size) const { //FIXME: UB?
   return reinterpret_cast<const LetterGeometry&>(ptr->letter(ch,size,nullptr));
   }
@@ -375,6 +389,13 @@ Font::Font(const std::u16string &file)
   : Font(file.c_str(),std::true_type()){
   }
 
+Font::Font(IDevice& input)
+  : fnt{{FontElement(input),nullptr},{nullptr,nullptr}}{
+  fnt[1][0]=fnt[0][0];
+  fnt[1][1]=fnt[0][0];
+  fnt[0][1]=fnt[0][0];
+  }
+
 Font::Font(const FontElement& regular, const FontElement& bold,
            const FontElement& italic, const FontElement& boldItalic) {
   fnt[0][0] = regular;
@@ -19,6 +19,7 @@ class FontElement final {
     FontElement(const std::string&    file);
     FontElement(const char16_t*       file);
     FontElement(const std::u16string& file);
+    explicit FontElement(IDevice& input);
 
     class LetterGeometry final {
       public:
@@ -68,6 +69,7 @@ class Font final {
     Font(const std::string&    file);
     Font(const char16_t*       file);
     Font(const std::u16string& file);
+    explicit Font(IDevice& input);
     Font(const FontElement& regular, const FontElement& bold,
          const FontElement& italic,  const FontElement& boldItalic);
 
@@ -209,7 +209,8 @@ uint8_t *PixmapCodecCommon::load(PixmapCodec::Context &ctx, uint32_t &ow, uint32
   }
 
 bool PixmapCodecCommon::save(ODevice &f, const char *ext, const uint8_t* cdata,
-                             size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) const {
+                             size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm,
+                             const Pixmap::SaveOptions& /*opt*/) const {
   (void)dataSz;
 
   int bpp = int(Pixmap::bppForFormat(frm));
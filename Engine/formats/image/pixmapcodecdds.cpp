@@ -1,6 +1,6 @@
 #include "pixmapcodecdds.h"
 
-#include <Tempest/IDevice>
+#include <Tempest/File>
 
 #include <algorithm>
 #include <cstring>
@@ -72,6 +72,12 @@ uint8_t* PixmapCodecDDS::load(PixmapCodec::Context &c, uint32_t &ow, uint32_t &o
     h = std::max<size_t>(1,h/2);
     }
 
+  if(auto m = dynamic_cast<const MappedFile*>(&f)) {
+    // truncated file: fail before allocation
+    if(m->size()-m->cursorPosition()<bufferSize)
+      return nullptr;
+    }
+
   uint8_t* ddsv = reinterpret_cast<uint8_t*>(std::malloc(bufferSize));
   if(!ddsv || f.read(ddsv,bufferSize)!=bufferSize) {
     std::free(ddsv);
@@ -84,6 +90,6 @@ uint8_t* PixmapCodecDDS::load(PixmapCodec::Context &c, uint32_t &ow, uint32_t &o
   }
 
 bool PixmapCodecDDS::save(ODevice &, const char* /*ext*/, const uint8_t *data, size_t dataSz,
-                          uint32_t w, uint32_t h, Pixmap::Format frm) const {
+                          uint32_t w, uint32_t h, Pixmap::Format frm, const Pixmap::SaveOptions& /*opt*/) const {
   return false;
   }
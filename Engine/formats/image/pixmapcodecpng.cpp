@@ -2,24 +2,83 @@
 
 #include <Tempest/IDevice>
 #include <Tempest/ODevice>
+#include <Tempest/File>
+#include <Tempest/Except>
 
 #include <png.h>
+#include <algorithm>
 #include <cstring>
 
 using namespace Tempest;
 
 struct PixmapCodecPng::Impl {
-  IDevice* data = nullptr;
-  uint8_t* out  = nullptr;
+  // libpng asks for a few bytes per call: serve those from a mapping
+  // or from a large staging buffer instead of going to the device each time
+  enum {
+    ChunkSize = 64*1024,
+    RowBatch  = 64,
+    };
+
+  IDevice*       data  = nullptr;
+  uint8_t*       out   = nullptr;
+
+  const uint8_t* src   = nullptr;
+  size_t         avail = 0;
+  size_t         used  = 0;
+  bool           mapped = false;
+  std::unique_ptr<uint8_t[]> chunk;
 
   Impl(IDevice* idev)
     :data(idev) {
+    if(auto m = dynamic_cast<MappedFile*>(idev)) {
+      src    = m->data()+m->cursorPosition();
+      avail  = m->size()-m->cursorPosition();
+      mapped = true;
+      } else {
+      chunk.reset(new uint8_t[ChunkSize]);
+      src = chunk.get();
+      }
     }
 
   ~Impl(){
     std::free(out);
     }
 
+  // give back to device whatever was fetched, but not consumed by libpng
+  void finish() {
+    if(mapped) {
+      if(data->seek(used)!=used)
+        throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+      return;
+      }
+    const size_t left = avail-used;
+    if(left>0 && data->unget(left)!=left)
+      throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+    }
+
+  bool fetch(uint8_t* dst, size_t sz) {
+    while(sz>0) {
+      if(used==avail) {
+        if(mapped)
+          return false;
+        if(sz>=ChunkSize) {
+          // large request: bypass staging
+          return data->read(dst,sz)==sz;
+          }
+        avail = data->read(chunk.get(),ChunkSize);
+        used  = 0;
+        if(avail==0)
+          return false;
+        }
+      const size_t n = std::min(sz,avail-used);
+      std::memcpy(dst,src+used,n);
+      used += n;
+      dst  += n;
+      sz   -= n;
+      }
+    return true;
+    }
+
   bool readPng(png_structp png_ptr, png_infop info_ptr,
                Pixmap::Format& frm, uint32_t& outW, uint32_t& outH, uint32_t& outBpp) {
     if(setjmp(png_jmpbuf(png_ptr))) {
@@ -72,16 +131,23 @@ struct PixmapCodecPng::Impl {
       frm = Pixmap::Format(uint8_t(Pixmap::Format::R16)+uint8_t(frm)-uint8_t(Pixmap::Format::R));
       }
 
-    out = reinterpret_cast<uint8_t*>(malloc(outW*outH*outBpp));
-    png_set_interlace_handling(png_ptr);
+    const size_t stride = size_t(outW)*outBpp;
+    out = reinterpret_cast<uint8_t*>(std::malloc(stride*outH));
+    if(out==nullptr)
+      return false;
+
+    // rows are decoded straight into the final pixel storage
+    const int pass = png_set_interlace_handling(png_ptr);
     png_read_update_info(png_ptr, info_ptr);
 
-    // Based on png_read_image(png_ptr,imgRows)
-    int pass =  png_set_interlace_handling(png_ptr);
-    for(int j = 0; j < pass; j++) {
-      for(uint32_t y=0; y<outH; y++) {
-        png_bytep rp = &out[y*outW*outBpp];
-        png_read_row(png_ptr, rp, nullptr);
+    png_bytep rows[RowBatch];
+    for(int j=0; j<pass; ++j) {
+      for(uint32_t y=0; y<outH; ) {
+        const uint32_t cnt = std::min<uint32_t>(RowBatch,outH-y);
+        for(uint32_t i=0; i<cnt; ++i)
+          rows[i] = out + (y+i)*stride;
+        png_read_rows(png_ptr, rows, nullptr, cnt);
+        y += cnt;
         }
       }
 
@@ -97,7 +163,7 @@ struct PixmapCodecPng::Impl {
       }
 
     Impl& r = *reinterpret_cast<Impl*>(png_get_io_ptr(png_ptr));
-    if(r.data->read(outBytes, byteCountToRead)!=byteCountToRead) {
+    if(!r.fetch(outBytes, byteCountToRead)) {
       png_error(png_ptr,"unable to read input stream");
       }
     }
@@ -105,7 +171,21 @@ struct PixmapCodecPng::Impl {
 
 static void png_write_data(png_structp png_ptr, png_bytep data, png_size_t length){
   ODevice* f = reinterpret_cast<ODevice*>(png_get_io_ptr(png_ptr));
-  f->write(data, length);
+  if(f->write(data, length)!=length)
+    png_error(png_ptr,"unable to write output stream");
+  }
+
+static int png_filters(Pixmap::Filter f) {
+  switch(f) {
+    case Pixmap::Filter::Default: return -1;
+    case Pixmap::Filter::None:    return PNG_FILTER_NONE;
+    case Pixmap::Filter::Sub:     return PNG_FILTER_SUB;
+    case Pixmap::Filter::Up:      return PNG_FILTER_UP;
+    case Pixmap::Filter::SubUp:   return PNG_FILTER_SUB | PNG_FILTER_UP;
+    case Pixmap::Filter::Paeth:   return PNG_FILTER_PAETH;
+    case Pixmap::Filter::All:     return PNG_ALL_FILTERS;
+    }
+  return -1;
   }
 
 static void png_flush(png_structp png_ptr){
@@ -149,16 +229,19 @@ uint8_t* PixmapCodecPng::load(PixmapCodec::Context& c, uint32_t& w, uint32_t& h,
 
   uint8_t* out = nullptr;
   if(readed) {
+    // failed read leaves stream at unknown position: give back only after success
+    r.finish();
     out    = r.out;
     mipCnt = 1;
-    dataSz = w*h*bpp;
+    dataSz = size_t(w)*h*bpp;
     r.out = nullptr;
     }
   return out;
   }
 
 bool PixmapCodecPng::save(ODevice& f, const char* ext, const uint8_t* data,
-                          size_t /*dataSz*/, uint32_t w, uint32_t h, Pixmap::Format frm) const {
+                          size_t /*dataSz*/, uint32_t w, uint32_t h, Pixmap::Format frm,
+                          const Pixmap::SaveOptions& opt) const {
   if(ext!=nullptr && std::strcmp("png",ext)!=0)
     return false;
 
@@ -236,6 +319,12 @@ bool PixmapCodecPng::save(ODevice& f, const char* ext, const uint8_t* data,
 
   png_set_write_fn(png_ptr, &f, png_write_data, png_flush);
 
+  if(opt.compression>=0)
+    png_set_compression_level(png_ptr, std::min(opt.compression,9));
+  const int filters = png_filters(opt.filter);
+  if(filters>=0)
+    png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, filters);
+
   // write header
   png_set_IHDR( png_ptr, info_ptr, w, h,
                 bitDepth,
@@ -253,7 +342,7 @@ bool PixmapCodecPng::save(ODevice& f, const char* ext, const uint8_t* data,
   for(int pass = 0; pass < num_pass; pass++) {
     // Loop through image
     for(uint32_t i=0; i<h; i++) {
-      const png_byte* rp = &data[i*w*bpp];
+      const png_byte* rp = &data[size_t(i)*w*bpp];
       png_write_row(png_ptr, rp);
       }
     }
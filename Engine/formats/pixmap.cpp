@@ -1,10 +1,16 @@
 #include "pixmap.h"
 
 #include <Tempest/File>
+#include <Tempest/BufferedReader>
 #include <Tempest/Except>
 
 #include "pixmapcodec.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <cstring>
 #include <squish.h>
@@ -193,8 +199,14 @@ struct Pixmap::Impl {
            frm==Pixmap::Format::DXT5;
     }
 
-  void save(ODevice& f,const char* ext){
-    PixmapCodec::saveImg(f,ext,data,dataSz,w,h,frm);
+  void save(ODevice& f,const char* ext,const SaveOptions& opt){
+    if(opt.skipAlpha && componentCount(frm)==4) {
+      // RGBA, RGBA16, RGBA32F -> matching RGB format
+      Impl tmp(*this,Format(uint8_t(frm)-1));
+      PixmapCodec::saveImg(f,ext,tmp.data,tmp.dataSz,tmp.w,tmp.h,tmp.frm,opt);
+      return;
+      }
+    PixmapCodec::saveImg(f,ext,data,dataSz,w,h,frm,opt);
     }
 
   static void ddsToRgba(uint8_t* px,const uint8_t* dds,const uint32_t w,const uint32_t h,const int frm,uint8_t bpp) {
@@ -246,26 +258,32 @@ Pixmap::Pixmap(uint32_t w, uint32_t h, Pixmap::Format frm)
   }
 
 Pixmap::Pixmap(const char* path) {
-  RFile f(path);
+  MappedFile f(path);
   impl.reset(new Impl(f));
   }
 
 Pixmap::Pixmap(const std::string &path) {
-  RFile f(path);
+  MappedFile f(path);
   impl.reset(new Impl(f));
   }
 
 Pixmap::Pixmap(const char16_t *path) {
-  RFile f(path);
+  MappedFile f(path);
   impl.reset(new Impl(f));
   }
 
 Pixmap::Pixmap(const std::u16string &path) {
-  RFile f(path);
+  MappedFile f(path);
   impl.reset(new Impl(f));
   }
 
 Pixmap::Pixmap(IDevice &input) {
+  if(auto rf = dynamic_cast<RFile*>(&input)) {
+    // codecs probe and rewind the header, keep it in memory
+    BufferedReader b(*rf);
+    impl.reset(new Impl(b));
+    return;
+    }
   impl.reset(new Impl(input));
   }
 
@@ -292,13 +310,79 @@ Pixmap& Pixmap::operator=(const Pixmap &p) {
 Pixmap::~Pixmap() {
   }
 
+std::vector<Pixmap> Pixmap::loadMany(const std::vector<std::string>& paths) {
+  std::vector<Pixmap> ret(paths.size());
+
+  std::atomic_size_t next{0};
+  std::exception_ptr err;
+  std::mutex         errSync;
+  auto worker = [&]() {
+    while(true) {
+      const size_t i = next.fetch_add(1);
+      if(i>=paths.size())
+        return;
+      try {
+        ret[i] = Pixmap(paths[i]);
+        }
+      catch(...) {
+        std::lock_guard<std::mutex> guard(errSync);
+        if(!err)
+          err = std::current_exception();
+        next.store(paths.size());
+        }
+      }
+    };
+
+  size_t cnt = std::min<size_t>(std::max(1u,std::thread::hardware_concurrency()),paths.size());
+  std::vector<std::thread> th;
+  if(cnt>1)
+    th.reserve(cnt-1);
+  for(size_t i=1;i<cnt;++i)
+    th.emplace_back(worker);
+  worker();
+  for(auto& t:th)
+    t.join();
+
+  if(err)
+    std::rethrow_exception(err);
+  return ret;
+  }
+
+Pixmap::SaveOptions Pixmap::SaveOptions::fast() {
+  SaveOptions opt;
+  opt.compression = 1;
+  opt.filter      = Filter::SubUp;
+  return opt;
+  }
+
 void Pixmap::save(const char *path, const char *ext) const {
   WFile f(path);
   save(f,ext);
   }
 
 void Pixmap::save(ODevice &f, const char *ext) const {
-  impl->save(f,ext);
+  impl->save(f,ext,SaveOptions());
+  }
+
+void Pixmap::save(const char* path, const char* ext, const SaveOptions& opt) const {
+  WFile f(path);
+  save(f,ext,opt);
+  }
+
+void Pixmap::save(ODevice& f, const char* ext, const SaveOptions& opt) const {
+  impl->save(f,ext,opt);
+  }
+
+std::future<void> Pixmap::saveAsync(Pixmap&& px, std::string path, const char* ext) {
+  return saveAsync(std::move(px),std::move(path),ext,SaveOptions());
+  }
+
+std::future<void> Pixmap::saveAsync(Pixmap&& px, std::string path, const char* ext, const SaveOptions& opt) {
+  const bool  hasExt = ext!=nullptr;
+  std::string e      = hasExt ? ext : "";
+  return std::async(std::launch::async,[px=std::move(px),path=std::move(path),e=std::move(e),hasExt,opt]() {
+    px.save(path.c_str(),hasExt ? e.c_str() : nullptr,opt);
+    });
   }
 
 uint32_t Pixmap::w() const {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <future>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <Tempest/AbstractGraphicsApi>
 
@@ -30,6 +32,25 @@ class Pixmap final {
       DXT5    = 14,
       };
 
+    enum class Filter : uint8_t {
+      Default = 0,
+      None    = 1,
+      Sub     = 2,
+      Up      = 3,
+      SubUp   = 4,
+      Paeth   = 5,
+      All     = 6,
+      };
+
+    struct SaveOptions {
+      int    compression = -1;  // zlib level 0..9, -1 - codec default
+      Filter filter      = Filter::Default;
+      bool   skipAlpha   = false;
+
+      // fast encode for screenshots and captures: level 1, SUB/UP filters
+      static SaveOptions fast();
+      };
+
     Pixmap();
     Pixmap(const Pixmap& src,Format conv);
     Pixmap(uint32_t w,uint32_t h,Format frm);
@@ -46,8 +67,17 @@ class Pixmap final {
 
     ~Pixmap();
 
+    // decode independent images in parallel, result is in the same order as paths
+    static std::vector<Pixmap> loadMany(const std::vector<std::string>& paths);
+
     void        save(const char* path, const char* ext=nullptr) const;
     void        save(ODevice&    fout, const char *ext=nullptr) const;
+    void        save(const char* path, const char* ext, const SaveOptions& opt) const;
+    void        save(ODevice&    fout, const char* ext, const SaveOptions& opt) const;
+
+    // encode and write on a worker thread; errors are reported through the future
+    static std::future<void> saveAsync(Pixmap&& px, std::string path, const char* ext=nullptr);
+    static std::future<void> saveAsync(Pixmap&& px, std::string path, const char* ext, const SaveOptions& opt);
 
     uint32_t    w()   const;
     uint32_t    h()   const;
@@ -4,9 +4,10 @@
 #include "image/pixmapcodecpng.h"
 #include "image/pixmapcodecdds.h"
 
-#include <Tempest/IDevice>
+#include <Tempest/File>
 #include <Tempest/Except>
 
+#include <algorithm>
 #include <cstring>
 #include <squish.h>
 
@@ -16,6 +17,13 @@ using namespace Tempest;
 
 PixmapCodec::Context::Context(IDevice &dev)
   :device(dev) {
+  if(auto m = dynamic_cast<MappedFile*>(&dev)) {
+    // header is visible in place, no need to read and roll back
+    bufSiz = std::min(sizeof(buf),m->size()-m->cursorPosition());
+    if(bufSiz>0)
+      std::memcpy(buf,m->data()+m->cursorPosition(),bufSiz);
+    return;
+    }
   bufSiz = dev.read(buf,sizeof(buf));
   if(dev.unget(bufSiz)!=bufSiz)
     throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
@@ -49,29 +57,31 @@ struct PixmapCodec::Impl {
     throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
     }
 
-  void implSave(ODevice &f, char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) {
+  void implSave(ODevice &f, char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm,
+                const Pixmap::SaveOptions& opt) {
     if(ext!=nullptr) {
       for(size_t i=0;ext[i];++i)
         if('A'<=ext[i] && ext[i]<='Z')
           ext[i] = ext[i]+'a'-'A';
 
       for(auto& i:codec) {
-        if(i->save(f,ext,data,dataSz,w,h,frm))
+        if(i->save(f,ext,data,dataSz,w,h,frm,opt))
           return;
         }
       }
 
     for(auto& i:codec) {
-      if(i->save(f,nullptr,data,dataSz,w,h,frm))
+      if(i->save(f,nullptr,data,dataSz,w,h,frm,opt))
         return;
       }
 
     throw std::system_error(Tempest::SystemErrc::UnableToSaveAsset);
     }
 
-  void save(ODevice &f, const char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) {
+  void save(ODevice &f, const char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm,
+            const Pixmap::SaveOptions& opt) {
     if(ext==nullptr) {
-      implSave(f,nullptr,data,dataSz,w,h,frm);
+      implSave(f,nullptr,data,dataSz,w,h,frm,opt);
       return;
       }
 
@@ -79,11 +89,11 @@ struct PixmapCodec::Impl {
     if(extL<32) {
       char e[33]={};
       std::memcpy(e,ext,extL);
-      implSave(f,e,data,dataSz,w,h,frm);
+      implSave(f,e,data,dataSz,w,h,frm,opt);
       } else {
       std::unique_ptr<char[]> e(new char[extL+1]);
       std::memcpy(e.get(),ext,extL);
-      implSave(f,e.get(),data,dataSz,w,h,frm);
+      implSave(f,e.get(),data,dataSz,w,h,frm,opt);
       }
     }
 
@@ -99,8 +109,9 @@ uint8_t* PixmapCodec::loadImg(IDevice &f, uint32_t &w, uint32_t &h, Pixmap::Form
   return instance().load(f,w,h,frm,mipCnt,bpp,dataSz);
   }
 
-void PixmapCodec::saveImg(ODevice &f, const char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) {
-  instance().save(f,ext,data,dataSz,w,h,frm);
+void PixmapCodec::saveImg(ODevice &f, const char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm,
+                          const Pixmap::SaveOptions& opt) {
+  instance().save(f,ext,data,dataSz,w,h,frm,opt);
   }
 
 void PixmapCodec::freeImg(uint8_t *px) {
@@ -28,14 +28,16 @@ class PixmapCodec {
       };
 
     static uint8_t*  loadImg (IDevice& f, uint32_t& w, uint32_t& h, Pixmap::Format& frm, uint32_t& mipCnt, uint32_t &bpp, size_t& dataSz);
-    static void      saveImg (ODevice& f, const char* ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm);
+    static void      saveImg (ODevice& f, const char* ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm,
+                              const Pixmap::SaveOptions& opt);
 
     static void      freeImg (uint8_t* px);
 
   protected:
     virtual bool     testFormat(const Context& c) const = 0;
     virtual uint8_t* load(PixmapCodec::Context &c,uint32_t& w,uint32_t& h,Pixmap::Format& frm,uint32_t& mipCnt,size_t& dataSz,uint32_t& bpp) const = 0;
-    virtual bool     save(ODevice& f,const char* ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) const = 0;
+    virtual bool     save(ODevice& f,const char* ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm,
+                          const Pixmap::SaveOptions& opt) const = 0;
 
   private:
     struct Impl;
@@ -166,6 +166,52 @@ namespace Tempest {
       }
     };
 
+  enum class QueryType : uint8_t {
+    Timestamp,
+    PipelineStatistics,
+    };
+
+  // counters collected by pipeline-statistics query, in this order
+  struct PipelineStatistics final {
+    uint64_t inputVertices       = 0;
+    uint64_t inputPrimitives     = 0;
+    uint64_t vertexInvocations   = 0;
+    uint64_t clippingInvocations = 0;
+    uint64_t clippingPrimitives  = 0;
+    uint64_t fragmentInvocations = 0;
+    uint64_t computeInvocations  = 0;
+
+    static const uint32_t count = 7;
+    };
+
+  // device memory, as seen by engine allocator
+  struct MemoryStats final {
+    struct Usage {
+      uint64_t used        = 0; // bytes in live allocations
+      uint64_t reserved    = 0; // bytes of device memory owned by allocator
+      uint64_t largestFree = 0; // largest free block inside of reserved memory
+      uint32_t pages       = 0; // device memory objects, dedicated ones included
+      uint32_t dedicated   = 0;
+      uint32_t allocations = 0;
+      };
+
+    struct Heap : Usage {
+      uint64_t size        = 0;
+      uint64_t budget      = 0; // driver budget, if known; heap size otherwise
+      uint64_t usage       = 0; // process usage reported by driver; 0, if unknown
+      bool     deviceLocal = false;
+      };
+
+    struct Type : Usage {
+      uint32_t heap        = 0;
+      bool     deviceLocal = false;
+      bool     hostVisible = false;
+      };
+
+    std::vector<Heap> heaps;
+    std::vector<Type> types;
+    };
+
   namespace Detail {
     enum class IndexClass:uint8_t {
       i16=0,
@@ -181,6 +227,7 @@ namespace Tempest {
     inline IndexClass indexCls<uint32_t>() { return IndexClass::i32; }
 
     class ResourceState;
+    class GpuProfiler;
     }
 
   class AbstractGraphicsApi {
@@ -230,6 +277,11 @@ namespace Tempest {
             BasicPoint<int,3> maxGroupSize = {128,128,64};
             } compute;
 
+          struct {
+            double timestampPeriod    = 0;     // nanoseconds per tick; 0 - timestamps are not supported
+            bool   pipelineStatistics = false;
+            } query;
+
           bool     anisotropy=false;
           float    maxAnisotropy=1.0f;
 
@@ -261,6 +313,7 @@ namespace Tempest {
 
       struct Shared:NoCopy {
         std::atomic_uint_fast32_t counter{0};
+        Detail::Retirer*          retirer=nullptr;
         };
 
       struct Device:NoCopy {
@@ -306,6 +359,12 @@ namespace Tempest {
       struct CompPipeline:Shared {};
       struct Shader:Shared   {};
       struct Uniforms        {};
+      struct QueryPool:NoCopy {
+        virtual ~QueryPool()=default;
+        // non-blocking: false, if any of queries is not available yet
+        // pipeline-statistics query writes PipelineStatistics::count values
+        virtual bool results(uint32_t first, uint32_t count, uint64_t* out)=0;
+        };
       struct UniformsLay:Shared {
         virtual ~UniformsLay()=default;
         };
@@ -353,6 +412,12 @@ namespace Tempest {
         virtual void draw        (size_t offset,size_t vertexCount)=0;
         virtual void drawIndexed (size_t ioffset, size_t isize, size_t voffset)=0;
         virtual void dispatch    (size_t x, size_t y, size_t z)=0;
+
+        // queries must be reset outside of render pass, before use
+        virtual void resetQueries  (QueryPool& /*pool*/, uint32_t /*first*/, uint32_t /*count*/) {}
+        virtual void writeTimestamp(QueryPool& /*pool*/, uint32_t /*id*/) {}
+        virtual void beginQuery    (QueryPool& /*pool*/, uint32_t /*id*/) {}
+        virtual void endQuery      (QueryPool& /*pool*/, uint32_t /*id*/) {}
         };
 
       using PBuffer       = Detail::DSharedPtr<Buffer*>;
@@ -398,6 +463,9 @@ namespace Tempest {
 
       virtual Semaphore* createSemaphore(Device *d)=0;
 
+      // nullptr, if query type is not supported by backend
+      virtual QueryPool* createQueryPool(Device* /*d*/, QueryType /*type*/, uint32_t /*count*/) { return nullptr; }
+
       virtual CommandBuffer*
                          createCommandBuffer(Device* d)=0;
 
@@ -422,7 +490,12 @@ namespace Tempest {
                                    Fence* doneCpu)=0;
 
       virtual void       getCaps  (Device *d,Props& caps)=0;
+      // left empty, if backend keeps no statistics
+      virtual void       memoryStats(Device* /*d*/, MemoryStats& /*out*/) {}
+      // moves resources out of sparse memory pages; returns number of bytes moved
+      virtual size_t     defragment (Device* /*d*/, size_t /*maxBytes*/) { return 0; }
 
     friend class Tempest::Device;
+    friend class Tempest::Detail::GpuProfiler;
     };
 }
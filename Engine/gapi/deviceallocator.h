@@ -4,6 +4,7 @@
 #include <forward_list>
 #include <mutex>
 #include <algorithm>
+#include <vector>
 
 namespace Tempest {
 namespace Detail {
@@ -17,6 +18,7 @@ class DeviceAllocator {
       DEFAULT_PAGE_SIZE=128*1024*1024
       };
     using Memory=typename MemoryProvider::DeviceMemory;
+    using PageRef=const Page*;
     static const constexpr Memory null=Memory{};
 
     explicit DeviceAllocator(MemoryProvider& device):device(device){}
@@ -33,6 +35,15 @@ class DeviceAllocator {
       size_t offset=0,size=0;
       };
 
+    struct Stats {
+      uint64_t used       =0;
+      uint64_t reserved   =0;
+      uint64_t largestFree=0;
+      uint32_t pages      =0;
+      uint32_t dedicated  =0;
+      uint32_t allocations=0;
+      };
+
     Allocation alloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId) {
       std::lock_guard<std::mutex> guard(sync);
       for(auto& i:pages){
@@ -57,8 +68,9 @@ class DeviceAllocator {
     Allocation dedicatedAlloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId) {
       std::lock_guard<std::mutex> guard(sync);
       Page pg(static_cast<uint32_t>(size));
-      pg.memory = device.alloc(pg.allSize,typeId);
-      pg.type   = heapId;
+      pg.memory    = device.alloc(pg.allSize,typeId);
+      pg.type      = heapId;
+      pg.dedicated = true;
       if(pg.memory==null)
         return Allocation();
       try {
@@ -72,6 +84,54 @@ class DeviceAllocator {
       return pages.front().alloc(size,align,device);
       }
 
+    // statistics of all pages, indexed by heapId
+    void stats(std::vector<Stats>& out) {
+      std::lock_guard<std::mutex> guard(sync);
+      for(auto& i:pages) {
+        if(out.size()<=i.type)
+          out.resize(i.type+1);
+        Stats& st = out[i.type];
+        st.used        += i.allocated;
+        st.reserved    += i.allSize;
+        st.largestFree  = std::max<uint64_t>(st.largestFree,i.largestFree());
+        st.pages       += 1;
+        st.dedicated   += i.dedicated ? 1 : 0;
+        st.allocations += i.count;
+        }
+      }
+
+    // non-dedicated pages, used below maxUsage, which content fits into other pages of same heap; sparsest first
+    void sparsePages(std::vector<PageRef>& out, float maxUsage) {
+      std::lock_guard<std::mutex> guard(sync);
+      for(auto& i:pages) {
+        if(i.dedicated || double(i.allocated)>=double(i.allSize)*double(maxUsage))
+          continue;
+        uint64_t room=0;
+        for(auto& r:pages)
+          if(&r!=&i && r.type==i.type && !r.dedicated)
+            room += r.allSize-r.allocated;
+        if(room>=i.allocated)
+          out.push_back(&i);
+        }
+      std::sort(out.begin(),out.end(),[](PageRef a,PageRef b){ return a->allocated<b->allocated; });
+      }
+
+    // allocates from existing pages only, fullest first, never from except
+    Allocation allocExcept(size_t size, size_t align, uint32_t heapId, PageRef except) {
+      std::lock_guard<std::mutex> guard(sync);
+      std::vector<Page*> dst;
+      for(auto& i:pages)
+        if(&i!=except && i.type==heapId && !i.dedicated && i.allocated+size<=i.allSize)
+          dst.push_back(&i);
+      std::sort(dst.begin(),dst.end(),[](const Page* a,const Page* b){ return a->allocated>b->allocated; });
+      for(auto i:dst) {
+        auto ret=i->alloc(size,align,device);
+        if(ret.page!=nullptr)
+          return ret;
+        }
+      return Allocation();
+      }
+
   private:
     Allocation rawAlloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId){
       Page pg(std::max<uint32_t>(DEFAULT_PAGE_SIZE,uint32_t(size)));
@@ -117,6 +177,8 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
   uint32_t   type   =0;
   uint32_t   allSize=0;
   uint32_t   allocated=0;
+  uint32_t   count  =0;
+  bool       dedicated=false;
 
   Page(uint32_t sz) noexcept {
     size   =sz;
@@ -130,6 +192,7 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
     std::swap(memory,p.memory);
     type=p.type;
     allSize=p.allSize;
+    dedicated=p.dedicated;
     }
 
   ~Page(){
@@ -148,6 +211,7 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
     std::swap(memory,p.memory);
     type=p.type;
     allSize=p.allSize;
+    dedicated=p.dedicated;
     return *this;
     }
 
@@ -155,6 +219,13 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
     return memory==other.memory;
     }
 
+  uint32_t largestFree() const noexcept {
+    uint32_t ret=0;
+    for(const Block* b=this;b!=nullptr;b=b->next)
+      ret = std::max(ret,b->size);
+    return ret;
+    }
+
   Allocation alloc(size_t size,size_t align,MemoryProvider& /*prov*/) noexcept {
     Block*   b=this;
     while(b!=nullptr) {
@@ -195,6 +266,7 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
     b.offset +=uint32_t(size);
     b.size   -=uint32_t(size);
     allocated+=uint32_t(size);
+    count++;
     return a;
     }
 
@@ -208,11 +280,13 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
     b.offset +=sz;
     b.size   -=sz;
     allocated+=uint32_t(size);
+    count++;
     return a;
     }
 
   void free(const Allocation& a) noexcept {
     allocated -= uint32_t(a.size);
+    count--;
 
     Block* b=this;
     while(b!=nullptr && (b->offset+b->size)<a.offset)
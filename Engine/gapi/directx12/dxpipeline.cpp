@@ -110,8 +110,8 @@ D3D12_BLEND_DESC DxPipeline::getBlend(const RenderState& st) const {
   b.SrcBlend              = blendMode[size_t(st.blendSource())];
   b.DestBlend             = blendMode[size_t(st.blendDest())];
   b.BlendOp               = D3D12_BLEND_OP_ADD;
-  b.SrcBlendAlpha         = b.SrcBlend;
-  b.DestBlendAlpha        = b.DestBlend;
+  b.SrcBlendAlpha         = blendMode[size_t(st.blendAlphaSource())];
+  b.DestBlendAlpha        = blendMode[size_t(st.blendAlphaDest())];
   b.BlendOpAlpha          = D3D12_BLEND_OP_ADD;
   b.LogicOpEnable         = FALSE;
   b.LogicOp               = D3D12_LOGIC_OP_CLEAR;
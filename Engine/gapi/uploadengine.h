@@ -2,6 +2,7 @@
 
 #include <Tempest/AbstractGraphicsApi>
 #include <Tempest/Log>
+#include <Tempest/Profiler>
 
 #include <cstdlib>
 #include <cstdint>
@@ -103,6 +104,8 @@ void UploadEngine<Device,CommandBuffer,Fence>::wait() {
 
 template<class Device, class CommandBuffer, class Fence>
 void UploadEngine<Device,CommandBuffer,Fence>::submit(std::unique_ptr<Commands>&& cmd) {
+  T_PROFILE_COUNTER(uploads,"uploads");
+  T_PROFILE_ADD(uploads,1);
   device.submit(*cmd,cmd->fence);
 
   std::lock_guard<SpinLock> guard(sync);
@@ -112,6 +115,9 @@ void UploadEngine<Device,CommandBuffer,Fence>::submit(std::unique_ptr<Commands>&
 
 template<class Device, class CommandBuffer, class Fence>
 void UploadEngine<Device,CommandBuffer,Fence>::submitAndWait(std::unique_ptr<Commands>&& cmd) {
+  T_PROFILE_ZONE("UploadEngine::submitAndWait");
+  T_PROFILE_COUNTER(uploads,"uploads");
+  T_PROFILE_ADD(uploads,1);
   device.submit(*cmd,cmd->fence);
   cmd->fence.wait();
   cmd->reset();
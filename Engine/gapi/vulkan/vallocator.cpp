@@ -3,18 +3,38 @@
 #include "vdevice.h"
 #include "vbuffer.h"
 #include "vtexture.h"
+#include "vdescriptorarray.h"
 
 #include "exceptions/exception.h"
 
 #include <Tempest/Pixmap>
 #include <Tempest/Log>
+#include <Tempest/Profiler>
 #include <thread>
+#include <algorithm>
 
 #include "gapi/graphicsmemutils.h"
 
 using namespace Tempest;
 using namespace Tempest::Detail;
 
+const uint32_t VAllocator::NoReg;
+
+template<class T>
+void VAllocator::regAdd(std::vector<T*>& reg, T& obj) {
+  reg.push_back(&obj);
+  obj.regId = uint32_t(reg.size()-1);
+  }
+
+template<class T>
+void VAllocator::regRemove(std::vector<T*>& reg, T& obj) {
+  T* last = reg.back();
+  last->regId      = obj.regId;
+  reg[obj.regId]   = last;
+  reg.pop_back();
+  obj.regId = NoReg;
+  }
+
 VAllocator::VAllocator() {
   }
 
@@ -111,6 +131,8 @@ VBuffer VAllocator::alloc(const void *mem, size_t count, size_t size, size_t ali
     createInfo.usage |= VkBufferUsageFlagBits::VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
   vkAssert(vkCreateBuffer(device,&createInfo,nullptr,&ret.impl));
+  ret.size  = createInfo.size;
+  ret.usage = createInfo.usage;
 
   MemRequirements memRq={};
   getMemoryRequirements(memRq,ret.impl);
@@ -175,6 +197,8 @@ VTexture VAllocator::alloc(const Pixmap& pm,uint32_t mip,VkFormat format) {
 
   ret.format   = imageInfo.format;
   ret.mipCount = mip;
+  ret.w        = imageInfo.extent.width;
+  ret.h        = imageInfo.extent.height;
   ret.createViews(device);
   return ret;
   }
@@ -222,11 +246,17 @@ VTexture VAllocator::alloc(const uint32_t w, const uint32_t h, const uint32_t mi
 
   ret.format   = imageInfo.format;
   ret.mipCount = mip;
+  ret.w        = imageInfo.extent.width;
+  ret.h        = imageInfo.extent.height;
   ret.createViews(device);
   return ret;
   }
 
 void VAllocator::free(VBuffer &buf) {
+  if(buf.regId!=NoReg) {
+    std::lock_guard<std::mutex> guard(movableSync);
+    regRemove(movableBuf,buf);
+    }
   if(buf.impl!=VK_NULL_HANDLE)
     vkDestroyBuffer (device,buf.impl,nullptr);
 
@@ -235,6 +265,10 @@ void VAllocator::free(VBuffer &buf) {
   }
 
 void VAllocator::free(VTexture &buf) {
+  if(buf.regId!=NoReg) {
+    std::lock_guard<std::mutex> guard(movableSync);
+    regRemove(movableTex,buf);
+    }
   if(buf.view!=VK_NULL_HANDLE) {
     buf.destroyViews(device);
     vkDestroyImage  (device,buf.impl,nullptr);
@@ -312,6 +346,8 @@ void VAllocator::getImgMemoryRequirements(MemRequirements& out, VkImage img) {
   }
 
 VAllocator::Allocation VAllocator::allocMemory(const VAllocator::MemRequirements& memRq, const uint32_t heapId, const uint32_t typeId) {
+  T_PROFILE_COUNTER(allocations,"allocations");
+  T_PROFILE_ADD(allocations,1);
   const size_t align = LCM(memRq.alignment,provider.device->props.nonCoherentAtomSize);
   Allocation ret;
   if(memRq.dedicated) {
@@ -324,6 +360,195 @@ VAllocator::Allocation VAllocator::allocMemory(const VAllocator::MemRequirements
   return ret;
   }
 
+bool VAllocator::realloc(VBuffer& dest, const VBuffer& src, PageRef except) {
+  dest.alloc = this;
+
+  VkBufferCreateInfo createInfo={};
+  createInfo.sType       = VkStructureType::VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.size        = src.size;
+  createInfo.usage       = src.usage;
+  createInfo.sharingMode = VkSharingMode::VK_SHARING_MODE_EXCLUSIVE;
+  vkAssert(vkCreateBuffer(device,&createInfo,nullptr,&dest.impl));
+  dest.size  = src.size;
+  dest.usage = src.usage;
+
+  MemRequirements memRq={};
+  getMemoryRequirements(memRq,dest.impl);
+  if(memRq.dedicated)
+    return false;
+
+  VDevice::MemIndex memId = provider.device->memoryTypeIndex(memRq.memoryTypeBits,VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,VK_IMAGE_TILING_LINEAR);
+  const size_t      align = LCM(memRq.alignment,provider.device->props.nonCoherentAtomSize);
+  dest.page = allocator.allocExcept(memRq.size,align,memId.heapId,except);
+  if(!dest.page.page)
+    return false;
+  return commit(dest.page.page->memory,dest.page.page->mmapSync,dest.impl,dest.page.offset,nullptr,0,0,0);
+  }
+
+bool VAllocator::realloc(VTexture& dest, const VTexture& src, PageRef except) {
+  dest.alloc = this;
+
+  VkImageCreateInfo imageInfo = {};
+  imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width  = src.w;
+  imageInfo.extent.height = src.h;
+  imageInfo.extent.depth  = 1;
+  imageInfo.mipLevels     = src.mipCount;
+  imageInfo.arrayLayers   = 1;
+  imageInfo.format        = src.format;
+  imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  vkAssert(vkCreateImage(device, &imageInfo, nullptr, &dest.impl));
+  dest.format   = src.format;
+  dest.mipCount = src.mipCount;
+  dest.w        = src.w;
+  dest.h        = src.h;
+
+  MemRequirements memRq={};
+  getImgMemoryRequirements(memRq,dest.impl);
+  if(memRq.dedicated)
+    return false;
+
+  VDevice::MemIndex memId = provider.device->memoryTypeIndex(memRq.memoryTypeBits,VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,VK_IMAGE_TILING_OPTIMAL);
+  const size_t      align = LCM(memRq.alignment,provider.device->props.nonCoherentAtomSize);
+  dest.page = allocator.allocExcept(memRq.size,align,memId.heapId,except);
+  if(!dest.page.page)
+    return false;
+  if(!commit(dest.page.page->memory,dest.page.page->mmapSync,dest.impl,dest.page.offset))
+    return false;
+  dest.createViews(device);
+  return true;
+  }
+
+void VAllocator::setMovable(VBuffer& buf) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  regAdd(movableBuf,buf);
+  }
+
+void VAllocator::setMovable(VTexture& tex) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  regAdd(movableTex,tex);
+  }
+
+void VAllocator::relink(VBuffer& buf) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  movableBuf[buf.regId] = &buf;
+  }
+
+void VAllocator::relink(VTexture& tex) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  movableTex[tex.regId] = &tex;
+  }
+
+void VAllocator::track(VDescriptorArray& d) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  regAdd(descArrays,d);
+  }
+
+void VAllocator::untrack(VDescriptorArray& d) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  regRemove(descArrays,d);
+  }
+
+size_t VAllocator::defragment(size_t maxBytes) {
+  if(maxBytes==0)
+    return 0;
+
+  std::vector<PageRef> sparse;
+  allocator.sparsePages(sparse,0.5f);
+
+  PageRef page = nullptr;
+  {
+  std::lock_guard<std::mutex> guard(movableSync);
+  for(auto pg:sparse) {
+    if(std::any_of(movableBuf.begin(),movableBuf.end(),[pg](const VBuffer*  b){ return b->page.page==pg; }) ||
+       std::any_of(movableTex.begin(),movableTex.end(),[pg](const VTexture* t){ return t->page.page==pg; })) {
+      page = pg;
+      break;
+      }
+    }
+  }
+  if(page==nullptr)
+    return 0;
+
+  std::lock_guard<std::mutex> guard(movableSync);
+  std::vector<std::pair<VBuffer*, VBuffer>>  buf;
+  std::vector<std::pair<VTexture*,VTexture>> tex;
+  for(auto i:movableBuf)
+    if(i->page.page==page)
+      buf.emplace_back(i,VBuffer());
+  for(auto i:movableTex)
+    if(i->page.page==page)
+      tex.emplace_back(i,VTexture());
+
+  // allocate replacements first: no need to stall gpu, if there is no room
+  size_t bytes = 0;
+  size_t nBuf  = 0;
+  size_t nTex  = 0;
+  for(;nBuf<buf.size() && bytes<maxBytes;++nBuf) {
+    auto& b = buf[nBuf];
+    if(!realloc(b.second,*b.first,page))
+      break;
+    bytes += b.first->page.size;
+    }
+  for(;nTex<tex.size() && bytes<maxBytes;++nTex) {
+    auto& t = tex[nTex];
+    if(!realloc(t.second,*t.first,page))
+      break;
+    bytes += t.first->page.size;
+    }
+  buf.resize(nBuf);
+  tex.resize(nTex);
+  if(buf.empty() && tex.empty())
+    return 0;
+
+  // moved resources and descriptor sets, that reference them, must not be in use by gpu
+  VDevice& dev = *provider.device;
+  dev.waitIdle();
+  dev.waitData();
+  auto cmd = dev.dataMgr().get();
+
+  cmd->begin();
+  for(auto& b:buf)
+    cmd->copy(b.second,0,*b.first,0,size_t(b.first->size));
+  for(auto& t:tex) {
+    cmd->changeLayout(*t.first, TextureLayout::Sampler,     TextureLayout::TransferSrc, uint32_t(-1));
+    cmd->changeLayout(t.second, TextureLayout::Undefined,   TextureLayout::TransferDest,uint32_t(-1));
+    cmd->copy(t.second,*t.first,t.first->w,t.first->h,t.first->mipCount);
+    cmd->changeLayout(t.second, TextureLayout::TransferDest,TextureLayout::Sampler,     uint32_t(-1));
+    }
+  cmd->end();
+  dev.dataMgr().submitAndWait(std::move(cmd));
+
+  std::vector<const void*> moved;
+  for(auto& i:buf) {
+    std::swap(i.first->impl,i.second.impl);
+    std::swap(i.first->page,i.second.page);
+    moved.push_back(i.first);
+    }
+  for(auto& i:tex) {
+    std::lock_guard<Detail::SpinLock> g(i.first->syncViews);
+    std::swap(i.first->impl,    i.second.impl);
+    std::swap(i.first->view,    i.second.view);
+    std::swap(i.first->page,    i.second.page);
+    std::swap(i.first->extViews,i.second.extViews);
+    moved.push_back(i.first);
+    }
+  std::sort(moved.begin(),moved.end());
+  for(auto d:descArrays)
+    d->relocate(moved);
+
+  // release old handles and memory; emptied page goes back to driver
+  buf.clear();
+  tex.clear();
+  provider.freeLast();
+  return bytes;
+  }
+
 void VAllocator::alignRange(VkMappedMemoryRange& rgn, size_t nonCoherentAtomSize, size_t shift) {
   shift = rgn.offset%nonCoherentAtomSize;
   rgn.offset -= shift;
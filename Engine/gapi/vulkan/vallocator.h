@@ -11,6 +11,7 @@ namespace Detail {
 class VDevice;
 class VBuffer;
 class VTexture;
+class VDescriptorArray;
 
 class VAllocator {
   private:
@@ -43,6 +44,9 @@ class VAllocator {
     void setDevice(VDevice& device);
 
     using Allocation=typename Tempest::Detail::DeviceAllocator<Provider>::Allocation;
+    using Stats     =typename Tempest::Detail::DeviceAllocator<Provider>::Stats;
+
+    static const uint32_t NoReg = uint32_t(-1);
 
     VBuffer  alloc(const void *mem, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap bufHeap);
     VTexture alloc(const Pixmap &pm, uint32_t mip, VkFormat format);
@@ -58,18 +62,48 @@ class VAllocator {
 
     void     updateSampler(VkSampler& smp, const Sampler2d& s, uint32_t mipCount);
 
+    // indexed by VDevice::MemIndex::heapId
+    void     stats(std::vector<Stats>& out) { allocator.stats(out); }
+
+    // device-local buffers and sampled textures, that defragment may move to other page
+    void     setMovable(VBuffer&  buf);
+    void     setMovable(VTexture& tex);
+    // registered handle object was moved: point registry to new location
+    void     relink(VBuffer&  buf);
+    void     relink(VTexture& tex);
+    // descriptor sets to patch, when resources are moved
+    void     track  (VDescriptorArray& d);
+    void     untrack(VDescriptorArray& d);
+    // moves live resources out of sparsest page, about maxBytes per call; waits for device idle, if anything is moved
+    size_t   defragment(size_t maxBytes);
+
   private:
     VkDevice                          device=nullptr;
     Provider                          provider;
     VSamplerCache                     samplers;
     Detail::DeviceAllocator<Provider> allocator{provider};
 
+    using PageRef = Detail::DeviceAllocator<Provider>::PageRef;
+
+    std::mutex                        movableSync;
+    std::vector<VBuffer*>             movableBuf;
+    std::vector<VTexture*>            movableTex;
+    std::vector<VDescriptorArray*>    descArrays;
+
     void getMemoryRequirements   (MemRequirements& out, VkBuffer buf);
     void getImgMemoryRequirements(MemRequirements& out, VkImage  img);
     void alignRange(VkMappedMemoryRange& rgn, size_t nonCoherentAtomSize, size_t shift);
 
     Allocation allocMemory(const MemRequirements& rq, const uint32_t heapId, const uint32_t typeId);
 
+    bool realloc(VBuffer&  dest, const VBuffer&  src, PageRef except);
+    bool realloc(VTexture& dest, const VTexture& src, PageRef except);
+
+    template<class T>
+    static void regAdd   (std::vector<T*>& reg, T& obj);
+    template<class T>
+    static void regRemove(std::vector<T*>& reg, T& obj);
+
     bool commit(VkDeviceMemory dev, std::mutex& mmapSync, VkBuffer dest, size_t offset,
                 const void *mem, size_t count, size_t size, size_t alignedSz);
     bool commit(VkDeviceMemory dev, std::mutex& mmapSync, VkImage  dest, size_t offset);
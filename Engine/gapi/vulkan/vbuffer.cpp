@@ -11,6 +11,11 @@ VBuffer::VBuffer(VBuffer &&other) {
   std::swap(impl, other.impl);
   std::swap(alloc,other.alloc);
   std::swap(page, other.page);
+  std::swap(size, other.size);
+  std::swap(usage,other.usage);
+  std::swap(regId,other.regId);
+  if(regId!=VAllocator::NoReg)
+    alloc->relink(*this);
   }
 
 VBuffer::~VBuffer() {
@@ -22,6 +27,13 @@ VBuffer& VBuffer::operator=(VBuffer&& other) {
   std::swap(impl, other.impl);
   std::swap(alloc,other.alloc);
   std::swap(page, other.page);
+  std::swap(size, other.size);
+  std::swap(usage,other.usage);
+  std::swap(regId,other.regId);
+  if(regId!=VAllocator::NoReg)
+    alloc->relink(*this);
+  if(other.regId!=VAllocator::NoReg)
+    other.alloc->relink(other);
   return *this;
   }
 
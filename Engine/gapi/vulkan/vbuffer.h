@@ -24,6 +24,9 @@ class VBuffer : public AbstractGraphicsApi::Buffer {
   private:
     VAllocator*            alloc=nullptr;
     VAllocator::Allocation page={};
+    VkDeviceSize           size =0;
+    VkBufferUsageFlags     usage=0;
+    uint32_t               regId=VAllocator::NoReg;
 
   friend class VAllocator;
   };
@@ -10,6 +10,7 @@
 #include "vdescriptorarray.h"
 #include "vswapchain.h"
 #include "vtexture.h"
+#include "vquerypool.h"
 
 using namespace Tempest;
 using namespace Tempest::Detail;
@@ -173,6 +174,26 @@ void VCommandBuffer::dispatch(size_t x, size_t y, size_t z) {
   vkCmdDispatch(impl,uint32_t(x),uint32_t(y),uint32_t(z));
   }
 
+void VCommandBuffer::resetQueries(AbstractGraphicsApi::QueryPool& pool, uint32_t first, uint32_t count) {
+  auto& p = reinterpret_cast<VQueryPool&>(pool);
+  vkCmdResetQueryPool(impl,p.impl,first,count);
+  }
+
+void VCommandBuffer::writeTimestamp(AbstractGraphicsApi::QueryPool& pool, uint32_t id) {
+  auto& p = reinterpret_cast<VQueryPool&>(pool);
+  vkCmdWriteTimestamp(impl,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,p.impl,id);
+  }
+
+void VCommandBuffer::beginQuery(AbstractGraphicsApi::QueryPool& pool, uint32_t id) {
+  auto& p = reinterpret_cast<VQueryPool&>(pool);
+  vkCmdBeginQuery(impl,p.impl,id,0);
+  }
+
+void VCommandBuffer::endQuery(AbstractGraphicsApi::QueryPool& pool, uint32_t id) {
+  auto& p = reinterpret_cast<VQueryPool&>(pool);
+  vkCmdEndQuery(impl,p.impl,id);
+  }
+
 void VCommandBuffer::setVbo(const Tempest::AbstractGraphicsApi::Buffer &b) {
   const VBuffer& vbo=reinterpret_cast<const VBuffer&>(b);
 
@@ -260,6 +281,26 @@ void VCommandBuffer::copy(AbstractGraphicsApi::Buffer& dstBuf, size_t width, siz
   vkCmdCopyImageToBuffer(impl, src.impl, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst.impl, 1, &region);
   }
 
+void VCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, const AbstractGraphicsApi::Texture& srcTex, uint32_t width, uint32_t height, uint32_t mipCount) {
+  auto& src = reinterpret_cast<const VTexture&>(srcTex);
+  auto& dst = reinterpret_cast<VTexture&>(dstTex);
+
+  for(uint32_t mip=0; mip<mipCount; ++mip) {
+    VkImageCopy region = {};
+    region.srcSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.mipLevel       = mip;
+    region.srcSubresource.baseArrayLayer = 0;
+    region.srcSubresource.layerCount     = 1;
+    region.dstSubresource                = region.srcSubresource;
+    region.extent = {
+        std::max<uint32_t>(1,width >>mip),
+        std::max<uint32_t>(1,height>>mip),
+        1
+    };
+    vkCmdCopyImage(impl, src.impl, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst.impl, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+  }
+
 void VCommandBuffer::blit(AbstractGraphicsApi::Texture& srcTex, uint32_t srcW, uint32_t srcH, uint32_t srcMip,
                           AbstractGraphicsApi::Texture& dstTex, uint32_t dstW, uint32_t dstH, uint32_t dstMip) {
   auto& src = reinterpret_cast<VTexture&>(srcTex);
@@ -72,6 +72,11 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void drawIndexed(size_t ioffset, size_t isize, size_t voffset) override;
     void dispatch(size_t x, size_t y, size_t z) override;
 
+    void resetQueries  (AbstractGraphicsApi::QueryPool& pool, uint32_t first, uint32_t count) override;
+    void writeTimestamp(AbstractGraphicsApi::QueryPool& pool, uint32_t id) override;
+    void beginQuery    (AbstractGraphicsApi::QueryPool& pool, uint32_t id) override;
+    void endQuery      (AbstractGraphicsApi::QueryPool& pool, uint32_t id) override;
+
     void changeLayout(AbstractGraphicsApi::Buffer&  buf, BufferLayout  prev, BufferLayout  next) override;
     void changeLayout(AbstractGraphicsApi::Attach&  img, TextureLayout prev, TextureLayout next, bool byRegion) override;
     void changeLayout(AbstractGraphicsApi::Texture& tex, TextureLayout prev, TextureLayout next, uint32_t mipId);
@@ -79,6 +84,8 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, const AbstractGraphicsApi::Buffer& src, size_t offsetSrc, size_t size);
     void copy(AbstractGraphicsApi::Texture& dest, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset);
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Texture& src, size_t offset);
+    // copies all mips, src in TransferSrc, dest in TransferDest layout
+    void copy(AbstractGraphicsApi::Texture& dest, const AbstractGraphicsApi::Texture& src, uint32_t width, uint32_t height, uint32_t mipCount);
 
     void blit(AbstractGraphicsApi::Texture& src, uint32_t srcW, uint32_t srcH, uint32_t srcMip,
               AbstractGraphicsApi::Texture& dst, uint32_t dstW, uint32_t dstH, uint32_t dstMip);
@@ -7,14 +7,18 @@
 #include "vtexture.h"
 #include "vuniformslay.h"
 
+#include <algorithm>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-VDescriptorArray::VDescriptorArray(VkDevice device, VUniformsLay& vlay)
-  :device(device),lay(&vlay) {
+VDescriptorArray::VDescriptorArray(VDevice& dev, VUniformsLay& vlay)
+  :device(dev.device),alloc(dev.allocator),lay(&vlay) {
   if(lay.handler->hasSSBO)
     ssbo.reset(new SSBO[vlay.lay.size()]);
+  binds.reset(new Binding[vlay.lay.size()]);
 
+  {
   std::lock_guard<Detail::SpinLock> guard(vlay.sync);
   for(auto& i:vlay.pool){
     if(i.freeCount==0)
@@ -22,22 +26,27 @@ VDescriptorArray::VDescriptorArray(VkDevice device, VUniformsLay& vlay)
     if(allocDescSet(i.impl,vlay.impl)) {
       pool=&i;
       pool->freeCount--;
-      return;
+      break;
       }
     }
 
-  vlay.pool.emplace_back();
-  auto& b = vlay.pool.back();
-  b.impl  = allocPool(vlay,Detail::VUniformsLay::POOL_SIZE);
-  if(!allocDescSet(b.impl,vlay.impl))
-    throw std::bad_alloc();
-  pool = &b;
-  pool->freeCount--;
+  if(pool==nullptr) {
+    vlay.pool.emplace_back();
+    auto& b = vlay.pool.back();
+    b.impl  = allocPool(vlay,Detail::VUniformsLay::POOL_SIZE);
+    if(!allocDescSet(b.impl,vlay.impl))
+      throw std::bad_alloc();
+    pool = &b;
+    pool->freeCount--;
+    }
+  }
+  alloc.track(*this);
   }
 
 VDescriptorArray::~VDescriptorArray() {
   if(desc==VK_NULL_HANDLE)
     return;
+  alloc.untrack(*this);
   Detail::VUniformsLay* layImpl = lay.handler;
   std::lock_guard<Detail::SpinLock> guard(layImpl->sync);
 
@@ -100,6 +109,9 @@ void VDescriptorArray::set(size_t id, Tempest::AbstractGraphicsApi::Texture* t,
   imageInfo.imageView   = tex->getView(device,smp.mapping,uint32_t(-1));
 
   tex->alloc->updateSampler(imageInfo.sampler,smp,tex->mipCount);
+  binds[id].res = tex;
+  binds[id].map = smp.mapping;
+  binds[id].smp = imageInfo.sampler;
 
   VkWriteDescriptorSet descriptorWrite = {};
   descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -131,6 +143,7 @@ void VDescriptorArray::setSsbo(size_t id, AbstractGraphicsApi::Texture* t, uint3
 
   if(lay.handler->hasSSBO)
     ssbo[id].tex = t;
+  binds[id].res = nullptr;
 
   vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
   }
@@ -151,6 +164,10 @@ void VDescriptorArray::setUbo(size_t id, Tempest::AbstractGraphicsApi::Buffer *b
   descriptorWrite.descriptorCount = 1;
   descriptorWrite.pBufferInfo     = &bufferInfo;
 
+  binds[id].res    = memory;
+  binds[id].offset = offset;
+  binds[id].size   = size;
+
   vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
   }
 
@@ -172,6 +189,9 @@ void VDescriptorArray::setSsbo(size_t id, Tempest::AbstractGraphicsApi::Buffer *
 
   if(lay.handler->hasSSBO)
     ssbo[id].buf = buf;
+  binds[id].res    = memory;
+  binds[id].offset = offset;
+  binds[id].size   = size;
 
   vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
   }
@@ -198,6 +218,52 @@ void VDescriptorArray::ssboBarriers(ResourceState& res) {
     }
   }
 
+void VDescriptorArray::relocate(const std::vector<const void*>& moved) {
+  for(size_t i=0; i<lay.handler->lay.size(); ++i) {
+    auto& b = binds[i];
+    if(b.res==nullptr || !std::binary_search(moved.begin(),moved.end(),b.res))
+      continue;
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    VkDescriptorImageInfo  imageInfo  = {};
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet          = desc;
+    descriptorWrite.dstBinding      = uint32_t(i);
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorCount = 1;
+
+    switch(lay.handler->lay[i].cls) {
+      case UniformsLayout::Ubo:
+      case UniformsLayout::SsboR:
+      case UniformsLayout::SsboRW: {
+        bufferInfo.buffer = reinterpret_cast<const VBuffer*>(b.res)->impl;
+        bufferInfo.offset = b.offset;
+        bufferInfo.range  = b.size;
+        descriptorWrite.descriptorType = (lay.handler->lay[i].cls==UniformsLayout::Ubo) ?
+              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite.pBufferInfo    = &bufferInfo;
+        break;
+        }
+      case UniformsLayout::Texture: {
+        auto tex = const_cast<VTexture*>(reinterpret_cast<const VTexture*>(b.res));
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView   = tex->getView(device,b.map,uint32_t(-1));
+        imageInfo.sampler     = b.smp;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.pImageInfo     = &imageInfo;
+        break;
+        }
+      case UniformsLayout::ImgR:
+      case UniformsLayout::ImgRW:
+      case UniformsLayout::Push:
+        continue;
+      }
+    vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+    }
+  }
+
 void VDescriptorArray::addPoolSize(VkDescriptorPoolSize *p, size_t &sz, VkDescriptorType elt) {
   for(size_t i=0;i<sz;++i){
     if(p[i].type==elt) {
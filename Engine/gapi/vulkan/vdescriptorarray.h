@@ -5,14 +5,18 @@
 
 #include "vuniformslay.h"
 
+#include <vector>
+
 namespace Tempest {
 namespace Detail {
 
 class VUniformsLay;
+class VDevice;
+class VAllocator;
 
 class VDescriptorArray : public AbstractGraphicsApi::Desc {
   public:
-    VDescriptorArray(VkDevice device, VUniformsLay& vlay);
+    VDescriptorArray(VDevice& device, VUniformsLay& vlay);
     ~VDescriptorArray() override;
 
     void                     set    (size_t id, AbstractGraphicsApi::Texture* tex, const Sampler2d& smp) override;
@@ -20,11 +24,15 @@ class VDescriptorArray : public AbstractGraphicsApi::Desc {
     void                     setUbo (size_t id, AbstractGraphicsApi::Buffer*  buf, size_t offset, size_t size, size_t align) override;
     void                     setSsbo(size_t id, AbstractGraphicsApi::Buffer*  buf, size_t offset, size_t size, size_t align) override;
     void                     ssboBarriers(Detail::ResourceState& res) override;
+    // rewrites bindings of moved resources; moved is sorted
+    void                     relocate(const std::vector<const void*>& moved);
 
     VkDescriptorSet           desc=VK_NULL_HANDLE;
+    uint32_t                  regId=uint32_t(-1);
 
   private:
     VkDevice                  device=nullptr;
+    VAllocator&               alloc;
     DSharedPtr<VUniformsLay*> lay;
     VUniformsLay::Pool*       pool=nullptr;
 
@@ -34,6 +42,16 @@ class VDescriptorArray : public AbstractGraphicsApi::Desc {
       };
     std::unique_ptr<SSBO[]>  ssbo;
 
+    // bound ubo, ssbo buffers and sampled textures
+    struct Binding {
+      const void*      res    = nullptr;
+      size_t           offset = 0;
+      size_t           size   = 0;
+      ComponentMapping map;
+      VkSampler        smp    = VK_NULL_HANDLE;
+      };
+    std::unique_ptr<Binding[]> binds;
+
     VkDescriptorPool         allocPool(const VUniformsLay& lay, size_t size);
     bool                     allocDescSet(VkDescriptorPool pool, VkDescriptorSetLayout lay);
     static void              addPoolSize(VkDescriptorPoolSize* p, size_t& sz, VkDescriptorType elt);
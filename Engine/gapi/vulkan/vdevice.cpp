@@ -15,6 +15,7 @@
 #include <set>
 #include <cstring>
 #include <array>
+#include <algorithm>
 
 #if defined(__WINDOWS__)
 #  define VK_USE_PLATFORM_WIN32_KHR
@@ -56,6 +57,10 @@ class VDevice::FakeWindow final {
 
 VDevice::VDevice(VulkanApi &api, const char* gpuName)
   :instance(api.instance)  {
+  if(api.hasDeviceProps2) {
+    vkGetPhysicalDeviceMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>
+        (vkGetInstanceProcAddr(instance,"vkGetPhysicalDeviceMemoryProperties2KHR"));
+    }
 
   uint32_t deviceCount = 0;
   vkEnumeratePhysicalDevices(api.instance, &deviceCount, nullptr);
@@ -181,6 +186,9 @@ void VDevice::deviceQueueProps(Detail::VulkanApi::VkProp& prop,VkPhysicalDevice
 
   prop.graphicsFamily = graphics;
   prop.presentFamily  = present;
+
+  prop.timestampValidBits    = graphics!=uint32_t(-1) ? queueFamilies[graphics].timestampValidBits : 0;
+  prop.query.timestampPeriod = prop.timestampValidBits>0 ? double(p.limits.timestampPeriod) : 0.0;
   }
 
 bool VDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
@@ -247,6 +255,12 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     props.hasDedicatedAlloc = true;
     rqExt.push_back(VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME);
     }
+#ifdef VK_EXT_memory_budget
+  if(vkGetPhysicalDeviceMemoryProperties2!=nullptr && checkForExt(ext,VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    props.hasMemoryBudget = true;
+    rqExt.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+#endif
 
   std::array<uint32_t,2> uniqueQueueFamilies = {props.graphicsFamily, props.presentFamily};
   float  queuePriority = 1.0f;
@@ -281,6 +295,7 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy    = supportedFeatures.samplerAnisotropy;
   deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+  deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -327,6 +342,62 @@ VDevice::MemIndex VDevice::memoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFl
   throw std::runtime_error("failed to get correct memory type");
   }
 
+static void accumulate(MemoryStats::Usage& dst, const VAllocator::Stats& s) {
+  dst.used        += s.used;
+  dst.reserved    += s.reserved;
+  dst.largestFree  = std::max(dst.largestFree,s.largestFree);
+  dst.pages       += s.pages;
+  dst.dedicated   += s.dedicated;
+  dst.allocations += s.allocations;
+  }
+
+void VDevice::memoryStats(MemoryStats& out) {
+  out.heaps.assign(memoryProperties.memoryHeapCount,MemoryStats::Heap());
+  out.types.assign(memoryProperties.memoryTypeCount,MemoryStats::Type());
+
+  for(uint32_t i=0;i<memoryProperties.memoryHeapCount;++i) {
+    auto& h = memoryProperties.memoryHeaps[i];
+    out.heaps[i].size        = h.size;
+    out.heaps[i].budget      = h.size;
+    out.heaps[i].deviceLocal = (h.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)!=0;
+    }
+  for(uint32_t i=0;i<memoryProperties.memoryTypeCount;++i) {
+    auto& t = memoryProperties.memoryTypes[i];
+    out.types[i].heap        = t.heapIndex;
+    out.types[i].deviceLocal = (t.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)!=0;
+    out.types[i].hostVisible = (t.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)!=0;
+    }
+
+#ifdef VK_EXT_memory_budget
+  if(props.hasMemoryBudget) {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2KHR mem = {};
+    mem.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+    mem.pNext = &budget;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice,&mem);
+
+    for(uint32_t i=0;i<memoryProperties.memoryHeapCount;++i) {
+      out.heaps[i].budget = budget.heapBudget[i];
+      out.heaps[i].usage  = budget.heapUsage[i];
+      }
+    }
+#endif
+
+  std::vector<VAllocator::Stats> st;
+  allocator.stats(st);
+  for(size_t heapId=0;heapId<st.size();++heapId) {
+    // see memoryTypeIndex
+    const size_t typeId = heapId/2;
+    if(typeId>=out.types.size())
+      continue;
+    auto& t = out.types[typeId];
+    accumulate(t,st[heapId]);
+    accumulate(out.heaps[t.heap],st[heapId]);
+    }
+  }
+
 VkResult VDevice::present(VSwapchain &sw, const VSemaphore *wait, size_t wSize, uint32_t imageId) {
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -170,6 +170,7 @@ class VDevice : public AbstractGraphicsApi::Device {
 
     PFN_vkGetBufferMemoryRequirements2KHR vkGetBufferMemoryRequirements2 = nullptr;
     PFN_vkGetImageMemoryRequirements2KHR  vkGetImageMemoryRequirements2  = nullptr;
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2 = nullptr;
 
     VkResult                present(VSwapchain& sw,const VSemaphore *wait,size_t wSize,uint32_t imageId);
 
@@ -182,6 +183,7 @@ class VDevice : public AbstractGraphicsApi::Device {
     VkSurfaceKHR            createSurface(void* hwnd);
     SwapChainSupport        querySwapChainSupport(VkSurfaceKHR surface) { return querySwapChainSupport(physicalDevice,surface); }
     MemIndex                memoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags props, VkImageTiling tiling) const;
+    void                    memoryStats(MemoryStats& out);
 
     using DataMgr = UploadEngine<VDevice,VCommandBuffer,VFence>;
     DataMgr&                dataMgr() const { return *data; }
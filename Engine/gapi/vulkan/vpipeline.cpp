@@ -11,6 +11,7 @@
 
 #include <Tempest/UniformsLayout>
 #include <Tempest/RenderState>
+#include <Tempest/Profiler>
 
 using namespace Tempest;
 using namespace Tempest::Detail;
@@ -53,6 +54,7 @@ VPipeline::Inst &VPipeline::instance(VFramebufferLayout &lay, uint32_t width, ui
   for(auto& i:inst)
     if(i.w==width && i.h==height && i.lay.handler->isCompatible(lay))
       return i;
+  T_PROFILE_ZONE("VPipeline::instance");
   VkPipeline val=VK_NULL_HANDLE;
   try {
     val = initGraphicsPipeline(device,pipelineLayout,lay,st,
@@ -265,8 +267,8 @@ VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout lay
     a.blendEnable    = st.hasBlend() ? VK_TRUE : VK_FALSE;
     a.dstColorBlendFactor = blend[uint8_t(st.blendDest())];
     a.srcColorBlendFactor = blend[uint8_t(st.blendSource())];
-    a.dstAlphaBlendFactor = a.dstColorBlendFactor;
-    a.srcAlphaBlendFactor = a.srcColorBlendFactor;
+    a.dstAlphaBlendFactor = blend[uint8_t(st.blendAlphaDest())];
+    a.srcAlphaBlendFactor = blend[uint8_t(st.blendAlphaSource())];
     }
 
   VkPipelineColorBlendStateCreateInfo colorBlending = {};
@@ -0,0 +1,54 @@
+#include "vquerypool.h"
+
+#include "vdevice.h"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+// in order of PipelineStatistics fields: results are written in ascending bit order
+static const VkQueryPipelineStatisticFlags statisticsBits =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+VQueryPool::VQueryPool(VDevice& dev, QueryType type, uint32_t count)
+  :device(dev.device), type(type) {
+  VkQueryPoolCreateInfo info = {};
+  info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  info.queryCount = count;
+  if(type==QueryType::Timestamp) {
+    info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    } else {
+    info.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    info.pipelineStatistics = statisticsBits;
+    }
+  vkAssert(vkCreateQueryPool(device,&info,nullptr,&impl));
+
+  if(type==QueryType::Timestamp && dev.props.timestampValidBits<64)
+    mask = (uint64_t(1) << dev.props.timestampValidBits) - 1;
+  }
+
+VQueryPool::~VQueryPool() {
+  if(device==nullptr)
+    return;
+  vkDestroyQueryPool(device,impl,nullptr);
+  }
+
+bool VQueryPool::results(uint32_t first, uint32_t count, uint64_t* out) {
+  const size_t   values = (type==QueryType::Timestamp ? 1 : PipelineStatistics::count);
+  const size_t   stride = values*sizeof(uint64_t);
+  const VkResult res    = vkGetQueryPoolResults(device,impl,first,count,stride*count,out,
+                                                VkDeviceSize(stride),VK_QUERY_RESULT_64_BIT);
+  if(res==VK_NOT_READY)
+    return false;
+  vkAssert(res);
+  if(type==QueryType::Timestamp) {
+    for(uint32_t i=0;i<count;++i)
+      out[i] &= mask;
+    }
+  return true;
+  }
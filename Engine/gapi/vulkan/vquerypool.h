@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include "vulkan_sdk.h"
+
+namespace Tempest {
+namespace Detail {
+
+class VDevice;
+
+class VQueryPool : public AbstractGraphicsApi::QueryPool {
+  public:
+    VQueryPool(VDevice& dev, QueryType type, uint32_t count);
+    ~VQueryPool() override;
+
+    bool results(uint32_t first, uint32_t count, uint64_t* out) override;
+
+    VkQueryPool impl=VK_NULL_HANDLE;
+
+  private:
+    VkDevice  device = nullptr;
+    QueryType type   = QueryType::Timestamp;
+    uint64_t  mask   = uint64_t(-1);
+  };
+
+}}
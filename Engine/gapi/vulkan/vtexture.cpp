@@ -11,9 +11,14 @@ VTexture::VTexture(VTexture &&other) {
   std::swap(view,     other.view);
   std::swap(format,   other.format);
   std::swap(mipCount, other.mipCount);
+  std::swap(w,        other.w);
+  std::swap(h,        other.h);
   std::swap(alloc,    other.alloc);
   std::swap(page,     other.page);
+  std::swap(regId,    other.regId);
   std::swap(extViews, other.extViews);
+  if(regId!=VAllocator::NoReg)
+    alloc->relink(*this);
   }
 
 VTexture::~VTexture() {
@@ -31,9 +31,12 @@ class VTexture : public AbstractGraphicsApi::Texture {
     VkImageView getFboView(VkDevice dev, uint32_t mip);
 
     uint32_t    mipCount = 1;
+    uint32_t    w        = 0;
+    uint32_t    h        = 0;
 
     VAllocator*            alloc =nullptr;
     VAllocator::Allocation page  ={};
+    uint32_t               regId =VAllocator::NoReg;
 
   private:
     void createViews (VkDevice device);
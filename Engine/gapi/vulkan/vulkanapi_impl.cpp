@@ -50,14 +50,18 @@ VulkanApi::VulkanApi(bool validation)
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
   createInfo.pApplicationInfo = &appInfo;
 
-  auto extensions = std::initializer_list<const char*>{
+  std::vector<const char*> extensions = {
     VK_EXT_DEBUG_REPORT_EXTENSION_NAME,
     VK_KHR_SURFACE_EXTENSION_NAME,
     SURFACE_EXTENSION_NAME,
     };
+  if(extensionSupport(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+    hasDeviceProps2 = true;
+    extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
 
   createInfo.enabledExtensionCount   = static_cast<uint32_t>(extensions.size());
-  createInfo.ppEnabledExtensionNames = extensions.begin();
+  createInfo.ppEnabledExtensionNames = extensions.data();
 
   if(validation){
     createInfo.enabledLayerCount   = static_cast<uint32_t>(validationLayers.size());
@@ -114,6 +118,19 @@ const std::initializer_list<const char*>& VulkanApi::checkValidationLayerSupport
   return empty;
   }
 
+bool VulkanApi::extensionSupport(const char* name) {
+  uint32_t extCount=0;
+  vkEnumerateInstanceExtensionProperties(nullptr,&extCount,nullptr);
+
+  std::vector<VkExtensionProperties> ext(extCount);
+  vkEnumerateInstanceExtensionProperties(nullptr,&extCount,ext.data());
+
+  for(auto& i:ext)
+    if(std::strcmp(i.extensionName,name)==0)
+      return true;
+  return false;
+  }
+
 bool VulkanApi::layerSupport(const std::vector<VkLayerProperties>& sup,
                              const std::initializer_list<const char*> dest) {
   for(auto& i:dest) {
@@ -202,6 +219,8 @@ void VulkanApi::getDevicePropsShort(VkPhysicalDevice physicalDevice, Tempest::Ab
   c.compute.maxGroupSize.y = prop.limits.maxComputeWorkGroupSize[1];
   c.compute.maxGroupSize.z = prop.limits.maxComputeWorkGroupSize[2];
 
+  c.query.pipelineStatistics = supportedFeatures.pipelineStatisticsQuery;
+
   switch(prop.deviceType) {
     case VK_PHYSICAL_DEVICE_TYPE_CPU:
       c.type = AbstractGraphicsApi::DeviceType::Cpu;
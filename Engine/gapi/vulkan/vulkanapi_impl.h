@@ -17,6 +17,7 @@ class VulkanApi {
     std::vector<AbstractGraphicsApi::Props> devices() const;
 
     VkInstance       instance;
+    bool             hasDeviceProps2=false;
 
     struct VkProp:Tempest::AbstractGraphicsApi::Props {
       uint32_t graphicsFamily=uint32_t(-1);
@@ -25,8 +26,11 @@ class VulkanApi {
       size_t   nonCoherentAtomSize=0;
       size_t   bufferImageGranularity=0;
 
+      uint32_t timestampValidBits=0;
+
       bool     hasMemRq2        =false;
       bool     hasDedicatedAlloc=false;
+      bool     hasMemoryBudget  =false;
       };
 
     static void      getDeviceProps(VkPhysicalDevice physicalDevice, VkProp& c);
@@ -34,6 +38,7 @@ class VulkanApi {
 
   private:
     const std::initializer_list<const char*>& checkValidationLayerSupport();
+    bool extensionSupport(const char* name);
     bool layerSupport(const std::vector<VkLayerProperties>& sup,const std::initializer_list<const char*> dest);
 
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugReportCallback(
@@ -15,6 +15,7 @@
 #include "vulkan/vdescriptorarray.h"
 #include "vulkan/vuniformslay.h"
 #include "vulkan/vtexture.h"
+#include "vulkan/vquerypool.h"
 #include "vulkan/vuniformslay.h"
 
 #include "deviceallocator.h"
@@ -146,6 +147,15 @@ AbstractGraphicsApi::Semaphore *VulkanApi::createSemaphore(AbstractGraphicsApi::
   return new Detail::VSemaphore(*dx);
   }
 
+AbstractGraphicsApi::QueryPool* VulkanApi::createQueryPool(AbstractGraphicsApi::Device* d, QueryType type, uint32_t count) {
+  Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
+  if(type==QueryType::Timestamp && dx->props.query.timestampPeriod<=0)
+    return nullptr;
+  if(type==QueryType::PipelineStatistics && !dx->props.query.pipelineStatistics)
+    return nullptr;
+  return new Detail::VQueryPool(*dx,type,count);
+  }
+
 AbstractGraphicsApi::PBuffer VulkanApi::createBuffer(AbstractGraphicsApi::Device *d,
                                                      const void *mem, size_t count, size_t size, size_t alignedSz,
                                                      MemUsage usage, BufferHeap flg) {
@@ -156,9 +166,11 @@ AbstractGraphicsApi::PBuffer VulkanApi::createBuffer(AbstractGraphicsApi::Device
     return PBuffer(new Detail::VBuffer(std::move(stage)));
     }
   else {
-    Detail::VBuffer  buf =dx.allocator.alloc(nullptr, count,size,alignedSz, usage|MemUsage::TransferDst,BufferHeap::Static);
+    // TransferSrc: static buffers can be moved by defragment
+    Detail::VBuffer  buf =dx.allocator.alloc(nullptr, count,size,alignedSz, usage|MemUsage::TransferDst|MemUsage::TransferSrc,BufferHeap::Static);
     if(mem==nullptr) {
       Detail::DSharedPtr<Detail::VBuffer*> pbuf(new Detail::VBuffer(std::move(buf)));
+      dx.allocator.setMovable(*pbuf.handler);
       return PBuffer(pbuf.handler);
       }
 
@@ -175,6 +187,7 @@ AbstractGraphicsApi::PBuffer VulkanApi::createBuffer(AbstractGraphicsApi::Device
     cmd->end();
     dx.dataMgr().submit(std::move(cmd));
 
+    dx.allocator.setMovable(*reinterpret_cast<Detail::VBuffer*>(pbuf.handler));
     return PBuffer(pbuf.handler);
     }
   }
@@ -219,6 +232,7 @@ AbstractGraphicsApi::PTexture VulkanApi::createTexture(AbstractGraphicsApi::Devi
   cmd->end();
   dx.dataMgr().submit(std::move(cmd));
 
+  dx.allocator.setMovable(*reinterpret_cast<Detail::VTexture*>(pbuf.handler));
   return PTexture(pbuf.handler);
   }
 
@@ -296,7 +310,7 @@ AbstractGraphicsApi::Desc *VulkanApi::createDescriptors(AbstractGraphicsApi::Dev
   auto& ul = reinterpret_cast<Detail::VUniformsLay&>(ulayImpl);
   if(ul.lay.size()==0)
     return nullptr;
-  return new Detail::VDescriptorArray(dx->device,ul);
+  return new Detail::VDescriptorArray(*dx,ul);
   }
 
 AbstractGraphicsApi::PUniformsLay VulkanApi::createUboLayout(Device *d, const std::initializer_list<Shader*>& shaders) {
@@ -443,3 +457,13 @@ void VulkanApi::getCaps(Device *d, Props& props) {
   props=dx->props;
   }
 
+void VulkanApi::memoryStats(Device* d, MemoryStats& out) {
+  Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
+  dx->memoryStats(out);
+  }
+
+size_t VulkanApi::defragment(Device* d, size_t maxBytes) {
+  Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
+  return dx->allocator.defragment(maxBytes);
+  }
+
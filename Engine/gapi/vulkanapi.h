@@ -46,6 +46,8 @@ class VulkanApi : public AbstractGraphicsApi {
 
     Semaphore*     createSemaphore(Device *d) override;
 
+    QueryPool*     createQueryPool(Device* d, QueryType type, uint32_t count) override;
+
     PBuffer        createBuffer (Device* d, const void *mem, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap flg) override;
     PTexture       createTexture(Device* d,const Pixmap& p,TextureFormat frm,uint32_t mips) override;
     PTexture       createTexture(Device* d,const uint32_t w,const uint32_t h,uint32_t mips, TextureFormat frm) override;
@@ -68,6 +70,8 @@ class VulkanApi : public AbstractGraphicsApi {
                              Fence *doneCpu) override;
 
     void           getCaps  (Device *d, Props& props) override;
+    void           memoryStats(Device* d, MemoryStats& out) override;
+    size_t         defragment (Device* d, size_t maxBytes) override;
 
   private:
     struct Impl;
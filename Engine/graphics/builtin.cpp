@@ -17,6 +17,15 @@ Builtin::Builtin(Device& owner)
   stAlpha.setBlendDest    (RenderState::BlendMode::one);
   stAlpha.setZWriteEnabled(false);
 
+  stPremul.setBlendSource  (RenderState::BlendMode::one);
+  stPremul.setBlendDest    (RenderState::BlendMode::one_minus_src_alpha);
+  stPremul.setZWriteEnabled(false);
+
+  stLayer.setBlendSource  (RenderState::BlendMode::src_alpha);
+  stLayer.setBlendDest    (RenderState::BlendMode::one_minus_src_alpha);
+  stLayer.setBlendAlpha   (RenderState::BlendMode::one,RenderState::BlendMode::one_minus_src_alpha);
+  stLayer.setZWriteEnabled(false);
+
   vsE  = owner.shader(empty_vert_sprv,sizeof(empty_vert_sprv));
   fsE  = owner.shader(empty_frag_sprv,sizeof(empty_frag_sprv));
 
@@ -34,6 +43,12 @@ const Builtin::Item &Builtin::texture2d() const {
 
     brushT2.penA   = owner.pipeline<PaintDevice::Point>(Lines,    stAlpha,vsT2,fsT2);
     brushT2.brushA = owner.pipeline<PaintDevice::Point>(Triangles,stAlpha,vsT2,fsT2);
+
+    brushT2.penP   = owner.pipeline<PaintDevice::Point>(Lines,    stPremul,vsT2,fsT2);
+    brushT2.brushP = owner.pipeline<PaintDevice::Point>(Triangles,stPremul,vsT2,fsT2);
+
+    brushT2.penL   = owner.pipeline<PaintDevice::Point>(Lines,    stLayer,vsT2,fsT2);
+    brushT2.brushL = owner.pipeline<PaintDevice::Point>(Triangles,stLayer,vsT2,fsT2);
     }
   return brushT2;
   }
@@ -48,6 +63,12 @@ const Builtin::Item &Builtin::empty() const {
 
     brushE.penA   = owner.pipeline<PaintDevice::Point>(Lines,    stAlpha,vsE,fsE);
     brushE.brushA = owner.pipeline<PaintDevice::Point>(Triangles,stAlpha,vsE,fsE);
+
+    brushE.penP   = owner.pipeline<PaintDevice::Point>(Lines,    stPremul,vsE,fsE);
+    brushE.brushP = owner.pipeline<PaintDevice::Point>(Triangles,stPremul,vsE,fsE);
+
+    brushE.penL   = owner.pipeline<PaintDevice::Point>(Lines,    stLayer,vsE,fsE);
+    brushE.brushL = owner.pipeline<PaintDevice::Point>(Triangles,stLayer,vsE,fsE);
     }
   return brushE;
   }
@@ -25,6 +25,14 @@ class Builtin final {
 
       Tempest::RenderPipeline penA;
       Tempest::RenderPipeline brushA;
+
+      // premultiplied source
+      Tempest::RenderPipeline penP;
+      Tempest::RenderPipeline brushP;
+
+      // straight source into premultiplied target
+      Tempest::RenderPipeline penL;
+      Tempest::RenderPipeline brushL;
       };
 
     const Item& texture2d() const;
@@ -34,7 +42,7 @@ class Builtin final {
     mutable Item            brushT2;
     mutable Item            brushE;
 
-    RenderState             stNormal, stBlend, stAlpha;
+    RenderState             stNormal, stBlend, stAlpha, stPremul, stLayer;
     Device&                 owner;
     Tempest::Shader         vsT2,fsT2,vsE,fsE;
 
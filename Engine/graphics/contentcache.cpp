@@ -0,0 +1,162 @@
+#include "contentcache.h"
+
+#include <cstring>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+ContentCache::ContentCache(Retirer& next)
+  :next(next) {
+  }
+
+ContentCache::~ContentCache() {
+  // objects still alive are retired directly
+  for(auto& i:tex)
+    i.second.impl->retirer = &next;
+  for(auto& i:sh)
+    i.second->retirer = &next;
+  }
+
+template<class T>
+DSharedPtr<T*> ContentCache::lock(T* p) {
+  // counter, dropped to zero, can't be revived: object is on its way to retire
+  auto c = p->counter.load(std::memory_order_relaxed);
+  while(c!=0) {
+    if(p->counter.compare_exchange_weak(c,c+1,std::memory_order_acquire,std::memory_order_relaxed)) {
+      DSharedPtr<T*> ret(p);
+      p->counter.fetch_sub(1,std::memory_order_relaxed);
+      return ret;
+      }
+    }
+  return DSharedPtr<T*>();
+  }
+
+void ContentCache::setEnabled(bool e) {
+  std::lock_guard<std::mutex> guard(sync);
+  enabled = e;
+  if(e)
+    return;
+  // dropped entries are still retired through cache, and just passed to next
+  tex.clear();
+  sh.clear();
+  texOf.clear();
+  shOf.clear();
+  }
+
+auto ContentCache::findTexture(const TexKey& k, Texture& out) -> PTexture {
+  std::lock_guard<std::mutex> guard(sync);
+  auto it = tex.find(k);
+  if(it==tex.end())
+    return PTexture();
+  out = it->second;
+  return lock(it->second.impl);
+  }
+
+void ContentCache::putTexture(const TexKey& k, const Texture& t) {
+  std::lock_guard<std::mutex> guard(sync);
+  if(!enabled)
+    return;
+  // previous entry, if any, is released but not retired yet
+  tex[k]        = t;
+  texOf[t.impl] = k;
+  t.impl->retirer = this;
+  }
+
+auto ContentCache::findShader(const Digest& hash, size_t size) -> PShader {
+  std::lock_guard<std::mutex> guard(sync);
+  auto it = sh.find(ShKey{hash,size});
+  if(it==sh.end())
+    return PShader();
+  return lock(it->second);
+  }
+
+void ContentCache::putShader(const Digest& hash, size_t size, const PShader& s) {
+  std::lock_guard<std::mutex> guard(sync);
+  if(!enabled)
+    return;
+  sh[ShKey{hash,size}] = s.handler;
+  shOf[s.handler]      = ShKey{hash,size};
+  s.handler->retirer   = this;
+  }
+
+void ContentCache::retire(void* obj, Deleter del) {
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  auto t = texOf.find(obj);
+  if(t!=texOf.end()) {
+    auto i = tex.find(t->second);
+    if(i!=tex.end() && i->second.impl==obj)
+      tex.erase(i);
+    texOf.erase(t);
+    }
+  auto s = shOf.find(obj);
+  if(s!=shOf.end()) {
+    auto i = sh.find(s->second);
+    if(i!=sh.end() && i->second==obj)
+      sh.erase(i);
+    shOf.erase(s);
+    }
+  }
+  next.retire(obj,del);
+  }
+
+static uint64_t rotl(uint64_t x, int r) {
+  return (x << r) | (x >> (64-r));
+  }
+
+static uint64_t fmix(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdull;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ull;
+  k ^= k >> 33;
+  return k;
+  }
+
+ContentCache::Digest ContentCache::hash(const void* data, size_t size) {
+  // lane 0: MurmurHash64A; lane 1: MurmurHash3-style mixing, in the same pass
+  const uint64_t m    = 0xc6a4a7935bd1e995ull;
+  const uint64_t c1   = 0x87c37b91114253d5ull;
+  const uint64_t c2   = 0x4cf5ad432745937full;
+  const int      r    = 47;
+  uint64_t       h    = 0x8445d61a4e774912ull ^ (uint64_t(size)*m);
+  uint64_t       h1   = 0x9e3779b97f4a7c15ull;
+  auto           p    = reinterpret_cast<const uint8_t*>(data);
+  const uint8_t* end  = p + (size/8)*8;
+
+  for(;p!=end;p+=8) {
+    uint64_t k;
+    std::memcpy(&k,p,8);
+
+    uint64_t k1 = rotl(k*c1,31)*c2;
+    h1 ^= k1;
+    h1  = rotl(h1,27)*5+0x52dce729;
+
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+    }
+
+  uint64_t t = 0;
+  switch(size & 7) {
+    case 7: t ^= uint64_t(p[6]) << 48; // fallthrough
+    case 6: t ^= uint64_t(p[5]) << 40; // fallthrough
+    case 5: t ^= uint64_t(p[4]) << 32; // fallthrough
+    case 4: t ^= uint64_t(p[3]) << 24; // fallthrough
+    case 3: t ^= uint64_t(p[2]) << 16; // fallthrough
+    case 2: t ^= uint64_t(p[1]) << 8;  // fallthrough
+    case 1: t ^= uint64_t(p[0]);
+            h ^= t;
+            h *= m;
+            h1 ^= rotl(t*c1,31)*c2;
+    }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  h1 ^= uint64_t(size);
+  return Digest{h,fmix(h1)};
+  }
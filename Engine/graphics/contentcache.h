@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace Tempest {
+namespace Detail {
+
+// content-addressed cache of immutable gpu objects
+// holds weak references: cached object is retired through the cache, and leaves it on last release
+class ContentCache final : public Retirer {
+  public:
+    using PTexture = AbstractGraphicsApi::PTexture;
+    using PShader  = AbstractGraphicsApi::PShader;
+
+    // released objects are passed to next, once removed from cache
+    explicit ContentCache(Retirer& next);
+    ~ContentCache();
+
+    // two independent 64-bit lanes: collision of both is not expected in practice
+    struct Digest {
+      uint64_t h0=0, h1=0;
+      bool operator == (const Digest& d) const { return h0==d.h0 && h1==d.h1; }
+      };
+
+    struct TexKey {
+      Digest        hash;
+      size_t        size=0;
+      uint32_t      w=0, h=0;
+      TextureFormat frm=Undefined;
+      bool          mips=false;
+
+      bool operator == (const TexKey& k) const {
+        return hash==k.hash && size==k.size && w==k.w && h==k.h && frm==k.frm && mips==k.mips;
+        }
+      };
+
+    struct Texture {
+      AbstractGraphicsApi::Texture* impl=nullptr; // weak
+      uint32_t                      w=0, h=0;
+      TextureFormat                 frm=Undefined;
+      };
+
+    void     setEnabled(bool e);
+    bool     isEnabled() const { return enabled; }
+
+    PTexture findTexture(const TexKey& k, Texture& out);
+    void     putTexture (const TexKey& k, const Texture& t);
+
+    PShader  findShader (const Digest& hash, size_t size);
+    void     putShader  (const Digest& hash, size_t size, const PShader& s);
+
+    void     retire(void* obj, Deleter del) override;
+
+    static Digest hash(const void* data, size_t size);
+
+  private:
+    struct KeyHash {
+      size_t operator()(const TexKey& k) const { return size_t(k.hash.h0 ^ (uint64_t(k.w)<<32) ^ k.h); }
+      };
+    struct ShKey {
+      Digest hash;
+      size_t size=0;
+      bool operator == (const ShKey& k) const { return hash==k.hash && size==k.size; }
+      };
+    struct ShHash {
+      size_t operator()(const ShKey& k) const { return size_t(k.hash.h0); }
+      };
+
+    template<class T>
+    static DSharedPtr<T*> lock(T* p);
+
+    Retirer&                                                   next;
+    bool                                                       enabled=true;
+
+    std::mutex                                                 sync;
+    std::unordered_map<TexKey,Texture,KeyHash>                 tex;
+    std::unordered_map<ShKey,AbstractGraphicsApi::Shader*,ShHash> sh;
+    // reverse lookup, for retire
+    std::unordered_map<const void*,TexKey>                     texOf;
+    std::unordered_map<const void*,ShKey>                      shOf;
+  };
+
+}
+}
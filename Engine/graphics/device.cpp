@@ -7,11 +7,54 @@
 #include <Tempest/File>
 #include <Tempest/Pixmap>
 #include <Tempest/Except>
+#include <Tempest/Profiler>
 
+#include "contentcache.h"
+#include "retirequeue.h"
+
+#include <algorithm>
 #include <mutex>
 
 using namespace Tempest;
 
+template<class T>
+Detail::DSharedPtr<T> Device::track(Detail::DSharedPtr<T>&& p) {
+  // released objects go to retire queue instead of immediate delete
+  if(p)
+    p.handler->retirer = retire.get();
+  return std::move(p);
+  }
+
+template<class F>
+void Device::implSubmit(Fence* fdone, F submit) {
+  // every submission is fenced, so retired objects can be deleted when gpu is done with them
+  AbstractGraphicsApi::Fence* f = fdone!=nullptr ? fdone->impl.handler : retire->takeFence();
+  if(f==nullptr)
+    f = api.createFence(dev);
+  if(fdone==nullptr)
+    f->reset();
+
+  uint64_t serial = 0;
+  try {
+    serial = retire->submit([&](){ submit(f); });
+    }
+  catch(...) {
+    if(fdone==nullptr)
+      delete f;
+    throw;
+    }
+
+  if(fdone!=nullptr)
+    fdone->serial = serial; else
+    retire->track(serial,f);
+  retire->collect();
+  }
+
+void Device::implFenceDone(uint64_t serial) {
+  retire->complete(serial);
+  retire->collect();
+  }
+
 static uint32_t mipCount(uint32_t w, uint32_t h) {
   uint32_t s = std::max(w,h);
   uint32_t n = 1;
@@ -36,23 +79,95 @@ Device::Device(AbstractGraphicsApi& api, uint8_t maxFramesInFlight)
   }
 
 Device::Device(AbstractGraphicsApi &api, const char* name, uint8_t maxFramesInFlight)
-  :api(api), impl(api,name,maxFramesInFlight), dev(impl.dev), builtins(*this) {
+  :api(api), impl(api,name,maxFramesInFlight), dev(impl.dev), retire(new Detail::RetireQueue(impl.dev)), builtins(*this) {
   api.getCaps(dev,devProps);
+  profiler.reset(new Detail::GpuProfiler(api,dev,devProps));
   }
 
 Device::~Device() {
   }
 
+void Device::setContentCache(bool enable) {
+  // never destroyed before device: released objects may still be retired through it
+  if(enable && cache==nullptr)
+    cache.reset(new Detail::ContentCache(*retire));
+  if(cache!=nullptr)
+    cache->setEnabled(enable);
+  }
+
+bool Device::hasContentCache() const {
+  return cache!=nullptr && cache->isEnabled();
+  }
+
 uint8_t Device::maxFramesInFlight() const {
   return impl.maxFramesInFlight;
   }
 
+void Device::setGpuProfiling(bool enable) {
+  profiler->setEnabled(enable);
+  }
+
+bool Device::hasGpuProfiling() const {
+  return profiler->isEnabled();
+  }
+
+bool Device::gpuReport(GpuFrameReport& out) {
+  profiler->collect();
+  return profiler->takeReport(out);
+  }
+
 void Device::waitIdle() {
   impl.dev->waitIdle();
+  retire->completeAll();
+  retire->collect();
+  // everything recorded so far is finished: close current profiling frame
+  profiler->nextFrame();
+  profiler->collect();
+  implCheckBudget();
+  }
+
+MemoryStats Device::memoryStats() const {
+  MemoryStats st;
+  api.memoryStats(dev,st);
+  return st;
+  }
+
+void Device::setMemoryBudgetCallback(float threshold, MemoryBudgetCallback cb) {
+  budget.threshold = threshold;
+  budget.callback  = std::move(cb);
+  budget.over.clear();
+  }
+
+size_t Device::defragment(size_t maxBytes) {
+  const size_t moved = api.defragment(dev,maxBytes);
+  if(moved>0) {
+    // device is idle at this point
+    retire->completeAll();
+    retire->collect();
+    }
+  return moved;
+  }
+
+void Device::implCheckBudget() {
+  if(!budget.callback)
+    return;
+  const MemoryStats st = memoryStats();
+  budget.over.resize(st.heaps.size(),false);
+  for(size_t i=0;i<st.heaps.size();++i) {
+    auto&      h    = st.heaps[i];
+    // driver usage also counts memory, not owned by allocator (swapchain images, for example)
+    const bool over = double(std::max(h.usage,h.reserved)) > double(h.budget)*double(budget.threshold);
+    if(over==budget.over[i])
+      continue;
+    budget.over[i] = over;
+    budget.callback(st,uint32_t(i),over);
+    }
   }
 
 void Device::submit(const CommandBuffer &cmd, const Semaphore &wait) {
-  api.submit(dev,cmd.impl.handler,wait.impl.handler,nullptr,nullptr);
+  implSubmit(nullptr,[&](AbstractGraphicsApi::Fence* f){
+    api.submit(dev,cmd.impl.handler,wait.impl.handler,nullptr,f);
+    });
   }
 
 void Device::submit(const CommandBuffer &cmd, Fence &fdone) {
@@ -61,7 +176,9 @@ void Device::submit(const CommandBuffer &cmd, Fence &fdone) {
   }
 
 void Device::submit(const CommandBuffer &cmd, const Semaphore &wait, Semaphore &done, Fence &fdone) {
-  api.submit(dev,cmd.impl.handler,wait.impl.handler,done.impl.handler,fdone.impl.handler);
+  implSubmit(&fdone,[&](AbstractGraphicsApi::Fence* f){
+    api.submit(dev,cmd.impl.handler,wait.impl.handler,done.impl.handler,f);
+    });
   }
 
 void Device::submit(const Tempest::CommandBuffer *cmd[], size_t count,
@@ -74,20 +191,24 @@ void Device::submit(const Tempest::CommandBuffer *cmd[], size_t count,
     auto wx = reinterpret_cast<AbstractGraphicsApi::Semaphore**>(ptr+count);
     auto dx = reinterpret_cast<AbstractGraphicsApi::Semaphore**>(ptr+count+waitCnt);
 
-    implSubmit(cmd,  cx, count,
-               wait, wx, waitCnt,
-               done, dx, doneCnt,
-               fdone->impl.handler);
+    implSubmit(fdone,[&](AbstractGraphicsApi::Fence* f){
+      implSubmit(cmd,  cx, count,
+                 wait, wx, waitCnt,
+                 done, dx, doneCnt,
+                 f);
+      });
     } else {
     std::unique_ptr<void*[]> ptr(new void*[count+waitCnt+doneCnt]);
     auto cx = reinterpret_cast<AbstractGraphicsApi::CommandBuffer**>(ptr.get());
     auto wx = reinterpret_cast<AbstractGraphicsApi::Semaphore**>(ptr.get()+count);
     auto dx = reinterpret_cast<AbstractGraphicsApi::Semaphore**>(ptr.get()+count+waitCnt);
 
-    implSubmit(cmd,  cx, count,
-               wait, wx, waitCnt,
-               done, dx, doneCnt,
-               fdone->impl.handler);
+    implSubmit(fdone,[&](AbstractGraphicsApi::Fence* f){
+      implSubmit(cmd,  cx, count,
+                 wait, wx, waitCnt,
+                 done, dx, doneCnt,
+                 f);
+      });
     }
   }
 
@@ -95,6 +216,10 @@ void Device::present(Swapchain& sw, uint32_t img, const Semaphore& wait) {
   api.present(dev,sw.impl.handler,img,wait.impl.handler);
   sw.framesCounter++;
   sw.framesIdMod=(sw.framesIdMod+1)%maxFramesInFlight();
+  profiler->nextFrame();
+  profiler->collect();
+  implCheckBudget();
+  T_PROFILE_FRAME();
   }
 
 void Device::implSubmit(const CommandBuffer*        cmd[],  AbstractGraphicsApi::CommandBuffer*  hcmd[],  size_t count,
@@ -122,23 +247,40 @@ Shader Device::loadShader(RFile &file) {
   file.read(reinterpret_cast<char*>(buffer.get()),fileSize);
 
   size_t size=uint32_t(fileSize);
+  return implShader(buffer.get(),size);
+  }
 
-  Shader f(*this,api.createShader(dev,reinterpret_cast<const char*>(buffer.get()),size));
-  return f;
+Shader Device::loadShader(MappedFile& file) {
+  // mapping is page-aligned, so spir-v words can be consumed in place
+  return implShader(file.data(),file.size());
   }
 
 Shader Device::loadShader(const char *filename) {
-  Tempest::RFile file(filename);
+  Tempest::MappedFile file(filename);
   return loadShader(file);
   }
 
 Shader Device::loadShader(const char16_t *filename) {
-  Tempest::RFile file(filename);
+  Tempest::MappedFile file(filename);
   return loadShader(file);
   }
 
 Shader Device::shader(const void *source, const size_t length) {
-  Shader f(*this,api.createShader(dev,source,length));
+  return implShader(source,length);
+  }
+
+Shader Device::implShader(const void* source, size_t length) {
+  if(!hasContentCache()) {
+    Shader f(*this,track(api.createShader(dev,source,length)));
+    return f;
+    }
+
+  const auto h = Detail::ContentCache::hash(source,length);
+  if(auto p = cache->findShader(h,length))
+    return Shader(*this,std::move(p));
+
+  Shader f(*this,track(api.createShader(dev,source,length)));
+  cache->putShader(h,length,f.impl);
   return f;
   }
 
@@ -154,18 +296,43 @@ Attachment Device::attachment(TextureFormat frm, const uint32_t w, const uint32_
   if(!devProps.hasSamplerFormat(frm) && !devProps.hasAttachFormat(frm))
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
   uint32_t mipCnt = mips ? mipCount(w,h) : 1;
-  Texture2d t(*this,api.createTexture(dev,w,h,mipCnt,frm),w,h,frm);
+  Texture2d t(*this,track(api.createTexture(dev,w,h,mipCnt,frm)),w,h,frm);
   return Attachment(std::move(t));
   }
 
 ZBuffer Device::zbuffer(TextureFormat frm, const uint32_t w, const uint32_t h) {
   if(!devProps.hasDepthFormat(frm))
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
-  Texture2d t(*this,api.createTexture(dev,w,h,1,frm),w,h,frm);
+  Texture2d t(*this,track(api.createTexture(dev,w,h,1,frm)),w,h,frm);
   return ZBuffer(std::move(t),devProps.hasSamplerFormat(frm));
   }
 
 Texture2d Device::loadTexture(const Pixmap &pm, bool mips) {
+  if(!hasContentCache())
+    return implLoadTexture(pm,mips);
+
+  Detail::ContentCache::TexKey k;
+  k.hash = Detail::ContentCache::hash(pm.data(),pm.dataSize());
+  k.size = pm.dataSize();
+  k.w    = pm.w();
+  k.h    = pm.h();
+  k.frm  = Pixmap::toTextureFormat(pm.format());
+  k.mips = mips;
+
+  Detail::ContentCache::Texture c;
+  if(auto p = cache->findTexture(k,c))
+    return Texture2d(*this,std::move(p),c.w,c.h,c.frm);
+
+  Texture2d t = implLoadTexture(pm,mips);
+  c.impl = t.impl.handler;
+  c.w    = uint32_t(t.w());
+  c.h    = uint32_t(t.h());
+  c.frm  = t.format();
+  cache->putTexture(k,c);
+  return t;
+  }
+
+Texture2d Device::implLoadTexture(const Pixmap &pm, bool mips) {
   TextureFormat format = Pixmap::toTextureFormat(pm.format());
   uint32_t      mipCnt = mips ? mipCount(pm.w(),pm.h()) : 1;
   const Pixmap* p=&pm;
@@ -202,7 +369,7 @@ Texture2d Device::loadTexture(const Pixmap &pm, bool mips) {
       }
     }
 
-  Texture2d t(*this,api.createTexture(dev,*p,format,mipCnt),p->w(),p->h(),format);
+  Texture2d t(*this,track(api.createTexture(dev,*p,format,mipCnt)),p->w(),p->h(),format);
   return t;
   }
 
@@ -210,7 +377,7 @@ StorageImage Device::image2d(TextureFormat frm, const uint32_t w, const uint32_t
   if(!devProps.hasStorageFormat(frm))
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
   uint32_t mipCnt = mips ? mipCount(w,h) : 1;
-  StorageImage t(*this,api.createStorage(dev,w,h,mipCnt,frm),w,h,frm);
+  StorageImage t(*this,track(api.createStorage(dev,w,h,mipCnt,frm)),w,h,frm);
   return t;
   }
 
@@ -247,9 +414,9 @@ FrameBuffer Device::frameBuffer(Attachment &out) {
   AbstractGraphicsApi::Texture*   cl[1]    = { out.tImpl.impl.handler };
   AbstractGraphicsApi::Swapchain* sw[1]    = { out.sImpl.swapchain    };
   uint32_t                        imgId[1] = { out.sImpl.id           };
-  auto                            lay      = FrameBufferLayout(api.createFboLayout(dev,sw,att,1));
+  auto                            lay      = FrameBufferLayout(track(api.createFboLayout(dev,sw,att,1)));
 
-  auto fbo = api.createFbo(dev,lay.impl.handler,w,h,1, sw,cl,imgId,nullptr);
+  auto fbo = track(api.createFbo(dev,lay.impl.handler,w,h,1, sw,cl,imgId,nullptr));
   return FrameBuffer(*this,std::move(fbo),std::move(lay),w,h);
   }
 
@@ -265,9 +432,9 @@ FrameBuffer Device::frameBuffer(Attachment& out, ZBuffer& zbuf) {
   AbstractGraphicsApi::Texture*   cl[1]    = { out.tImpl.impl.handler };
   AbstractGraphicsApi::Swapchain* sw[1]    = { out.sImpl.swapchain    };
   uint32_t                        imgId[1] = { out.sImpl.id           };
-  auto                            lay      = FrameBufferLayout(api.createFboLayout(dev,sw,att,2));
+  auto                            lay      = FrameBufferLayout(track(api.createFboLayout(dev,sw,att,2)));
 
-  auto fbo = api.createFbo(dev,lay.impl.handler,w,h,1, sw,cl,imgId,zImpl);
+  auto fbo = track(api.createFbo(dev,lay.impl.handler,w,h,1, sw,cl,imgId,zImpl));
   return FrameBuffer(*this,std::move(fbo),std::move(lay),w,h);
   }
 
@@ -311,44 +478,44 @@ FrameBuffer Device::frameBuffer(Attachment** out, uint8_t count, ZBuffer* zbuf)
     att[count] = zbuf->tImpl.frm;
     }
 
-  auto lay = FrameBufferLayout(api.createFboLayout(dev,sw,att,count+(zbuf!=nullptr ? 1 : 0)));
-  auto fbo = api.createFbo(dev,lay.impl.handler,w,h,count, sw,cl,imgId,zImpl);
+  auto lay = FrameBufferLayout(track(api.createFboLayout(dev,sw,att,count+(zbuf!=nullptr ? 1 : 0))));
+  auto fbo = track(api.createFbo(dev,lay.impl.handler,w,h,count, sw,cl,imgId,zImpl));
   return FrameBuffer(*this,std::move(fbo),std::move(lay),w,h);
   }
 
 RenderPass Device::pass(const FboMode &color) {
   const FboMode* att[1]={&color};
-  RenderPass f(api.createPass(dev,att,1));
+  RenderPass f(track(api.createPass(dev,att,1)));
   return f;
   }
 
 RenderPass Device::pass(const FboMode& color, const FboMode& depth) {
   const FboMode* att[2]={&color,&depth};
-  RenderPass f(api.createPass(dev,att,2));
+  RenderPass f(track(api.createPass(dev,att,2)));
   return f;
   }
 
 RenderPass Device::pass(const FboMode& c0, const FboMode& c1, const FboMode& depth) {
   const FboMode* att[3]={&c0,&c1,&depth};
-  RenderPass f(api.createPass(dev,att,3));
+  RenderPass f(track(api.createPass(dev,att,3)));
   return f;
   }
 
 RenderPass Device::pass(const FboMode& c0, const FboMode& c1, const FboMode& c2, const FboMode& depth) {
   const FboMode* att[4]={&c0,&c1,&c2,&depth};
-  RenderPass f(api.createPass(dev,att,4));
+  RenderPass f(track(api.createPass(dev,att,4)));
   return f;
   }
 
 RenderPass Device::pass(const FboMode& c0, const FboMode& c1,
                         const FboMode& c2, const FboMode& c3, const FboMode& depth) {
   const FboMode* att[5]={&c0,&c1,&c2,&c3,&depth};
-  RenderPass f(api.createPass(dev,att,5));
+  RenderPass f(track(api.createPass(dev,att,5)));
   return f;
   }
 
 RenderPass Device::pass(const FboMode** color, uint8_t count) {
-  RenderPass f(api.createPass(dev,color,count));
+  RenderPass f(track(api.createPass(dev,color,count)));
   return f;
   }
 
@@ -367,8 +534,8 @@ ComputePipeline Device::pipeline(const Shader& comp) {
     return ComputePipeline();
 
   std::initializer_list<AbstractGraphicsApi::Shader*> sh = {comp.impl.handler};
-  auto ulay = api.createUboLayout(dev,sh);
-  auto pipe = api.createComputePipeline(dev,*ulay.handler,comp.impl.handler);
+  auto ulay = track(api.createUboLayout(dev,sh));
+  auto pipe = track(api.createComputePipeline(dev,*ulay.handler,comp.impl.handler));
   ComputePipeline f(std::move(pipe),std::move(ulay));
   return f;
   }
@@ -382,8 +549,8 @@ RenderPipeline Device::implPipeline(const RenderState &st,
     return RenderPipeline();
 
   std::initializer_list<AbstractGraphicsApi::Shader*> sh = {vs.impl.handler,fs.impl.handler};
-  auto ulay = api.createUboLayout(dev,sh);
-  auto pipe = api.createPipeline(dev,st,decl,declSize,stride,tp,*ulay.handler,sh);
+  auto ulay = track(api.createUboLayout(dev,sh));
+  auto pipe = track(api.createPipeline(dev,st,decl,declSize,stride,tp,*ulay.handler,sh));
   RenderPipeline f(std::move(pipe),std::move(ulay));
   return f;
   }
@@ -402,7 +569,7 @@ const char* Device::renderer() const {
   }
 
 VideoBuffer Device::createVideoBuffer(const void *data, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap flg) {
-  VideoBuffer buf(*this,api.createBuffer(dev,data,count,size,alignedSz,usage,flg),count*alignedSz);
+  VideoBuffer buf(*this,track(api.createBuffer(dev,data,count,size,alignedSz,usage,flg)),count*alignedSz);
   return  buf;
   }
 
@@ -21,7 +21,9 @@
 #include <Tempest/Except>
 
 #include "videobuffer.h"
+#include "gpuprofiler.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -32,6 +34,7 @@ class Semaphore;
 
 class CommandPool;
 class RFile;
+class MappedFile;
 
 class VideoBuffer;
 class Pixmap;
@@ -42,9 +45,15 @@ class UniformsLayout;
 class Color;
 class RenderState;
 
+namespace Detail {
+class ContentCache;
+class RetireQueue;
+}
+
 class Device {
   public:
     using Props=AbstractGraphicsApi::Props;
+    using MemoryBudgetCallback=std::function<void(const MemoryStats& stats, uint32_t heap, bool over)>;
 
     Device(AbstractGraphicsApi& api, uint8_t maxFramesInFlight=2);
     Device(AbstractGraphicsApi& api, const char* name, uint8_t maxFramesInFlight=2);
@@ -66,6 +75,7 @@ class Device {
     Swapchain            swapchain(SystemApi::Window* w) const;
 
     Shader               loadShader(RFile&          file);
+    Shader               loadShader(MappedFile&     file);
     Shader               loadShader(const char*     filename);
     Shader               loadShader(const char16_t* filename);
     Shader               shader    (const void* source, const size_t length);
@@ -151,6 +161,26 @@ class Device {
     const Builtin&       builtin() const;
     const char*          renderer() const;
 
+    // identical pixmaps and shader binaries share one gpu object;
+    // cache doesn't hold objects: entry is dropped, once last reference is released
+    void                 setContentCache(bool enable);
+    bool                 hasContentCache() const;
+
+    // gpu timings of Encoder::beginTimer/endTimer scopes; noop, if device has no timestamp queries
+    void                 setGpuProfiling(bool enable);
+    bool                 hasGpuProfiling() const;
+    // oldest finished frame report, never waits for gpu; frames are separated by present and waitIdle
+    bool                 gpuReport(GpuFrameReport& out);
+
+    // per-heap and per-memory-type usage of device memory
+    MemoryStats          memoryStats() const;
+    // checked on present and waitIdle: cb is called for each heap, which usage crossed threshold*budget in either direction
+    void                 setMemoryBudgetCallback(float threshold, MemoryBudgetCallback cb);
+    // one step of memory defragmentation: moves up to ~maxBytes of static buffers and textures out of sparse pages;
+    // waits for gpu, if anything is moved. Call between frames; command buffers, recorded before, must be recorded again
+    // if result is not zero
+    size_t               defragment(size_t maxBytes);
+
   private:
     struct Impl {
       Impl(AbstractGraphicsApi& api, const char* name, uint8_t maxFramesInFlight);
@@ -161,11 +191,32 @@ class Device {
       uint8_t                         maxFramesInFlight=1;
       };
 
+    struct MemoryBudget {
+      float                           threshold=1.f;
+      MemoryBudgetCallback            callback;
+      std::vector<bool>               over;
+      };
+
     AbstractGraphicsApi&            api;
     Impl                            impl;
     AbstractGraphicsApi::Device*    dev=nullptr;
+    // destroyed after retire queue: objects, deleted by it, may release cached ones
+    std::unique_ptr<Detail::ContentCache> cache;
+    std::unique_ptr<Detail::RetireQueue> retire;
+    std::unique_ptr<Detail::GpuProfiler> profiler;
     Props                           devProps;
     Tempest::Builtin                builtins;
+    MemoryBudget                    budget;
+
+    template<class T>
+    Detail::DSharedPtr<T> track(Detail::DSharedPtr<T>&& p);
+    template<class F>
+    void        implSubmit(Fence* fdone, F submit);
+    void        implFenceDone(uint64_t serial);
+    void        implCheckBudget();
+
+    Shader      implShader(const void* source, size_t length);
+    Texture2d   implLoadTexture(const Pixmap& pm, bool mips);
 
     VideoBuffer createVideoBuffer(const void* data, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap flg);
 
@@ -190,11 +241,14 @@ class Device {
   friend class CommandBuffer;
   friend class VideoBuffer;
   friend class Uniforms;
+  friend class Fence;
 
   template<class T>
   friend class VertexBuffer;
   template<class T>
   friend class VertexBufferDyn;
+  template<class T>
+  friend class Encoder;
 
   friend class Texture2d;
   };
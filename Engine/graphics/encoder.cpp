@@ -1,12 +1,16 @@
 #include "encoder.h"
 
 #include <Tempest/Attachment>
+#include <Tempest/Device>
 #include <Tempest/FrameBuffer>
+#include <Tempest/Profiler>
 #include <Tempest/RenderPass>
 #include <Tempest/Texture2d>
 
 using namespace Tempest;
 
+T_PROFILE_COUNTER(drawCalls,"draws");
+
 static uint32_t mipCount(uint32_t w, uint32_t h) {
   uint32_t s = std::max(w,h);
   uint32_t n = 1;
@@ -23,21 +27,28 @@ Encoder<Tempest::CommandBuffer>::Encoder(Tempest::CommandBuffer* ow)
   state.vp.height = 0;
 
   impl->begin();
+  if(ow->dev!=nullptr) {
+    timers.profiler = ow->dev->profiler.get();
+    timers.page     = timers.profiler->beginRecording(*impl);
+    }
   }
 
 Encoder<CommandBuffer>::Encoder(Encoder<CommandBuffer> &&e)
-  :owner(e.owner),impl(e.impl),state(std::move(e.state)) {
-  e.owner = nullptr;
-  e.impl  = nullptr;
+  :owner(e.owner),impl(e.impl),state(std::move(e.state)),timers(e.timers) {
+  e.owner  = nullptr;
+  e.impl   = nullptr;
+  e.timers = Timers();
   }
 
 Encoder<CommandBuffer> &Encoder<CommandBuffer>::operator =(Encoder<CommandBuffer> &&e) {
-  owner = e.owner;
-  impl  = e.impl;
-  state = std::move(e.state);
+  owner  = e.owner;
+  impl   = e.impl;
+  state  = std::move(e.state);
+  timers = e.timers;
 
-  e.owner = nullptr;
-  e.impl  = nullptr;
+  e.owner  = nullptr;
+  e.impl   = nullptr;
+  e.timers = Timers();
 
   return *this;
   }
@@ -45,9 +56,46 @@ Encoder<CommandBuffer> &Encoder<CommandBuffer>::operator =(Encoder<CommandBuffer
 Encoder<Tempest::CommandBuffer>::~Encoder() noexcept(false) {
   if(impl==nullptr)
     return;
+  if(timers.page!=nullptr) {
+    while(timers.depth>0)
+      endTimer();
+    if(timers.statsAfterPass!=Detail::GpuProfiler::npos)
+      implEndRenderPass();
+    timers.profiler->endRecording(timers.page);
+    }
   impl->end();
   }
 
+void Encoder<Tempest::CommandBuffer>::beginTimer(const char* name) {
+  auto& t = timers;
+  if(t.page==nullptr)
+    return;
+  // scopes deeper than MaxDepth are ignored, but still counted to keep endTimer paired
+  if(t.depth<Timers::MaxDepth) {
+    // only one statistics query can be active at a time
+    const bool stats = t.depth==0 && t.statsAfterPass==Detail::GpuProfiler::npos;
+    t.stack[t.depth] = t.profiler->beginScope(*t.page,*impl,name,t.depth,stats);
+    if(t.depth==0)
+      t.statsInPass = curPass.pass!=nullptr;
+    }
+  t.depth++;
+  }
+
+void Encoder<Tempest::CommandBuffer>::endTimer() {
+  auto& t = timers;
+  if(t.page==nullptr || t.depth==0)
+    return;
+  t.depth--;
+  if(t.depth==0 && !t.statsInPass && curPass.pass!=nullptr && t.statsAfterPass==Detail::GpuProfiler::npos) {
+    // query began outside of render pass: has to end outside of it as well
+    t.profiler->endScope(*t.page,*impl,t.stack[0],false);
+    t.statsAfterPass = t.stack[0];
+    return;
+    }
+  if(t.depth<Timers::MaxDepth)
+    t.profiler->endScope(*t.page,*impl,t.stack[t.depth]);
+  }
+
 void Encoder<Tempest::CommandBuffer>::setViewport(int x, int y, int w, int h) {
   impl->setViewport(Rect(x,y,w,h));
   }
@@ -118,6 +166,7 @@ void Encoder<Tempest::CommandBuffer>::implDraw(const VideoBuffer& vbo, size_t of
     state.curIbo=nullptr;
     }*/
   impl->draw(offset,size);
+  T_PROFILE_ADD(drawCalls,1);
   }
 
 void Encoder<Tempest::CommandBuffer>::implDraw(const VideoBuffer &vbo, const VideoBuffer &ibo, Detail::IndexClass index, size_t offset, size_t size) {
@@ -132,6 +181,7 @@ void Encoder<Tempest::CommandBuffer>::implDraw(const VideoBuffer &vbo, const Vid
     state.curIbo=&ibo;
     }
   impl->drawIndexed(offset,size,0);
+  T_PROFILE_ADD(drawCalls,1);
   }
 
 void Encoder<CommandBuffer>::setFramebuffer(std::nullptr_t) {
@@ -139,6 +189,9 @@ void Encoder<CommandBuffer>::setFramebuffer(std::nullptr_t) {
   }
 
 void Encoder<CommandBuffer>::setFramebuffer(const FrameBuffer &fbo, const RenderPass &p) {
+  // query begun outside of render pass may span it
+  if(timers.page!=nullptr && timers.depth>0 && timers.statsInPass)
+    timers.profiler->endStats(*timers.page,*impl,timers.stack[0]);
   implEndRenderPass();
 
   if(fbo.impl.handler==nullptr && p.impl.handler==nullptr) {
@@ -162,10 +215,15 @@ void Encoder<CommandBuffer>::implEndRenderPass() {
     curPass           = Pass();
     reinterpret_cast<AbstractGraphicsApi::CommandBuffer*>(impl)->endRenderPass();
     }
+  if(timers.statsAfterPass!=Detail::GpuProfiler::npos) {
+    timers.profiler->endStats(*timers.page,*impl,timers.statsAfterPass);
+    timers.statsAfterPass = Detail::GpuProfiler::npos;
+    }
   }
 
 void Encoder<CommandBuffer>::dispatch(size_t x, size_t y, size_t z) {
   impl->dispatch(x,y,z);
+  T_PROFILE_ADD(drawCalls,1);
   }
 
 void Encoder<CommandBuffer>::generateMipmaps(Attachment& tex) {
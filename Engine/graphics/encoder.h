@@ -6,6 +6,7 @@
 #include <Tempest/Uniforms>
 
 #include "videobuffer.h"
+#include "gpuprofiler.h"
 
 #include <vector>
 
@@ -67,6 +68,11 @@ class Encoder<Tempest::CommandBuffer> {
 
     void generateMipmaps(Attachment& tex);
 
+    // gpu time scope, see Device::setGpuProfiling; name must outlive the report (string literal)
+    // outermost scopes also collect pipeline statistics, where supported
+    void beginTimer(const char* name);
+    void endTimer();
+
   private:
     Encoder(CommandBuffer* ow);
 
@@ -88,10 +94,23 @@ class Encoder<Tempest::CommandBuffer> {
       const RenderPass*  pass = nullptr;
       };
 
+    struct Timers {
+      enum { MaxDepth = 16 };
+      Detail::GpuProfiler*       profiler = nullptr;
+      Detail::GpuProfiler::Page* page     = nullptr;
+      uint32_t                   depth    = 0;
+      uint32_t                   stack[MaxDepth] = {};
+      // stats query of stack[0] began inside of render pass
+      bool                       statsInPass    = false;
+      // stats query to end, once current render pass is over
+      uint32_t                   statsAfterPass = Detail::GpuProfiler::npos;
+      };
+
     Tempest::CommandBuffer*             owner=nullptr;
     AbstractGraphicsApi::CommandBuffer* impl =nullptr;
     State                               state;
     Pass                                curPass;
+    Timers                              timers;
 
     void         implEndRenderPass();
     void         implDraw(const VideoBuffer& vbo, size_t offset, size_t size);
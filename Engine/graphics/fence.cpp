@@ -13,10 +13,14 @@ Fence::~Fence() {
 
 void Fence::wait() {
   impl.handler->wait();
+  dev->implFenceDone(serial);
   }
 
 bool Fence::wait(uint64_t time) {
-  return impl.handler->wait(time);
+  if(!impl.handler->wait(time))
+    return false;
+  dev->implFenceDone(serial);
+  return true;
   }
 
 void Fence::reset() {
@@ -22,6 +22,7 @@ class Fence final {
 
     Tempest::Device*                          dev=nullptr;
     Detail::DPtr<AbstractGraphicsApi::Fence*> impl;
+    uint64_t                                  serial=0;
 
   friend class Tempest::Device;
   };
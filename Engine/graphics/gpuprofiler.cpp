@@ -0,0 +1,246 @@
+#include "gpuprofiler.h"
+
+#include <algorithm>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+const uint32_t GpuProfiler::npos;
+
+struct GpuProfiler::Page {
+  struct Scope {
+    const char* name   = nullptr;
+    uint32_t    depth  = 0;
+    bool        stats  = false; // statistics query was issued
+    bool        active = false; // statistics query is not ended yet
+    };
+
+  std::unique_ptr<AbstractGraphicsApi::QueryPool> time;
+  std::unique_ptr<AbstractGraphicsApi::QueryPool> stats;
+
+  uint64_t frame     = 0;
+  uint32_t used      = 0;
+  uint32_t dropped   = 0;
+  bool     recording = false;
+  Scope    scope[MaxScopes];
+  };
+
+GpuProfiler::GpuProfiler(AbstractGraphicsApi& api, AbstractGraphicsApi::Device* dev, const AbstractGraphicsApi::Props& props)
+  :api(api), dev(dev), period(props.query.timestampPeriod), hasStats(props.query.pipelineStatistics) {
+  }
+
+GpuProfiler::~GpuProfiler() {
+  bool busy = !pending.empty();
+  for(auto& i:pages)
+    busy |= i->recording;
+  if(busy)
+    dev->waitIdle();
+  }
+
+void GpuProfiler::setEnabled(bool e) {
+  std::lock_guard<std::mutex> guard(sync);
+  enabled = e && period>0;
+  }
+
+bool GpuProfiler::isEnabled() const {
+  std::lock_guard<std::mutex> guard(sync);
+  return enabled;
+  }
+
+GpuProfiler::Page* GpuProfiler::beginRecording(AbstractGraphicsApi::CommandBuffer& cmd) {
+  Page* p = nullptr;
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  if(!enabled)
+    return nullptr;
+  p = allocPage();
+  if(p==nullptr) {
+    enabled = false;
+    return nullptr;
+    }
+  p->frame     = frame;
+  p->used      = 0;
+  p->dropped   = 0;
+  p->recording = true;
+  frameOf(frame).pending++;
+  }
+
+  cmd.resetQueries(*p->time,0,MaxScopes*2);
+  if(p->stats!=nullptr)
+    cmd.resetQueries(*p->stats,0,MaxScopes);
+  return p;
+  }
+
+void GpuProfiler::endRecording(Page* p) {
+  if(p==nullptr)
+    return;
+  std::lock_guard<std::mutex> guard(sync);
+  p->recording = false;
+  pending.push_back(p);
+  }
+
+uint32_t GpuProfiler::beginScope(Page& p, AbstractGraphicsApi::CommandBuffer& cmd, const char* name, uint32_t depth, bool stats) {
+  if(p.used>=MaxScopes) {
+    p.dropped++;
+    return npos;
+    }
+  const uint32_t id = p.used;
+  auto&          s  = p.scope[id];
+  s.name   = name;
+  s.depth  = depth;
+  s.stats  = stats && p.stats!=nullptr;
+  s.active = s.stats;
+  p.used++;
+
+  cmd.writeTimestamp(*p.time,id*2+0);
+  if(s.stats)
+    cmd.beginQuery(*p.stats,id);
+  return id;
+  }
+
+void GpuProfiler::endScope(Page& p, AbstractGraphicsApi::CommandBuffer& cmd, uint32_t scope, bool stats) {
+  if(scope==npos)
+    return;
+  if(stats)
+    endStats(p,cmd,scope);
+  cmd.writeTimestamp(*p.time,scope*2+1);
+  }
+
+void GpuProfiler::endStats(Page& p, AbstractGraphicsApi::CommandBuffer& cmd, uint32_t scope) {
+  if(scope==npos)
+    return;
+  auto& s = p.scope[scope];
+  if(!s.active)
+    return;
+  // query stays valid, it just covers less work
+  cmd.endQuery(*p.stats,scope);
+  s.active = false;
+  }
+
+void GpuProfiler::nextFrame() {
+  std::lock_guard<std::mutex> guard(sync);
+  ++frame;
+  }
+
+void GpuProfiler::collect() {
+  std::lock_guard<std::mutex> guard(sync);
+  size_t n = 0;
+  for(size_t i=0;i<pending.size();++i) {
+    Page& p = *pending[i];
+    bool  ok = resolve(p);
+    if(!ok && p.frame+MaxLatency>=frame) {
+      pending[n++] = &p;
+      continue;
+      }
+    auto& f = frameOf(p.frame);
+    if(!ok)
+      f.report.dropped += p.used;
+    f.report.dropped += p.dropped;
+    f.pending--;
+    freePages.push_back(&p);
+    }
+  pending.resize(n);
+  flushFrames();
+  }
+
+bool GpuProfiler::takeReport(GpuFrameReport& out) {
+  std::lock_guard<std::mutex> guard(sync);
+  if(reports.empty())
+    return false;
+  out = std::move(reports.front());
+  reports.pop_front();
+  return true;
+  }
+
+GpuProfiler::Page* GpuProfiler::allocPage() {
+  if(!freePages.empty()) {
+    auto p = freePages.back();
+    freePages.pop_back();
+    return p;
+    }
+
+  std::unique_ptr<Page> p(new Page());
+  p->time.reset(api.createQueryPool(dev,QueryType::Timestamp,MaxScopes*2));
+  if(p->time==nullptr)
+    return nullptr;
+  if(hasStats)
+    p->stats.reset(api.createQueryPool(dev,QueryType::PipelineStatistics,MaxScopes));
+  pages.emplace_back(std::move(p));
+  return pages.back().get();
+  }
+
+GpuProfiler::Frame& GpuProfiler::frameOf(uint64_t id) {
+  // pages are taken in frame order, so frame is either known or newest
+  for(auto& i:frames)
+    if(i.id==id)
+      return i;
+  frames.emplace_back();
+  frames.back().id           = id;
+  frames.back().report.frame = id;
+  return frames.back();
+  }
+
+bool GpuProfiler::resolve(Page& p) {
+  if(p.used==0)
+    return true;
+
+  const size_t statStride = PipelineStatistics::count;
+  scratch.resize(p.used*(2+statStride));
+  uint64_t* ts    = scratch.data();
+  uint64_t* stats = scratch.data() + p.used*2;
+  if(!p.time->results(0,p.used*2,ts))
+    return false;
+  for(uint32_t i=0;i<p.used;++i) {
+    if(p.scope[i].stats && !p.stats->results(i,1,stats+i*statStride))
+      return false;
+    }
+
+  auto& f = frameOf(p.frame);
+  for(uint32_t i=0;i<p.used;++i) {
+    auto&                 src = p.scope[i];
+    GpuFrameReport::Scope s;
+    const uint64_t        t0  = ts[i*2+0];
+    const uint64_t        t1  = std::max(ts[i*2+1],t0);
+
+    s.name  = src.name;
+    s.depth = src.depth;
+    s.time  = double(t1-t0)*period/1000000.0;
+    if(src.stats) {
+      const uint64_t* st = stats+i*statStride;
+      auto&           d  = s.statistics;
+      d.inputVertices       = st[0];
+      d.inputPrimitives     = st[1];
+      d.vertexInvocations   = st[2];
+      d.clippingInvocations = st[3];
+      d.clippingPrimitives  = st[4];
+      d.fragmentInvocations = st[5];
+      d.computeInvocations  = st[6];
+      s.hasStatistics = true;
+      }
+
+    f.tBegin = std::min(f.tBegin,t0);
+    f.tEnd   = std::max(f.tEnd,  t1);
+    f.start.push_back(t0);
+    f.report.scopes.push_back(s);
+    }
+  return true;
+  }
+
+void GpuProfiler::flushFrames() {
+  while(!frames.empty() && frames.front().id<frame && frames.front().pending==0) {
+    auto& f = frames.front();
+    auto& r = f.report;
+    for(size_t i=0;i<r.scopes.size();++i)
+      r.scopes[i].start = double(f.start[i]-f.tBegin)*period/1000000.0;
+    std::stable_sort(r.scopes.begin(),r.scopes.end(),[](const GpuFrameReport::Scope& a,const GpuFrameReport::Scope& b){
+      return a.start<b.start;
+      });
+    if(f.tEnd>=f.tBegin && !r.scopes.empty())
+      r.gpuTime = double(f.tEnd-f.tBegin)*period/1000000.0;
+
+    reports.emplace_back(std::move(r));
+    if(reports.size()>MaxReports)
+      reports.pop_front();
+    frames.pop_front();
+    }
+  }
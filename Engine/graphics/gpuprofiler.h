@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tempest {
+
+// gpu timings of one frame (frames are separated by Device::present and Device::waitIdle)
+struct GpuFrameReport final {
+  struct Scope {
+    const char*        name  = nullptr; // pointer, given to Encoder::beginTimer
+    uint32_t           depth = 0;
+    double             start = 0;       // milliseconds, relative to first timestamp of frame
+    double             time  = 0;       // milliseconds
+    bool               hasStatistics = false;
+    PipelineStatistics statistics;
+    };
+
+  uint64_t           frame   = 0;
+  double             gpuTime = 0;       // milliseconds, from first to last timestamp of frame
+  uint32_t           dropped = 0;       // scopes without results: page overflow or lost command buffer
+  std::vector<Scope> scopes;            // sorted by start time
+  };
+
+namespace Detail {
+
+// owns timestamp/statistics query pools; every recorded command buffer gets its own page of queries,
+// results are read back without waiting, a few frames later
+class GpuProfiler final {
+  public:
+    enum : uint32_t {
+      MaxScopes  = 64,
+      MaxReports = 16,
+      // page, that has no results after this many frames, is considered never submitted
+      MaxLatency = 8,
+      };
+    static const uint32_t npos = uint32_t(-1);
+
+    GpuProfiler(AbstractGraphicsApi& api, AbstractGraphicsApi::Device* dev, const AbstractGraphicsApi::Props& props);
+    ~GpuProfiler();
+
+    struct Page;
+
+    void     setEnabled(bool e);
+    bool     isEnabled() const;
+
+    // nullptr, if profiling is disabled; resets queries of page, so must be called outside of render pass
+    Page*    beginRecording(AbstractGraphicsApi::CommandBuffer& cmd);
+    void     endRecording  (Page* p);
+
+    uint32_t beginScope(Page& p, AbstractGraphicsApi::CommandBuffer& cmd, const char* name, uint32_t depth, bool stats);
+    // stats=false leaves statistics query running, to be closed by endStats later
+    void     endScope  (Page& p, AbstractGraphicsApi::CommandBuffer& cmd, uint32_t scope, bool stats=true);
+    // pipeline-statistics query can't cross render pass boundary, if begun inside of it; ends it early
+    void     endStats  (Page& p, AbstractGraphicsApi::CommandBuffer& cmd, uint32_t scope);
+
+    void     nextFrame();
+    void     collect();
+    bool     takeReport(GpuFrameReport& out);
+
+  private:
+    struct Frame {
+      uint64_t       id      = 0;
+      uint32_t       pending = 0;
+      uint64_t       tBegin  = uint64_t(-1);
+      uint64_t       tEnd    = 0;
+      std::vector<uint64_t> start; // raw timestamp per scope of report
+      GpuFrameReport report;
+      };
+
+    Page*    allocPage();
+    Frame&   frameOf(uint64_t id);
+    bool     resolve(Page& p);
+    void     flushFrames();
+
+    AbstractGraphicsApi&                 api;
+    AbstractGraphicsApi::Device*         dev = nullptr;
+    const double                         period;
+    const bool                           hasStats;
+    bool                                 enabled = false;
+
+    mutable std::mutex                   sync;
+    uint64_t                             frame = 0;
+    std::vector<std::unique_ptr<Page>>   pages;
+    std::vector<Page*>                   freePages;
+    std::vector<Page*>                   pending;
+    std::deque<Frame>                    frames;
+    std::deque<GpuFrameReport>           reports;
+    std::vector<uint64_t>                scratch;
+  };
+
+}
+}
@@ -52,7 +52,13 @@ class RenderState final {
     BlendMode blendSource() const { return blendS; }
     BlendMode blendDest()   const { return blendD; }
 
-    bool      hasBlend() const { return blendS!=BlendMode::one || blendD!=BlendMode::zero; }
+    //! separate factors for alpha channel; by default same as color factors
+    void      setBlendAlpha(BlendMode s, BlendMode d) { blendAS=s; blendAD=d; sepAlpha=true; }
+    BlendMode blendAlphaSource() const { return sepAlpha ? blendAS : blendS; }
+    BlendMode blendAlphaDest()   const { return sepAlpha ? blendAD : blendD; }
+
+    bool      hasBlend() const { return blendS!=BlendMode::one || blendD!=BlendMode::zero ||
+                                        blendAlphaSource()!=BlendMode::one || blendAlphaDest()!=BlendMode::zero; }
 
     void      setZTestMode(ZTestMode z){ zmode=z; }
     ZTestMode zTestMode() const { return zmode; }
@@ -69,10 +75,13 @@ class RenderState final {
   private:
     BlendMode blendS=BlendMode::one;
     BlendMode blendD=BlendMode::zero;
+    BlendMode blendAS=BlendMode::one;
+    BlendMode blendAD=BlendMode::zero;
     ZTestMode zmode =ZTestMode::Always;
     CullMode  cull  =CullMode::Back;
     bool      discard=false;
     bool      zdiscard=false;
+    bool      sepAlpha=false;
   };
 
 }
@@ -0,0 +1,110 @@
+#include "retirequeue.h"
+
+#include <algorithm>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+RetireQueue::RetireQueue(AbstractGraphicsApi::Device* dev)
+  :dev(dev) {
+  }
+
+RetireQueue::~RetireQueue() {
+  dev->waitIdle();
+  completeAll();
+  // deleting an object may retire objects it holds
+  while(true) {
+    std::vector<Entry> e;
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    std::swap(e,entries);
+    }
+    if(e.empty())
+      break;
+    release(e);
+    }
+  for(auto& i:inflight)
+    delete i.fence;
+  for(auto i:freeFences)
+    delete i;
+  }
+
+void RetireQueue::retire(void* obj, Deleter del) {
+  // object may be referenced by command buffer, that is recorded but not submitted yet
+  std::lock_guard<std::mutex> guard(sync);
+  entries.push_back({submitted+1,obj,del});
+  }
+
+uint64_t RetireQueue::nextSerial() {
+  std::lock_guard<std::mutex> guard(sync);
+  return ++submitted;
+  }
+
+AbstractGraphicsApi::Fence* RetireQueue::takeFence() {
+  std::lock_guard<std::mutex> guard(sync);
+  if(freeFences.empty())
+    return nullptr;
+  auto f = freeFences.back();
+  freeFences.pop_back();
+  return f;
+  }
+
+void RetireQueue::track(uint64_t serial, AbstractGraphicsApi::Fence* internal) {
+  std::lock_guard<std::mutex> guard(sync);
+  inflight.push_back({serial,internal});
+  }
+
+void RetireQueue::complete(uint64_t serial) {
+  std::lock_guard<std::mutex> guard(sync);
+  completed = std::max(completed,std::min(serial,submitted));
+  }
+
+void RetireQueue::completeAll() {
+  std::lock_guard<std::mutex> guard(sync);
+  completed = submitted;
+  for(auto& i:inflight)
+    freeFences.push_back(i.fence);
+  inflight.clear();
+  }
+
+void RetireQueue::pollFences() {
+  // fences on one queue signal in submission order: stop at first pending one
+  std::lock_guard<std::mutex> guard(sync);
+  size_t n = 0;
+  for(;n<inflight.size();++n) {
+    auto& i = inflight[n];
+    if(i.serial>completed && !i.fence->wait(0))
+      break;
+    completed = std::max(completed,i.serial);
+    freeFences.push_back(i.fence);
+    }
+  inflight.erase(inflight.begin(),inflight.begin()+ptrdiff_t(n));
+  }
+
+void RetireQueue::collect() {
+  pollFences();
+
+  std::vector<Entry> ready;
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  if(entries.empty())
+    return;
+  // entries are pushed with non-decreasing serial
+  auto end = std::upper_bound(entries.begin(),entries.end(),completed,[](uint64_t c,const Entry& e){
+    return c<e.serial;
+    });
+  ready.assign(entries.begin(),end);
+  entries.erase(entries.begin(),end);
+  }
+  release(ready);
+  }
+
+size_t RetireQueue::pendingCount() const {
+  std::lock_guard<std::mutex> guard(sync);
+  return entries.size();
+  }
+
+void RetireQueue::release(std::vector<Entry>& e) {
+  for(auto& i:e)
+    i.del(i.obj);
+  }
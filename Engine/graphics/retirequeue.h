@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <mutex>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// deferred destruction of gpu objects:
+// object released while submission N is latest, is deleted once N+1 is known to be complete on gpu
+class RetireQueue final : public Retirer {
+  public:
+    explicit RetireQueue(AbstractGraphicsApi::Device* dev);
+    ~RetireQueue();
+
+    void     retire(void* obj, Deleter del) override;
+
+    // assigns serial and calls fn under submission lock, so serials follow queue order
+    template<class F>
+    uint64_t submit(F fn) {
+      std::lock_guard<std::mutex> guard(submitSync);
+      const uint64_t s = nextSerial();
+      fn();
+      return s;
+      }
+
+    // signaled fence from pool or nullptr
+    AbstractGraphicsApi::Fence* takeFence();
+    void     track(uint64_t serial, AbstractGraphicsApi::Fence* internal);
+
+    // all submissions up to serial are finished
+    void     complete(uint64_t serial);
+    void     completeAll();
+    // polls internal fences and deletes everything that is safe to delete
+    void     collect();
+
+    size_t   pendingCount() const;
+
+  private:
+    struct Entry {
+      uint64_t serial=0;
+      void*    obj=nullptr;
+      Deleter  del=nullptr;
+      };
+
+    struct Inflight {
+      uint64_t                    serial=0;
+      AbstractGraphicsApi::Fence* fence=nullptr;
+      };
+
+    uint64_t nextSerial();
+    void     pollFences();
+    void     release(std::vector<Entry>& e);
+
+    AbstractGraphicsApi::Device*             dev = nullptr;
+
+    std::mutex                               submitSync;
+    mutable std::mutex                       sync;
+    uint64_t                                 submitted = 0;
+    uint64_t                                 completed = 0;
+    std::vector<Entry>                       entries;
+    std::vector<Inflight>                    inflight;
+    std::vector<AbstractGraphicsApi::Fence*> freeFences;
+  };
+
+}
+}
@@ -0,0 +1,578 @@
+#include "asyncreader.h"
+
+#include <Tempest/TextCodec>
+#include <Tempest/Except>
+#include <Tempest/Log>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__LINUX__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if defined(IO_URING_OP_SUPPORTED) && defined(__NR_io_uring_setup)
+#define TEMPEST_IO_URING
+#endif
+
+using namespace Tempest;
+
+#ifdef __WINDOWS__
+using Native = HANDLE;
+static const Native invalidNative = INVALID_HANDLE_VALUE;
+#else
+using Native = int;
+static const Native invalidNative = -1;
+#endif
+
+namespace {
+
+struct Request {
+  Native   fd     = invalidNative;
+  uint64_t offset = 0;
+  size_t   size   = 0;
+  size_t   done   = 0;
+  uint8_t* dst    = nullptr;
+  uint64_t tag    = 0;
+  };
+
+// blocking positional read, loops over short reads until eof
+bool readAt(Native fd, uint64_t offset, uint8_t* dst, size_t size, size_t& done) {
+  while(done<size) {
+#ifdef __WINDOWS__
+    const uint64_t at  = offset+done;
+    OVERLAPPED     ov  = {};
+    ov.Offset          = DWORD(at);
+    ov.OffsetHigh      = DWORD(at>>32);
+    DWORD          cnt = 0;
+    DWORD          req = DWORD(std::min<size_t>(size-done,1u<<30));
+    if(!ReadFile(fd,dst+done,req,&cnt,&ov))
+      return GetLastError()==ERROR_HANDLE_EOF;
+    if(cnt==0)
+      return true;
+    done += cnt;
+#else
+    const ssize_t cnt = pread(fd,dst+done,std::min<size_t>(size-done,1u<<30),off_t(offset+done));
+    if(cnt<0) {
+      if(errno==EINTR)
+        continue;
+      return false;
+      }
+    if(cnt==0)
+      return true;
+    done += size_t(cnt);
+#endif
+    }
+  return true;
+  }
+
+}
+
+struct AsyncReader::Files {
+  mutable std::mutex  sync;
+  std::vector<Native> fd;
+
+  ~Files() {
+    for(auto i:fd)
+      if(i!=invalidNative)
+        closeNative(i);
+    }
+
+  File add(Native h) {
+    std::lock_guard<std::mutex> guard(sync);
+    for(size_t i=0;i<fd.size();++i)
+      if(fd[i]==invalidNative) {
+        fd[i] = h;
+        return File(i);
+        }
+    fd.push_back(h);
+    return File(fd.size()-1);
+    }
+
+  Native get(File f) const {
+    std::lock_guard<std::mutex> guard(sync);
+    if(f<0 || size_t(f)>=fd.size() || fd[size_t(f)]==invalidNative)
+      throw std::system_error(std::make_error_code(std::errc::bad_file_descriptor),"AsyncReader: invalid file");
+    return fd[size_t(f)];
+    }
+
+  void remove(File f) {
+    std::lock_guard<std::mutex> guard(sync);
+    if(f<0 || size_t(f)>=fd.size() || fd[size_t(f)]==invalidNative)
+      return;
+    closeNative(fd[size_t(f)]);
+    fd[size_t(f)] = invalidNative;
+    }
+
+  static void closeNative(Native h) {
+#ifdef __WINDOWS__
+    CloseHandle(h);
+#else
+    ::close(h);
+#endif
+    }
+  };
+
+struct AsyncReader::Backend {
+  virtual ~Backend()=default;
+  virtual void   submit(const Request& r)=0;
+  virtual size_t reap(Completion* out, size_t max, bool block)=0;
+  virtual size_t inFlight() const=0;
+  virtual bool   isIoUring() const { return false; }
+  };
+
+struct AsyncReader::Pool : AsyncReader::Backend {
+  Pool() {
+    const uint32_t cnt = std::max(1u,std::min(4u,std::thread::hardware_concurrency()));
+    for(uint32_t i=0;i<cnt;++i)
+      th.emplace_back([this]() noexcept { threadFunc(); });
+    }
+
+  ~Pool() override {
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    exit = true;
+    }
+    work.notify_all();
+    for(auto& i:th)
+      i.join();
+    }
+
+  void submit(const Request& r) override {
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    queue.push_back(r);
+    ++flight;
+    }
+    work.notify_one();
+    }
+
+  size_t reap(Completion* out, size_t max, bool block) override {
+    std::unique_lock<std::mutex> guard(sync);
+    if(block)
+      done.wait(guard,[this](){ return !ready.empty() || flight==0; });
+    const size_t n = std::min(max,ready.size());
+    std::copy(ready.begin(),ready.begin()+ptrdiff_t(n),out);
+    ready.erase(ready.begin(),ready.begin()+ptrdiff_t(n));
+    flight -= n;
+    return n;
+    }
+
+  size_t inFlight() const override {
+    std::lock_guard<std::mutex> guard(sync);
+    return flight;
+    }
+
+  void threadFunc() {
+    while(true) {
+      Request r;
+      {
+      std::unique_lock<std::mutex> guard(sync);
+      work.wait(guard,[this](){ return exit || !queue.empty(); });
+      if(queue.empty())
+        return;
+      r = queue.front();
+      queue.pop_front();
+      }
+
+      Completion c;
+      c.tag  = r.tag;
+      c.ok   = readAt(r.fd,r.offset,r.dst,r.size,r.done);
+      c.size = r.done;
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      ready.push_back(c);
+      }
+      done.notify_all();
+      }
+    }
+
+  mutable std::mutex       sync;
+  std::condition_variable  work, done;
+  std::deque<Request>      queue;
+  std::vector<Completion>  ready;
+  size_t                   flight = 0;
+  bool                     exit   = false;
+  std::vector<std::thread> th;
+  };
+
+#ifdef TEMPEST_IO_URING
+struct AsyncReader::Uring : AsyncReader::Backend {
+  // returns nullptr, if kernel has no io_uring or no IORING_OP_READ (pre 5.6)
+  static std::unique_ptr<Uring> create(uint32_t depth) {
+    std::unique_ptr<Uring> u(new Uring());
+    if(!u->init(depth))
+      return nullptr;
+    return u;
+    }
+
+  ~Uring() override {
+    if(sqes!=nullptr)
+      munmap(sqes,sqesSz);
+    if(cqMap!=nullptr && cqMap!=sqMap)
+      munmap(cqMap,cqMapSz);
+    if(sqMap!=nullptr)
+      munmap(sqMap,sqMapSz);
+    if(ring>=0)
+      ::close(ring);
+    }
+
+  bool init(uint32_t depth) {
+    io_uring_params p = {};
+    ring = int(syscall(__NR_io_uring_setup,std::max(depth,4u),&p));
+    if(ring<0)
+      return false;
+
+    const size_t probeSz = sizeof(io_uring_probe)+256*sizeof(io_uring_probe_op);
+    std::unique_ptr<uint8_t[]> pb(new uint8_t[probeSz]());
+    auto probe = reinterpret_cast<io_uring_probe*>(pb.get());
+    if(syscall(__NR_io_uring_register,ring,IORING_REGISTER_PROBE,probe,256)<0)
+      return false;
+    if(probe->last_op<IORING_OP_READ || (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)==0)
+      return false;
+
+    sqMapSz = p.sq_off.array + p.sq_entries*sizeof(uint32_t);
+    cqMapSz = p.cq_off.cqes  + p.cq_entries*sizeof(io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+      sqMapSz = cqMapSz = std::max(sqMapSz,cqMapSz);
+
+    sqMap = mmap(nullptr,sqMapSz,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring,IORING_OFF_SQ_RING);
+    if(sqMap==MAP_FAILED) {
+      sqMap = nullptr;
+      return false;
+      }
+    if(p.features & IORING_FEAT_SINGLE_MMAP) {
+      cqMap = sqMap;
+      } else {
+      cqMap = mmap(nullptr,cqMapSz,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring,IORING_OFF_CQ_RING);
+      if(cqMap==MAP_FAILED) {
+        cqMap = nullptr;
+        return false;
+        }
+      }
+    sqesSz = p.sq_entries*sizeof(io_uring_sqe);
+    void* s = mmap(nullptr,sqesSz,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring,IORING_OFF_SQES);
+    if(s==MAP_FAILED)
+      return false;
+    sqes = reinterpret_cast<io_uring_sqe*>(s);
+
+    auto sq = reinterpret_cast<uint8_t*>(sqMap);
+    auto cq = reinterpret_cast<uint8_t*>(cqMap);
+    sqHead    = reinterpret_cast<uint32_t*>(sq+p.sq_off.head);
+    sqTail    = reinterpret_cast<uint32_t*>(sq+p.sq_off.tail);
+    sqMask    = *reinterpret_cast<uint32_t*>(sq+p.sq_off.ring_mask);
+    sqArray   = reinterpret_cast<uint32_t*>(sq+p.sq_off.array);
+    sqEntries = p.sq_entries;
+    cqHead    = reinterpret_cast<uint32_t*>(cq+p.cq_off.head);
+    cqTail    = reinterpret_cast<uint32_t*>(cq+p.cq_off.tail);
+    cqMask    = *reinterpret_cast<uint32_t*>(cq+p.cq_off.ring_mask);
+    cqes      = reinterpret_cast<io_uring_cqe*>(cq+p.cq_off.cqes);
+    return true;
+    }
+
+  void submit(const Request& r) override {
+    std::lock_guard<std::mutex> guard(sync);
+    uint32_t id = 0;
+    if(!freeSlots.empty()) {
+      id = freeSlots.back();
+      freeSlots.pop_back();
+      slots[id] = r;
+      } else {
+      id = uint32_t(slots.size());
+      slots.push_back(r);
+      }
+    backlog.push_back(id);
+    ++flight;
+    flush();
+    }
+
+  size_t reap(Completion* out, size_t max, bool block) override {
+    std::unique_lock<std::mutex> guard(sync);
+    while(true) {
+      if(!waiting)
+        drain();
+      if(!ready.empty() || !block || flight==0)
+        break;
+      if(waiting) {
+        // another thread sleeps in kernel, it will drain for everyone
+        cv.wait(guard);
+        continue;
+        }
+      if(unsubmitted>0)
+        flush();
+      if(!ready.empty())
+        continue;
+      if(inKernel==unsubmitted) {
+        // nothing, that kernel could complete: sleeping in io_uring_enter would never return
+        guard.unlock();
+        std::this_thread::yield();
+        guard.lock();
+        continue;
+        }
+      waiting = true;
+      guard.unlock();
+      const long ret = syscall(__NR_io_uring_enter,ring,0,1,IORING_ENTER_GETEVENTS,nullptr,0);
+      const int  err = errno;
+      guard.lock();
+      waiting = false;
+      drain();
+      cv.notify_all();
+      if(ret<0 && err!=EINTR && err!=EAGAIN && err!=EBUSY) {
+        Log::e("AsyncReader: io_uring_enter failed: ",std::strerror(err));
+        break;
+        }
+      }
+
+    const size_t n = std::min(max,ready.size());
+    std::copy(ready.begin(),ready.begin()+ptrdiff_t(n),out);
+    ready.erase(ready.begin(),ready.begin()+ptrdiff_t(n));
+    flight -= n;
+    return n;
+    }
+
+  size_t inFlight() const override {
+    std::lock_guard<std::mutex> guard(sync);
+    return flight;
+    }
+
+  bool isIoUring() const override {
+    return true;
+    }
+
+  // move backlog into submission queue, keep no more than sqEntries requests inside kernel
+  void flush() {
+    uint32_t tail = *sqTail;
+    uint32_t cnt  = 0;
+    while(!backlog.empty() && inKernel<sqEntries) {
+      const uint32_t id  = backlog.front();
+      const Request& r   = slots[id];
+      const uint32_t idx = tail & sqMask;
+      io_uring_sqe&  sqe = sqes[idx];
+      sqe = io_uring_sqe();
+      sqe.opcode    = IORING_OP_READ;
+      sqe.fd        = r.fd;
+      sqe.off       = r.offset+r.done;
+      sqe.addr      = uint64_t(reinterpret_cast<uintptr_t>(r.dst+r.done));
+      sqe.len       = uint32_t(std::min<size_t>(r.size-r.done,1u<<30));
+      sqe.user_data = id;
+      sqArray[idx]  = idx;
+      backlog.pop_front();
+      ++tail;
+      ++cnt;
+      ++inKernel;
+      }
+    if(cnt>0)
+      __atomic_store_n(sqTail,tail,__ATOMIC_RELEASE);
+    cnt += unsubmitted;
+    if(cnt==0)
+      return;
+    // kernel may take fewer entries (EAGAIN/EBUSY), rest goes with next enter
+    const long ret = syscall(__NR_io_uring_enter,ring,cnt,0,0,nullptr,0);
+    if(ret>=0) {
+      unsubmitted = cnt-uint32_t(ret);
+      return;
+      }
+    const int err = errno;
+    if(err==EAGAIN || err==EBUSY || err==EINTR) {
+      unsubmitted = cnt;
+      return;
+      }
+    Log::e("AsyncReader: io_uring_enter failed to submit: ",std::strerror(err));
+    failPending();
+    }
+
+  // submission is broken: fail requests, that kernel has not consumed
+  void failPending() {
+    const uint32_t head = __atomic_load_n(sqHead,__ATOMIC_ACQUIRE);
+    const uint32_t tail = *sqTail;
+    for(uint32_t i=head;i!=tail;++i) {
+      const uint32_t id = uint32_t(sqes[sqArray[i & sqMask]].user_data);
+      --inKernel;
+      fail(id);
+      }
+    __atomic_store_n(sqTail,head,__ATOMIC_RELEASE);
+    unsubmitted = 0;
+
+    for(auto id:backlog)
+      fail(id);
+    backlog.clear();
+    }
+
+  void fail(uint32_t id) {
+    Completion c;
+    c.tag  = slots[id].tag;
+    c.ok   = false;
+    c.size = slots[id].done;
+    ready.push_back(c);
+    freeSlots.push_back(id);
+    }
+
+  void drain() {
+    uint32_t head = *cqHead;
+    uint32_t tail = __atomic_load_n(cqTail,__ATOMIC_ACQUIRE);
+    for(;head!=tail;++head) {
+      const io_uring_cqe& cqe = cqes[head & cqMask];
+      const uint32_t      id  = uint32_t(cqe.user_data);
+      Request&            r   = slots[id];
+      --inKernel;
+
+      if(cqe.res==-EAGAIN || cqe.res==-EINTR || (cqe.res>0 && r.done+size_t(cqe.res)<r.size)) {
+        // short read, not at eof yet
+        if(cqe.res>0)
+          r.done += size_t(cqe.res);
+        backlog.push_front(id);
+        continue;
+        }
+
+      Completion c;
+      c.tag  = r.tag;
+      c.ok   = cqe.res>=0;
+      c.size = r.done + (cqe.res>0 ? size_t(cqe.res) : 0);
+      ready.push_back(c);
+      freeSlots.push_back(id);
+      }
+    __atomic_store_n(cqHead,head,__ATOMIC_RELEASE);
+    // slots were freed in kernel, push more of backlog
+    if(!backlog.empty())
+      flush();
+    }
+
+  mutable std::mutex      sync;
+  std::condition_variable cv;
+  bool                    waiting  = false;
+
+  int                     ring     = -1;
+  void*                   sqMap    = nullptr;
+  size_t                  sqMapSz  = 0;
+  void*                   cqMap    = nullptr;
+  size_t                  cqMapSz  = 0;
+  io_uring_sqe*           sqes     = nullptr;
+  size_t                  sqesSz   = 0;
+
+  uint32_t*               sqHead   = nullptr;
+  uint32_t*               sqTail   = nullptr;
+  uint32_t*               sqArray  = nullptr;
+  uint32_t                sqMask   = 0;
+  uint32_t                sqEntries= 0;
+  uint32_t*               cqHead   = nullptr;
+  uint32_t*               cqTail   = nullptr;
+  uint32_t                cqMask   = 0;
+  io_uring_cqe*           cqes     = nullptr;
+
+  std::vector<Request>    slots;
+  std::vector<uint32_t>   freeSlots;
+  std::deque<uint32_t>    backlog;
+  std::vector<Completion> ready;
+  uint32_t                inKernel    = 0;
+  uint32_t                unsubmitted = 0;
+  size_t                  flight      = 0;
+  };
+#endif
+
+AsyncReader::AsyncReader(uint32_t queueDepth)
+  :files(new Files()) {
+#ifdef TEMPEST_IO_URING
+  impl = Uring::create(queueDepth);
+#else
+  (void)queueDepth;
+#endif
+  if(impl==nullptr)
+    impl.reset(new Pool());
+  }
+
+AsyncReader::~AsyncReader() {
+  // backend stops before files are closed
+  impl.reset();
+  }
+
+AsyncReader::File AsyncReader::open(const char* path) {
+#ifdef __WINDOWS__
+  std::wstring wpath;
+  const int len=MultiByteToWideChar(CP_UTF8,0,path,-1,nullptr,0);
+  if(len>1){
+    wpath.resize(size_t(len-1));
+    MultiByteToWideChar(CP_UTF8,0,path,-1,&wpath[0],int(wpath.size()));
+    }
+  Native h = CreateFileW(wpath.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+#else
+  Native h = ::open(path,O_RDONLY|O_CLOEXEC);
+#endif
+  if(h==invalidNative)
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+  return files->add(h);
+  }
+
+AsyncReader::File AsyncReader::open(const std::string& path) {
+  return open(path.c_str());
+  }
+
+AsyncReader::File AsyncReader::open(const char16_t* path) {
+  return open(TextCodec::toUtf8(path));
+  }
+
+AsyncReader::File AsyncReader::open(const std::u16string& path) {
+  return open(path.c_str());
+  }
+
+void AsyncReader::close(File f) {
+  files->remove(f);
+  }
+
+size_t AsyncReader::size(File f) const {
+  Native h = files->get(f);
+#ifdef __WINDOWS__
+  LARGE_INTEGER sz = {};
+  if(!GetFileSizeEx(h,&sz))
+    return 0;
+  return size_t(sz.QuadPart);
+#else
+  struct stat st = {};
+  if(fstat(h,&st)!=0)
+    return 0;
+  return size_t(st.st_size);
+#endif
+  }
+
+void AsyncReader::submit(File f, uint64_t offset, size_t size, void* dst, uint64_t tag) {
+  Request r;
+  r.fd     = files->get(f);
+  r.offset = offset;
+  r.size   = size;
+  r.dst    = reinterpret_cast<uint8_t*>(dst);
+  r.tag    = tag;
+  impl->submit(r);
+  }
+
+size_t AsyncReader::poll(Completion* out, size_t max) {
+  return impl->reap(out,max,false);
+  }
+
+size_t AsyncReader::wait(Completion* out, size_t max) {
+  return impl->reap(out,max,true);
+  }
+
+size_t AsyncReader::inFlight() const {
+  return impl->inFlight();
+  }
+
+bool AsyncReader::isIoUring() const {
+  return impl->isIoUring();
+  }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Tempest/Platform>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Tempest {
+
+// batched asynchronous file reads: io_uring on linux, thread pool everywhere else
+// submit/poll/wait can be called from any thread
+class AsyncReader final {
+  public:
+    using File = int32_t;
+
+    struct Completion {
+      uint64_t tag    = 0;
+      size_t   size   = 0;     // bytes read, less than requested at end of file
+      bool     ok     = false;
+      };
+
+    explicit AsyncReader(uint32_t queueDepth=64);
+    AsyncReader(const AsyncReader&)=delete;
+    AsyncReader& operator = (const AsyncReader&)=delete;
+    ~AsyncReader();
+
+    File     open (const char*           path);
+    File     open (const std::string&    path);
+    File     open (const char16_t*       path);
+    File     open (const std::u16string& path);
+    // file must not have requests in flight
+    void     close(File f);
+    size_t   size (File f) const;
+
+    // dst must stay valid until completion for tag is returned
+    void     submit(File f, uint64_t offset, size_t size, void* dst, uint64_t tag);
+
+    // non-blocking; returns number of completions written to out
+    size_t   poll(Completion* out, size_t max);
+    // blocks until at least one completion is available, returns 0 if nothing is in flight
+    size_t   wait(Completion* out, size_t max);
+
+    size_t   inFlight() const;
+    bool     isIoUring() const;
+
+  private:
+    struct Backend;
+    struct Pool;
+    struct Uring;
+    struct Files;
+
+    std::unique_ptr<Files>   files;
+    std::unique_ptr<Backend> impl;
+  };
+
+}
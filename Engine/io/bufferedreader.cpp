@@ -0,0 +1,88 @@
+#include "bufferedreader.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tempest;
+
+BufferedReader::BufferedReader(IDevice& src, size_t bufSize)
+  :src(src), buf(new uint8_t[std::max<size_t>(bufSize,256)]), bufSize(std::max<size_t>(bufSize,256)) {
+  }
+
+BufferedReader::~BufferedReader() {
+  // best effort: destructor has no way to report
+  const size_t ahead = avail-pos;
+  if(ahead>0)
+    src.unget(ahead);
+  }
+
+bool BufferedReader::fill() {
+  // keep tail of consumed data, so short unget after refill doesn't hit the device
+  const size_t keep = std::min<size_t>(pos,bufSize/8);
+  std::memmove(buf.get(),buf.get()+pos-keep,keep);
+  pos   = keep;
+  avail = keep + src.read(buf.get()+keep,bufSize-keep);
+  return avail>pos;
+  }
+
+size_t BufferedReader::read(void* to, size_t size) {
+  uint8_t* dst = reinterpret_cast<uint8_t*>(to);
+  size_t   ret = 0;
+  while(size>0) {
+    if(pos==avail) {
+      if(size>=bufSize) {
+        // large read: no point to copy twice
+        const size_t n = src.read(dst,size);
+        avail = pos = 0;
+        return ret+n;
+        }
+      if(!fill())
+        break;
+      }
+    const size_t n = std::min(size,avail-pos);
+    std::memcpy(dst,buf.get()+pos,n);
+    pos  += n;
+    dst  += n;
+    ret  += n;
+    size -= n;
+    }
+  return ret;
+  }
+
+size_t BufferedReader::size() const {
+  return src.size();
+  }
+
+uint8_t BufferedReader::peek() {
+  if(pos==avail && !fill())
+    return 0;
+  return buf[pos];
+  }
+
+size_t BufferedReader::seek(size_t advance) {
+  const size_t ahead = avail-pos;
+  if(advance<=ahead) {
+    pos += advance;
+    return advance;
+    }
+  avail = pos = 0;
+  return ahead + src.seek(advance-ahead);
+  }
+
+size_t BufferedReader::unget(size_t advance) {
+  if(advance<=pos) {
+    pos -= advance;
+    return advance;
+    }
+  // beyond buffered window: rewind device to the logical cursor and drop the buffer
+  const size_t ahead = avail-pos;
+  const size_t back  = src.unget(ahead+advance);
+  if(back<ahead) {
+    // device can't rewind that far: restore cursor and keep buffer as is
+    if(src.seek(back)!=back)
+      avail = pos = 0;
+    return 0;
+    }
+  avail = pos = 0;
+  return back-ahead;
+  }
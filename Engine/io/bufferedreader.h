@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Tempest/IDevice>
+
+#include <memory>
+
+namespace Tempest {
+
+// read-ahead wrapper over any IDevice: peek, unget and small reads are served from memory
+// bytes fetched, but not consumed, are given back to the source device on destruction
+class BufferedReader : public IDevice {
+  public:
+    explicit BufferedReader(IDevice& src, size_t bufSize=64*1024);
+    ~BufferedReader() override;
+
+    size_t  read(void* to,size_t size) override;
+    size_t  size() const override;
+
+    uint8_t peek() override;
+    size_t  seek(size_t advance) override;
+    size_t  unget(size_t advance) override;
+
+    IDevice& device() { return src; }
+
+  private:
+    bool    fill();
+
+    IDevice&                   src;
+    std::unique_ptr<uint8_t[]> buf;
+    size_t                     bufSize = 0;
+    size_t                     avail   = 0;
+    size_t                     pos     = 0;
+  };
+
+}
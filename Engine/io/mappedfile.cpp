@@ -0,0 +1,169 @@
+#include "mappedfile.h"
+
+#include <Tempest/TextCodec>
+#include <Tempest/Except>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tempest;
+
+MappedFile::MappedFile(const char *name) {
+#ifdef __WINDOWS__
+  std::wstring path;
+  const int len=MultiByteToWideChar(CP_UTF8,0,name,-1,nullptr,0);
+  if(len>1){
+    path.resize(size_t(len-1));
+    MultiByteToWideChar(CP_UTF8,0,name,-1,&path[0],int(path.size()));
+    }
+  implOpen(path.c_str());
+#else
+  implOpen(name);
+#endif
+  }
+
+MappedFile::MappedFile(const std::string &path)
+  :MappedFile(path.c_str()){
+  }
+
+MappedFile::MappedFile(const char16_t *path) {
+#ifdef __WINDOWS__
+  implOpen(reinterpret_cast<const wchar_t*>(path));
+#else
+  implOpen(TextCodec::toUtf8(path).c_str());
+#endif
+  }
+
+MappedFile::MappedFile(const std::u16string &path)
+  :MappedFile(path.c_str()){
+  }
+
+MappedFile::MappedFile(MappedFile &&other)
+  :ptr(other.ptr), sz(other.sz), pos(other.pos) {
+#ifdef __WINDOWS__
+  mapping       = other.mapping;
+  other.mapping = nullptr;
+#endif
+  other.ptr = nullptr;
+  other.sz  = 0;
+  other.pos = 0;
+  }
+
+MappedFile::~MappedFile() {
+  implClose();
+  }
+
+MappedFile &MappedFile::operator =(MappedFile &&other) {
+  std::swap(ptr,other.ptr);
+  std::swap(sz, other.sz);
+  std::swap(pos,other.pos);
+#ifdef __WINDOWS__
+  std::swap(mapping,other.mapping);
+#endif
+  return *this;
+  }
+
+#ifdef __WINDOWS__
+void MappedFile::implOpen(const wchar_t *wstr) {
+  HANDLE fn = CreateFileW(wstr,GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+  if(fn==HANDLE(LONG_PTR(-1)))
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+
+  LARGE_INTEGER fsz={};
+  if(!GetFileSizeEx(fn,&fsz)) {
+    CloseHandle(fn);
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+    }
+  sz = size_t(fsz.QuadPart);
+  if(sz==0) {
+    // empty files can't be mapped
+    CloseHandle(fn);
+    return;
+    }
+
+  mapping = CreateFileMappingW(fn,nullptr,PAGE_READONLY,0,0,nullptr);
+  CloseHandle(fn);
+  if(mapping==nullptr)
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+
+  ptr = reinterpret_cast<const uint8_t*>(MapViewOfFile(HANDLE(mapping),FILE_MAP_READ,0,0,0));
+  if(ptr==nullptr) {
+    CloseHandle(HANDLE(mapping));
+    mapping = nullptr;
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+    }
+  }
+
+void MappedFile::implClose() {
+  if(ptr!=nullptr)
+    UnmapViewOfFile(ptr);
+  if(mapping!=nullptr)
+    CloseHandle(HANDLE(mapping));
+  }
+#else
+void MappedFile::implOpen(const char *cstr) {
+  int fd = open(cstr,O_RDONLY|O_CLOEXEC);
+  if(fd<0)
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+
+  struct stat st={};
+  if(fstat(fd,&st)!=0) {
+    close(fd);
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+    }
+  sz = size_t(st.st_size);
+  if(sz==0) {
+    // empty files can't be mapped
+    close(fd);
+    return;
+    }
+
+  void* p = mmap(nullptr,sz,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(p==MAP_FAILED) {
+    sz = 0;
+    throw std::system_error(Tempest::SystemErrc::UnableToOpenFile);
+    }
+  ptr = reinterpret_cast<const uint8_t*>(p);
+  }
+
+void MappedFile::implClose() {
+  if(ptr!=nullptr)
+    munmap(const_cast<uint8_t*>(ptr),sz);
+  }
+#endif
+
+size_t MappedFile::read(void *dest, size_t count) {
+  size_t c = std::min(count, sz-pos);
+  if(c>0)
+    std::memcpy(dest, ptr+pos, c);
+  pos+=c;
+  return c;
+  }
+
+uint8_t MappedFile::peek() {
+  if(pos==sz)
+    return 0;
+  return ptr[pos];
+  }
+
+size_t MappedFile::seek(size_t advance) {
+  size_t c = std::min(advance, sz-pos);
+  pos += c;
+  return c;
+  }
+
+size_t MappedFile::unget(size_t advance) {
+  size_t c = std::min(advance, pos);
+  pos -= c;
+  return c;
+  }
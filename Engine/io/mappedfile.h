@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Tempest/IDevice>
+#include <Tempest/Platform>
+#include <string>
+
+namespace Tempest {
+
+// read-only file, mapped into address space; data() gives direct access to the whole file
+class MappedFile : public Tempest::IDevice {
+  public:
+    explicit MappedFile(const char*     path);
+    explicit MappedFile(const std::string& path);
+    explicit MappedFile(const char16_t* path);
+    explicit MappedFile(const std::u16string& path);
+    MappedFile(MappedFile&& other);
+    ~MappedFile() override;
+
+    MappedFile& operator = (MappedFile&& other);
+
+    size_t  read(void* to,size_t size) override;
+    size_t  size() const override { return sz; }
+
+    uint8_t peek() override;
+    size_t  seek(size_t advance) override;
+    size_t  unget(size_t advance) override;
+
+    const uint8_t* data() const { return ptr; }
+    size_t         cursorPosition() const { return pos; }
+
+  private:
+    const uint8_t* ptr=nullptr;
+    size_t         sz=0, pos=0;
+#ifdef __WINDOWS__
+    void*          mapping=nullptr;
+    void           implOpen(const wchar_t* wstr);
+#else
+    void           implOpen(const char* cstr);
+#endif
+    void           implClose();
+  };
+
+}
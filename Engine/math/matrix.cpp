@@ -3,11 +3,20 @@
 #include <cmath>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define TEMPEST_MATH_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TEMPEST_MATH_NEON
+#include <arm_neon.h>
+#endif
+
 //#include <thirdparty/nv_math/nv_matrix.h>
 // code is based on NvMath
 #define KD_FLT_EPSILON 1.19209290E-07F
 #define KD_DEG_TO_RAD_F 0.0174532924F
 
+#if !defined(TEMPEST_MATH_SSE)
 static void NvInvMat4x4f(float r[4][4], const float m[4][4])
 {
     float d =
@@ -150,129 +159,167 @@ static void NvInvMat4x4f(float r[4][4], const float m[4][4])
                -m[0][1] * m[1][0] * m[2][2] +
                -m[0][2] * m[1][1] * m[2][0]) / d;
 }
+#endif
+
+namespace {
+
+// 4-wide float vector over sse/neon, plain floats elsewhere
+#if defined(TEMPEST_MATH_SSE)
+using F4 = __m128;
+
+inline F4   load (const float* p)      { return _mm_loadu_ps(p); }
+inline void store(float* p, F4 v)      { _mm_storeu_ps(p,v);     }
+inline F4   splat(float v)             { return _mm_set1_ps(v);  }
+inline F4   vadd (F4 a, F4 b)          { return _mm_add_ps(a,b); }
+inline F4   vmul (F4 a, F4 b)          { return _mm_mul_ps(a,b); }
+inline F4   vmadd(F4 a, F4 b, F4 c)    { return _mm_add_ps(_mm_mul_ps(a,b),c); }
+inline F4   vmin (F4 a, F4 b)          { return _mm_min_ps(a,b); }
+inline F4   vmax (F4 a, F4 b)          { return _mm_max_ps(a,b); }
+#elif defined(TEMPEST_MATH_NEON)
+using F4 = float32x4_t;
+
+inline F4   load (const float* p)      { return vld1q_f32(p);     }
+inline void store(float* p, F4 v)      { vst1q_f32(p,v);          }
+inline F4   splat(float v)             { return vdupq_n_f32(v);   }
+inline F4   vadd (F4 a, F4 b)          { return vaddq_f32(a,b);   }
+inline F4   vmul (F4 a, F4 b)          { return vmulq_f32(a,b);   }
+inline F4   vmadd(F4 a, F4 b, F4 c)    { return vmlaq_f32(c,a,b); }
+inline F4   vmin (F4 a, F4 b)          { return vminq_f32(a,b);   }
+inline F4   vmax (F4 a, F4 b)          { return vmaxq_f32(a,b);   }
+#else
+struct F4 { float v[4]; };
+
+inline F4   load (const float* p)      { F4 r; std::memcpy(r.v,p,sizeof(r.v)); return r; }
+inline void store(float* p, F4 v)      { std::memcpy(p,v.v,sizeof(v.v)); }
+inline F4   splat(float v)             { return F4{{v,v,v,v}}; }
+inline F4   vadd (F4 a, F4 b)          { for(int i=0;i<4;++i) a.v[i]+=b.v[i]; return a; }
+inline F4   vmul (F4 a, F4 b)          { for(int i=0;i<4;++i) a.v[i]*=b.v[i]; return a; }
+inline F4   vmadd(F4 a, F4 b, F4 c)    { for(int i=0;i<4;++i) c.v[i]+=a.v[i]*b.v[i]; return c; }
+inline F4   vmin (F4 a, F4 b)          { for(int i=0;i<4;++i) a.v[i]=std::min(a.v[i],b.v[i]); return a; }
+inline F4   vmax (F4 a, F4 b)          { for(int i=0;i<4;++i) a.v[i]=std::max(a.v[i],b.v[i]); return a; }
+#endif
+
+// matrix is column-major: m[col][row]
+struct Cols {
+  explicit Cols(const float m[4][4]):c0(load(m[0])),c1(load(m[1])),c2(load(m[2])),c3(load(m[3])) {}
+
+  F4 apply(float x, float y, float z, float w) const {
+    return vmadd(c3,splat(w),vmadd(c2,splat(z),vmadd(c1,splat(y),vmul(c0,splat(x)))));
+    }
+  F4 apply(float x, float y, float z) const {
+    return vmadd(c2,splat(z),vmadd(c1,splat(y),vmadd(c0,splat(x),c3)));
+    }
 
-static void NvMultMat3x3f(float r[4][4], const float a[4][4], const float b[4][4])
-{
-    //assert(NvDifferentMatsf(r, a) && NvDifferentMatsf(r, b));
-
-    r[0][0] = a[0][0]*b[0][0] + a[1][0]*b[0][1] + a[2][0]*b[0][2];
-    r[0][1] = a[0][1]*b[0][0] + a[1][1]*b[0][1] + a[2][1]*b[0][2];
-    r[0][2] = a[0][2]*b[0][0] + a[1][2]*b[0][1] + a[2][2]*b[0][2];
-    r[0][3] = 0.0f;
-
-    r[1][0] = a[0][0]*b[1][0] + a[1][0]*b[1][1] + a[2][0]*b[1][2];
-    r[1][1] = a[0][1]*b[1][0] + a[1][1]*b[1][1] + a[2][1]*b[1][2];
-    r[1][2] = a[0][2]*b[1][0] + a[1][2]*b[1][1] + a[2][2]*b[1][2];
-    r[1][3] = 0.0f;
-
-    r[2][0] = a[0][0]*b[2][0] + a[1][0]*b[2][1] + a[2][0]*b[2][2];
-    r[2][1] = a[0][1]*b[2][0] + a[1][1]*b[2][1] + a[2][1]*b[2][2];
-    r[2][2] = a[0][2]*b[2][0] + a[1][2]*b[2][1] + a[2][2]*b[2][2];
-    r[2][3] = 0.0f;
-
-    r[3][0] = 0.0f;
-    r[3][1] = 0.0f;
-    r[3][2] = 0.0f;
-    r[3][3] = 1.0f;
-}
+  F4 c0, c1, c2, c3;
+  };
 
-static void NvMultMat4x3f(float r[4][4], const float a[4][4], const float b[4][4])
-{
-    //assert(NvDifferentMatsf(r, a) && NvDifferentMatsf(r, b));
-
-    r[0][0] = a[0][0]*b[0][0] + a[1][0]*b[0][1] + a[2][0]*b[0][2];
-    r[0][1] = a[0][1]*b[0][0] + a[1][1]*b[0][1] + a[2][1]*b[0][2];
-    r[0][2] = a[0][2]*b[0][0] + a[1][2]*b[0][1] + a[2][2]*b[0][2];
-    r[0][3] = 0.0f;
-
-    r[1][0] = a[0][0]*b[1][0] + a[1][0]*b[1][1] + a[2][0]*b[1][2];
-    r[1][1] = a[0][1]*b[1][0] + a[1][1]*b[1][1] + a[2][1]*b[1][2];
-    r[1][2] = a[0][2]*b[1][0] + a[1][2]*b[1][1] + a[2][2]*b[1][2];
-    r[1][3] = 0.0f;
-
-    r[2][0] = a[0][0]*b[2][0] + a[1][0]*b[2][1] + a[2][0]*b[2][2];
-    r[2][1] = a[0][1]*b[2][0] + a[1][1]*b[2][1] + a[2][1]*b[2][2];
-    r[2][2] = a[0][2]*b[2][0] + a[1][2]*b[2][1] + a[2][2]*b[2][2];
-    r[2][3] = 0.0f;
-
-    r[3][0] = a[0][0]*b[3][0] + a[1][0]*b[3][1] + a[2][0]*b[3][2] + a[3][0];
-    r[3][1] = a[0][1]*b[3][0] + a[1][1]*b[3][1] + a[2][1]*b[3][2] + a[3][1];
-    r[3][2] = a[0][2]*b[3][0] + a[1][2]*b[3][1] + a[2][2]*b[3][2] + a[3][2];
-    r[3][3] = 1.0f;
-}
+void mulMat(float r[4][4], const float a[4][4], const float b[4][4]) {
+  // r may alias a or b: columns of a are in registers and b is read before r[i] is written
+  const Cols ca(a);
+  for(int i=0;i<4;++i)
+    store(r[i],ca.apply(b[i][0],b[i][1],b[i][2],b[i][3]));
+  }
 
-static void NvMultMat4x4f(float r[4][4], const float a[4][4], const float b[4][4])
-{
-    //assert(NvDifferentMatsf(r, a) && NvDifferentMatsf(r, b));
-
-    r[0][0] = a[0][0]*b[0][0]+a[1][0]*b[0][1]+a[2][0]*b[0][2]+a[3][0]*b[0][3];
-    r[0][1] = a[0][1]*b[0][0]+a[1][1]*b[0][1]+a[2][1]*b[0][2]+a[3][1]*b[0][3];
-    r[0][2] = a[0][2]*b[0][0]+a[1][2]*b[0][1]+a[2][2]*b[0][2]+a[3][2]*b[0][3];
-    r[0][3] = a[0][3]*b[0][0]+a[1][3]*b[0][1]+a[2][3]*b[0][2]+a[3][3]*b[0][3];
-
-    r[1][0] = a[0][0]*b[1][0]+a[1][0]*b[1][1]+a[2][0]*b[1][2]+a[3][0]*b[1][3];
-    r[1][1] = a[0][1]*b[1][0]+a[1][1]*b[1][1]+a[2][1]*b[1][2]+a[3][1]*b[1][3];
-    r[1][2] = a[0][2]*b[1][0]+a[1][2]*b[1][1]+a[2][2]*b[1][2]+a[3][2]*b[1][3];
-    r[1][3] = a[0][3]*b[1][0]+a[1][3]*b[1][1]+a[2][3]*b[1][2]+a[3][3]*b[1][3];
-
-    r[2][0] = a[0][0]*b[2][0]+a[1][0]*b[2][1]+a[2][0]*b[2][2]+a[3][0]*b[2][3];
-    r[2][1] = a[0][1]*b[2][0]+a[1][1]*b[2][1]+a[2][1]*b[2][2]+a[3][1]*b[2][3];
-    r[2][2] = a[0][2]*b[2][0]+a[1][2]*b[2][1]+a[2][2]*b[2][2]+a[3][2]*b[2][3];
-    r[2][3] = a[0][3]*b[2][0]+a[1][3]*b[2][1]+a[2][3]*b[2][2]+a[3][3]*b[2][3];
-
-    r[3][0] = a[0][0]*b[3][0]+a[1][0]*b[3][1]+a[2][0]*b[3][2]+a[3][0]*b[3][3];
-    r[3][1] = a[0][1]*b[3][0]+a[1][1]*b[3][1]+a[2][1]*b[3][2]+a[3][1]*b[3][3];
-    r[3][2] = a[0][2]*b[3][0]+a[1][2]*b[3][1]+a[2][2]*b[3][2]+a[3][2]*b[3][3];
-    r[3][3] = a[0][3]*b[3][0]+a[1][3]*b[3][1]+a[2][3]*b[3][2]+a[3][3]*b[3][3];
-}
+void transposeMat(float m[4][4]) {
+#if defined(TEMPEST_MATH_SSE)
+  __m128 r0 = _mm_loadu_ps(m[0]);
+  __m128 r1 = _mm_loadu_ps(m[1]);
+  __m128 r2 = _mm_loadu_ps(m[2]);
+  __m128 r3 = _mm_loadu_ps(m[3]);
+  _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+  _mm_storeu_ps(m[0],r0);
+  _mm_storeu_ps(m[1],r1);
+  _mm_storeu_ps(m[2],r2);
+  _mm_storeu_ps(m[3],r3);
+#elif defined(TEMPEST_MATH_NEON)
+  float32x4x4_t t = vld4q_f32(&m[0][0]);
+  vst1q_f32(m[0],t.val[0]);
+  vst1q_f32(m[1],t.val[1]);
+  vst1q_f32(m[2],t.val[2]);
+  vst1q_f32(m[3],t.val[3]);
+#else
+  for(int i=0; i<4; ++i)
+    for(int r=0; r<i; ++r)
+      std::swap(m[i][r],m[r][i]);
+#endif
+  }
 
-static void NvMultMatf(float result[4][4], const float a[4][4], const float b[4][4])
-{
-    /*
-      Use a temporary matrix for the result and copy the temporary
-      into the result when finished. Doing this instead of writing
-      the result directly guarantees that the routine will work even
-      if the result overlaps one or more of the arguments in
-      memory.
-    */
-
-    float r[4][4];
-
-    if ((a[0][3]==0.0f) &&
-        (a[1][3]==0.0f) &&
-        (a[2][3]==0.0f) &&
-        (a[2][3]==1.0f) &&
-        (b[0][3]==0.0f) &&
-        (b[1][3]==0.0f) &&
-        (b[2][3]==0.0f) &&
-        (b[2][3]==1.0f))
-    {
-        if ((a[3][0]==0.0f) &&
-            (a[3][1]==0.0f) &&
-            (a[3][2]==0.0f) &&
-            (b[3][0]==0.0f) &&
-            (b[3][1]==0.0f) &&
-            (b[3][2]==0.0f))
-        {
-            NvMultMat3x3f(r, a, b);
-        }
-        else
-        {
-            NvMultMat4x3f(r, a, b);
-        }
-    }
-    else
-    {
-         NvMultMat4x4f(r, a, b);
-    }
+#if defined(TEMPEST_MATH_SSE)
+#define SHUF(a,b,x,y,z,w) _mm_shuffle_ps(a,b,_MM_SHUFFLE(w,z,y,x))
+#define SWZ(a,x,y,z,w)    _mm_shuffle_ps(a,a,_MM_SHUFFLE(w,z,y,x))
 
-    std::memcpy(result, r, sizeof(r));
-}
+// 2x2 blocks are stored as (a00,a01,a10,a11)
+inline __m128 mat2Mul(__m128 a, __m128 b) {
+  return _mm_add_ps(_mm_mul_ps(a,SWZ(b,0,3,0,3)), _mm_mul_ps(SWZ(a,1,0,3,2),SWZ(b,2,1,2,1)));
+  }
+// adj(a)*b
+inline __m128 mat2AdjMul(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(SWZ(a,3,3,0,0),b), _mm_mul_ps(SWZ(a,1,1,2,2),SWZ(b,2,3,0,1)));
+  }
+// a*adj(b)
+inline __m128 mat2MulAdj(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(a,SWZ(b,3,0,3,0)), _mm_mul_ps(SWZ(a,1,0,3,2),SWZ(b,2,1,2,1)));
+  }
 
+// block-wise inverse; inverse commutes with transpose, so storage order of m does not matter
+void inverseMat(float r[4][4], const float m[4][4]) {
+  const __m128 v0 = _mm_loadu_ps(m[0]);
+  const __m128 v1 = _mm_loadu_ps(m[1]);
+  const __m128 v2 = _mm_loadu_ps(m[2]);
+  const __m128 v3 = _mm_loadu_ps(m[3]);
+
+  const __m128 A = _mm_movelh_ps(v0,v1);
+  const __m128 B = _mm_movehl_ps(v1,v0);
+  const __m128 C = _mm_movelh_ps(v2,v3);
+  const __m128 D = _mm_movehl_ps(v3,v2);
+
+  // (|A| |B| |C| |D|)
+  const __m128 det = _mm_sub_ps(_mm_mul_ps(SHUF(v0,v2,0,2,0,2),SHUF(v1,v3,1,3,1,3)),
+                                _mm_mul_ps(SHUF(v0,v2,1,3,1,3),SHUF(v1,v3,0,2,0,2)));
+  const __m128 detA = SWZ(det,0,0,0,0);
+  const __m128 detB = SWZ(det,1,1,1,1);
+  const __m128 detC = SWZ(det,2,2,2,2);
+  const __m128 detD = SWZ(det,3,3,3,3);
+
+  const __m128 DC = mat2AdjMul(D,C);
+  const __m128 AB = mat2AdjMul(A,B);
+  __m128 X = _mm_sub_ps(_mm_mul_ps(detD,A),mat2Mul(B,DC));
+  __m128 W = _mm_sub_ps(_mm_mul_ps(detA,D),mat2Mul(C,AB));
+  __m128 Y = _mm_sub_ps(_mm_mul_ps(detB,C),mat2MulAdj(D,AB));
+  __m128 Z = _mm_sub_ps(_mm_mul_ps(detC,B),mat2MulAdj(A,DC));
+
+  // |M| = |A|*|D| + |B|*|C| - tr(adj(A)B * adj(D)C)
+  __m128 tr = _mm_mul_ps(AB,SWZ(DC,0,2,1,3));
+  tr = _mm_add_ps(tr,SWZ(tr,2,3,0,1));
+  tr = _mm_add_ps(tr,SWZ(tr,1,0,3,2));
+  const __m128 detM  = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA,detD),_mm_mul_ps(detB,detC)),tr);
+  const __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.f,-1.f,-1.f,1.f),detM);
+
+  X = _mm_mul_ps(X,rDetM);
+  Y = _mm_mul_ps(Y,rDetM);
+  Z = _mm_mul_ps(Z,rDetM);
+  W = _mm_mul_ps(W,rDetM);
+
+  _mm_storeu_ps(r[0],SHUF(X,Y,3,1,3,1));
+  _mm_storeu_ps(r[1],SHUF(X,Y,2,0,2,0));
+  _mm_storeu_ps(r[2],SHUF(Z,W,3,1,3,1));
+  _mm_storeu_ps(r[3],SHUF(Z,W,2,0,2,0));
+  }
+
+#undef SWZ
+#undef SHUF
+#else
+void inverseMat(float r[4][4], const float m[4][4]) {
+  NvInvMat4x4f(r,m);
+  }
+#endif
+
+}
 
 using namespace Tempest;
 
 static_assert(std::is_trivially_copyable<Matrix4x4>::value,"must be trivial");
+static_assert(sizeof(Vec4)==4*sizeof(float),"Vec4 is expected to be packed");
 
 Matrix4x4::Matrix4x4( const float data[/*16*/] ){
   setData( data );
@@ -440,26 +487,17 @@ void Matrix4x4::setData( const float data[/*16*/]){
   }
 
 void Matrix4x4::transpose(){
-  for( int i=0; i<4; ++i )
-    for( int r=0; r<i; ++r )
-      std::swap( m[i][r], m[r][i] );
+  transposeMat(m);
   }
 
 void Matrix4x4::inverse(){
-  for( int i=0; i<4; ++i )
-    for( int r=0; r<i; ++r )
-      std::swap( m[i][r], m[r][i] );
   float ret[4][4];
-  NvInvMat4x4f( ret, m );
+  inverseMat(ret,m);
   std::memcpy(m,ret,sizeof(ret));
-  //NvInvMatf( m, m );
-  for( int i=0; i<4; ++i )
-    for( int r=0; r<i; ++r )
-      std::swap( m[i][r], m[r][i] );
   }
 
 void Matrix4x4::mul( const Matrix4x4& other ){
-  NvMultMatf( m, m, other.m );
+  mulMat(m,m,other.m);
   }
 
 void Matrix4x4::setData( float a11, float a12, float a13, float a14,
@@ -490,12 +528,12 @@ void Matrix4x4::setData( float a11, float a12, float a13, float a14,
 
 void Matrix4x4::project( float   x, float   y, float   z, float   w,
                          float &ox, float &oy, float &oz, float &ow ) const {
-  float a[4] = {x,y,z,w};
-
-  ox = m[0][0] * a[0] + m[1][0] * a[1] + m[2][0] * a[2] + m[3][0] * a[3];
-  oy = m[0][1] * a[0] + m[1][1] * a[1] + m[2][1] * a[2] + m[3][1] * a[3];
-  oz = m[0][2] * a[0] + m[1][2] * a[1] + m[2][2] * a[2] + m[3][2] * a[3];
-  ow = m[0][3] * a[0] + m[1][3] * a[1] + m[2][3] * a[2] + m[3][3] * a[3];
+  float r[4];
+  store(r,Cols(m).apply(x,y,z,w));
+  ox = r[0];
+  oy = r[1];
+  oz = r[2];
+  ow = r[3];
   }
 
 void Matrix4x4::perspective(float angle, float aspect, float zNear, float zFar) {
@@ -544,38 +582,7 @@ void Matrix4x4::ortho(int width,int height,float zNear, float zFar) {
 
 Matrix4x4 Matrix4x4::operator * (const Matrix4x4& other) const {
   Matrix4x4 r;
-
-  auto& a = m;
-  auto& b = other.m;
-
-  if ((a[0][3]==0.0f) &&
-      (a[1][3]==0.0f) &&
-      (a[2][3]==0.0f) &&
-      (a[2][3]==1.0f) &&
-      (b[0][3]==0.0f) &&
-      (b[1][3]==0.0f) &&
-      (b[2][3]==0.0f) &&
-      (b[2][3]==1.0f))
-  {
-      if ((a[3][0]==0.0f) &&
-          (a[3][1]==0.0f) &&
-          (a[3][2]==0.0f) &&
-          (b[3][0]==0.0f) &&
-          (b[3][1]==0.0f) &&
-          (b[3][2]==0.0f))
-      {
-          NvMultMat3x3f(r.m, a, b);
-      }
-      else
-      {
-          NvMultMat4x3f(r.m, a, b);
-      }
-  }
-  else
-  {
-       NvMultMat4x4f(r.m, a, b);
-  }
-
+  mulMat(r.m,m,other.m);
   return r;
   }
 
@@ -599,3 +606,53 @@ void Matrix4x4::project(Vec4& v) const {
 void Matrix4x4::project(Vec3& v) const {
   project(v.x,v.y,v.z);
   }
+
+void Matrix4x4::projectMany(const Vec3* in, Vec4* out, size_t count) const {
+  const Cols c(m);
+  for(size_t i=0;i<count;++i)
+    store(&out[i].x,c.apply(in[i].x,in[i].y,in[i].z));
+  }
+
+void Matrix4x4::projectMany(const Vec4* in, Vec4* out, size_t count) const {
+  const Cols c(m);
+  for(size_t i=0;i<count;++i)
+    store(&out[i].x,c.apply(in[i].x,in[i].y,in[i].z,in[i].w));
+  }
+
+void Matrix4x4::transformAabb(const Vec3& min, const Vec3& max, Vec3& outMin, Vec3& outMax) const {
+  // Arvo: per axis, pick smaller/larger of both box extents
+  const Cols c(m);
+  const F4 x0 = vmul(c.c0,splat(min.x)), x1 = vmul(c.c0,splat(max.x));
+  const F4 y0 = vmul(c.c1,splat(min.y)), y1 = vmul(c.c1,splat(max.y));
+  const F4 z0 = vmul(c.c2,splat(min.z)), z1 = vmul(c.c2,splat(max.z));
+
+  float lo[4], hi[4];
+  store(lo,vadd(vadd(c.c3,vmin(x0,x1)),vadd(vmin(y0,y1),vmin(z0,z1))));
+  store(hi,vadd(vadd(c.c3,vmax(x0,x1)),vadd(vmax(y0,y1),vmax(z0,z1))));
+  outMin = Vec3(lo[0],lo[1],lo[2]);
+  outMax = Vec3(hi[0],hi[1],hi[2]);
+  }
+
+void Matrix4x4::frustumPlanes(Vec4 planes[]) const {
+  // Gribb-Hartmann, clip volume is -w<=x<=w, -w<=y<=w, 0<=z<=w
+  float r[4][4];
+  std::memcpy(r,m,sizeof(r));
+  transposeMat(r);
+
+  auto plane = [&](float s, int a, float sb, int b) {
+    return Vec4(s*r[a][0]+sb*r[b][0], s*r[a][1]+sb*r[b][1], s*r[a][2]+sb*r[b][2], s*r[a][3]+sb*r[b][3]);
+    };
+  planes[0] = plane(1,3, 1,0);
+  planes[1] = plane(1,3,-1,0);
+  planes[2] = plane(1,3, 1,1);
+  planes[3] = plane(1,3,-1,1);
+  planes[4] = plane(0,3, 1,2);
+  planes[5] = plane(1,3,-1,2);
+
+  for(int i=0;i<6;++i) {
+    auto& p = planes[i];
+    float l = std::sqrt(p.x*p.x+p.y*p.y+p.z*p.z);
+    if(l>0.f)
+      p /= l;
+    }
+  }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Tempest/Vec>
+#include <cstddef>
 #include <cstring>
 
 namespace Tempest {
@@ -85,6 +86,16 @@ class Matrix4x4 final {
     void project(Vec4& v) const;
     void project(Vec3& v) const;
 
+    // batch versions: out[i] = M*(in[i],1) and M*in[i], no perspective divide; in and out may alias only for Vec4
+    void projectMany(const Vec3* in, Vec4* out, size_t count) const;
+    void projectMany(const Vec4* in, Vec4* out, size_t count) const;
+
+    // bounds of affine-transformed box; projective part of matrix is ignored
+    void transformAabb(const Vec3& min, const Vec3& max, Vec3& outMin, Vec3& outMax) const;
+    // left, right, bottom, top, near, far planes of view-projection matrix, as normalized (n.x,n.y,n.z,d)
+    // point p is inside, if dot(n,p)+d>=0 for all planes
+    void frustumPlanes(Vec4 planes[/*6*/]) const;
+
     void perspective( float angle, float aspect, float zNear, float zFar);
     void ortho(int width, int height, float zNear, float zFar);
 
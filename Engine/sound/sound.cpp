@@ -3,6 +3,7 @@
 #include <Tempest/IDevice>
 #include <Tempest/MemReader>
 #include <Tempest/File>
+#include <Tempest/BufferedReader>
 #include <Tempest/Except>
 
 #include <vector>
@@ -79,26 +80,36 @@ uint64_t Sound::Data::timeLength() const {
   }
 
 Sound::Sound(const char *path) {
-  Tempest::RFile f(path);
-  implLoad(f);
+  Tempest::RFile          f(path);
+  Tempest::BufferedReader b(f);
+  implLoad(b);
   }
 
 Sound::Sound(const std::string &path) {
-  Tempest::RFile f(path);
-  implLoad(f);
+  Tempest::RFile          f(path);
+  Tempest::BufferedReader b(f);
+  implLoad(b);
   }
 
 Sound::Sound(const char16_t *path) {
-  Tempest::RFile f(path);
-  implLoad(f);
+  Tempest::RFile          f(path);
+  Tempest::BufferedReader b(f);
+  implLoad(b);
   }
 
 Sound::Sound(const std::u16string &path) {
-  Tempest::RFile f(path);
-  implLoad(f);
+  Tempest::RFile          f(path);
+  Tempest::BufferedReader b(f);
+  implLoad(b);
   }
 
 Sound::Sound(IDevice& f) {
+  if(auto rf = dynamic_cast<RFile*>(&f)) {
+    // chunk headers are tiny, avoid syscall per chunk
+    BufferedReader b(*rf);
+    implLoad(b);
+    return;
+    }
   implLoad(f);
   }
 
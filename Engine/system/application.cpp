@@ -5,42 +5,38 @@
 #include <Tempest/Style>
 #include <Tempest/Font>
 
-#include <vector>
+#include "timerwheel.h"
+
 #include <thread>
 #include <chrono>
 
 using namespace Tempest;
 
 struct Application::Impl : SystemApi::AppCallBack {
-  std::vector<Timer*> timer;
-  size_t              timerI=size_t(-1);
+  Detail::TimerWheel  timer{Application::tickCount()};
 
   const Style*        style=nullptr;
   Font                font;
 
   void addTimer(Timer& t){
-    timer.push_back(&t);
+    timer.insert(t.node,t.m.lastEmit+t.m.interval);
     }
 
   void delTimer(Timer& t){
-    for(size_t i=0;i<timer.size();++i)
-      if(timer[i]==&t){
-        timer.erase(timer.begin()+int(i));
-        if(timerI>=i)
-          timerI--;
-        return;
-        }
+    timer.remove(t.node);
     }
 
   uint32_t onTimer() override {
     auto now = Application::tickCount();
-    size_t count=0;
-    for(timerI=0;timerI<timer.size();++timerI){
-      Timer& t = *timer[timerI];
-      if(t.process(now))
-        count++;
+    timer.advance(now);
+    // each timer fires at most once per call, even if it is far behind
+    uint32_t count=0;
+    while(auto n = timer.popExpired()) {
+      Timer& t = *reinterpret_cast<Timer*>(n->owner);
+      t.process();
+      count++;
       }
-    return uint32_t(count);
+    return count;
     }
 
   void setStyle(const Style* s) {
@@ -83,6 +79,10 @@ void Application::processEvents() {
   SystemApi::processEvent(impl);
   }
 
+uint64_t Application::nextTimerDeadline() {
+  return impl.timer.nextDeadline();
+  }
+
 void Application::setStyle(const Style* stl) {
   impl.setStyle(stl);
   }
@@ -21,6 +21,8 @@ class Application {
     int                 exec();
     static bool         isRunning();
     static void         processEvents();
+    // tick of earliest pending timer, or uint64_t(-1) if no timer is running
+    static uint64_t     nextTimerDeadline();
 
     static void         setStyle(const Style* stl);
     static const Style& style();
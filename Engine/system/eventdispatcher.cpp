@@ -4,6 +4,8 @@
 #include <Tempest/Platform>
 #include <Tempest/UiOverlay>
 
+#include "ui/widgetindex.h"
+
 using namespace Tempest;
 
 EventDispatcher::EventDispatcher() {
@@ -202,21 +204,24 @@ std::shared_ptr<Widget::Ref> EventDispatcher::implDispatch(Widget& w,MouseEvent
   Widget::Iterator it(&w);
   it.moveToEnd();
 
+  std::shared_ptr<Widget::Ref> ret;
+  if(w.hitIdx!=nullptr) {
+    std::vector<size_t> hit;
+    w.hitIdx->query(pos,hit);
+    for(size_t n=0;n<hit.size() && isHitIndexActual(it,w);++n) {
+      it.id = hit[n];
+      if(it.get()->rect().contains(pos) && implDispatch(it,*it.getLast(),event,ret))
+        return ret;
+      }
+    if(isHitIndexActual(it,w))
+      it.id = size_t(-1); else
+      it.prev(); // children were changed by event handler - continue with linear scan
+    }
+
   for(;it.hasPrev();it.prev()) {
     Widget* i=it.get();
-    if(i->rect().contains(pos)) {
-      MouseEvent ex(event.x - i->x(),
-                    event.y - i->y(),
-                    event.button,
-                    event.delta,
-                    event.mouseID,
-                    event.type());
-      auto ptr = implDispatch(*i,ex);
-      if(ex.isAccepted() && it.owner!=nullptr) {
-        event.accept();
-        return ptr;
-        }
-      }
+    if(i->rect().contains(pos) && implDispatch(it,*i,event,ret))
+      return ret;
     }
 
   if(it.owner!=nullptr) {
@@ -230,6 +235,22 @@ std::shared_ptr<Widget::Ref> EventDispatcher::implDispatch(Widget& w,MouseEvent
   return nullptr;
   }
 
+bool EventDispatcher::implDispatch(Widget::Iterator& it, Widget& i, MouseEvent& event, std::shared_ptr<Widget::Ref>& ret) {
+  MouseEvent ex(event.x - i.x(),
+                event.y - i.y(),
+                event.button,
+                event.delta,
+                event.mouseID,
+                event.type());
+  auto ptr = implDispatch(i,ex);
+  if(ex.isAccepted() && it.owner!=nullptr) {
+    event.accept();
+    ret = std::move(ptr);
+    return true;
+    }
+  return false;
+  }
+
 void EventDispatcher::implMouseWhell(Widget& w,MouseEvent &event) {
   if(!w.isVisible()) {
     event.ignore();
@@ -238,29 +259,51 @@ void EventDispatcher::implMouseWhell(Widget& w,MouseEvent &event) {
   Point            pos=event.pos();
   Widget::Iterator it(&w);
   it.moveToEnd();
+
+  if(w.hitIdx!=nullptr) {
+    std::vector<size_t> hit;
+    w.hitIdx->query(pos,hit);
+    for(size_t n=0;n<hit.size() && isHitIndexActual(it,w);++n) {
+      it.id = hit[n];
+      if(it.get()->rect().contains(pos) && implMouseWhell(it,*it.getLast(),event))
+        return;
+      }
+    if(isHitIndexActual(it,w))
+      it.id = size_t(-1); else
+      it.prev(); // children were changed by event handler - continue with linear scan
+    }
+
   for(;it.hasPrev();it.prev()) {
     Widget* i=it.get();
-    if(i->rect().contains(pos)){
-      MouseEvent ex(event.x - i->x(),
-                    event.y - i->y(),
-                    event.button,
-                    event.delta,
-                    event.mouseID,
-                    event.type());
-      if(it.owner!=nullptr) {
-        implMouseWhell(*i,ex);
-        if(ex.isAccepted()) {
-          event.accept();
-          return;
-          }
-        }
-      }
+    if(i->rect().contains(pos) && implMouseWhell(it,*i,event))
+      return;
     }
 
   if(it.owner!=nullptr)
     it.owner->mouseWheelEvent(event);
   }
 
+bool EventDispatcher::implMouseWhell(Widget::Iterator& it, Widget& i, MouseEvent& event) {
+  MouseEvent ex(event.x - i.x(),
+                event.y - i.y(),
+                event.button,
+                event.delta,
+                event.mouseID,
+                event.type());
+  if(it.owner!=nullptr) {
+    implMouseWhell(i,ex);
+    if(ex.isAccepted()) {
+      event.accept();
+      return true;
+      }
+    }
+  return false;
+  }
+
+bool EventDispatcher::isHitIndexActual(const Widget::Iterator& it, const Widget& w) {
+  return it.owner!=nullptr && w.hitIdx!=nullptr && w.hitIdx->isActual();
+  }
+
 bool EventDispatcher::implShortcut(Widget& w, KeyEvent& event) {
   if(!w.isVisible())
     return false;
@@ -32,7 +32,10 @@ class EventDispatcher final {
 
   private:
     std::shared_ptr<Widget::Ref> implDispatch(Tempest::Widget &w, Tempest::MouseEvent& event);
+    bool                         implDispatch(Widget::Iterator& it, Widget& i, MouseEvent& event, std::shared_ptr<Widget::Ref>& ret);
     void                         implMouseWhell(Widget &w, MouseEvent &event);
+    bool                         implMouseWhell(Widget::Iterator& it, Widget& i, MouseEvent& event);
+    static bool                  isHitIndexActual(const Widget::Iterator& it, const Widget& w);
 
     bool                         implShortcut(Tempest::Widget &w, Tempest::KeyEvent& event);
     std::shared_ptr<Widget::Ref> implDispatch(Tempest::Widget &w, Tempest::KeyEvent&   event);
@@ -3,125 +3,194 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
-#include <stdexcept>
+#include <new>
+#include <type_traits>
 #include <cstddef>
 
 namespace Tempest {
 namespace Detail  {
 
-template<class IT>
-class SgStorage {
+class SgUnknown;
+// largest member function pointer representation (msvc uses different sizes per inheritance model)
+using SgAnyMemFn = void (SgUnknown::*)();
+
+// fixed-size, trivially copyable slot: object pointer + member function pointer
+template<class ... Args>
+struct SgSlot {
+  struct VTbl {
+    void (*call)  (const SgSlot& self,Args&... a);
+    bool (*equals)(const SgSlot& self,const SgSlot& other);
+    };
+
+  const VTbl* vtbl = nullptr;
+  void*       obj  = nullptr;
+  alignas(alignof(SgAnyMemFn)) unsigned char fn[sizeof(SgAnyMemFn)] = {};
+
+  template<class T,class F>
+  static SgSlot make(T* obj,F fn) {
+    static_assert(sizeof(F)<=sizeof(SgSlot::fn),"member function pointer is too large");
+    SgSlot s;
+    s.vtbl = &Bind<T,F>::vtbl;
+    s.obj  = const_cast<void*>(static_cast<const void*>(obj));
+    std::memcpy(s.fn,&fn,sizeof(F));
+    return s;
+    }
+
+  bool empty() const { return vtbl==nullptr; }
+  void clear()       { vtbl=nullptr;         }
+
+  void call(Args&... a) const {
+    vtbl->call(*this,a...);
+    }
+
+  bool equals(const SgSlot& other) const {
+    return vtbl==other.vtbl && vtbl->equals(*this,other);
+    }
+
   private:
-    struct Data {
-      uint32_t refcount=1;
-      uint32_t size    =0;
-      uint8_t  byte[1] ={};
-
-      void addRef(){ refcount++; }
-      void decRef(){
-        refcount--;
-        if(refcount==0)
-          std::free(this);
+    template<class T,class F>
+    struct Bind {
+      static F fnOf(const SgSlot& s) {
+        F f;
+        std::memcpy(&f,s.fn,sizeof(F));
+        return f;
         }
-      };
 
-    enum contants:size_t {
-      sizeOfData=sizeof(Data)-1
+      static void call(const SgSlot& self,Args&... a) {
+        ((static_cast<T*>(self.obj))->*(fnOf(self)))(a...);
+        }
+
+      static bool equals(const SgSlot& a,const SgSlot& b) {
+        return a.obj==b.obj && fnOf(a)==fnOf(b);
+        }
+
+      static const VTbl vtbl;
       };
+  };
 
+template<class ... Args>
+template<class T,class F>
+const typename SgSlot<Args...>::VTbl SgSlot<Args...>::Bind<T,F>::vtbl = {
+  &SgSlot<Args...>::Bind<T,F>::call,
+  &SgSlot<Args...>::Bind<T,F>::equals
+  };
+
+// slot array with inline storage for first few slots and amortized growth
+// erased slots are only marked empty and compacted lazily, never while an emission is running
+template<class Slot,uint32_t Inline>
+class SgStorage {
   public:
-    SgStorage(){}
-    ~SgStorage(){
-      if(data!=nullptr)
-        data->decRef();
+    SgStorage()=default;
+    SgStorage(const SgStorage& other){
+      copyFrom(other);
       }
-    SgStorage(const SgStorage& other):data(other.data){
-      if(data!=nullptr)
-        data->addRef();
+    SgStorage(SgStorage&& other){
+      moveFrom(other);
       }
-    SgStorage(SgStorage&& other):data(other.data){
-      other.data=nullptr;
+    ~SgStorage(){
+      delete[] heap;
       }
-    SgStorage& operator=(const SgStorage&)=delete;
-    SgStorage& operator=(SgStorage&& other){
-      std::swap(other.data,data);
+
+    SgStorage& operator=(const SgStorage& other){
+      if(this!=&other) {
+        size   = 0;
+        erased = 0;
+        copyFrom(other);
+        }
       return *this;
       }
-
-    template<class T,class...Args>
-    void push(Args...args) {
-      static_assert(alignof(T)==alignof(std::max_align_t),"bad aligment");
-      static_assert(std::is_trivially_copyable<T>::value,""); //for realloc
-
-      if(data==nullptr) {
-        data=reinterpret_cast<Data*>(std::malloc(sizeOfData+sizeof(T)));
-        if(data==nullptr)
-          throw std::bad_alloc();
-        new(data) Data();
-        data->size = sizeof(T);
-        new(data->byte) T(args...);
-        } else {
-        const size_t nsize=data->size+sizeof(T);
-        data = implRealloc(data,nsize);
-        new(data->byte+data->size) T(args...);
-        data->size=uint32_t(nsize);
+    SgStorage& operator=(SgStorage&& other){
+      if(this!=&other) {
+        delete[] heap;
+        moveFrom(other);
         }
+      return *this;
       }
 
-    void erase(const IT* at,uint32_t sz) {
-      uintptr_t begin=uintptr_t(&data->byte[0]);
-      uintptr_t pos  =uintptr_t(at)-begin;
-
-      if(data->refcount==1) {
-        std::memmove(&data->byte[pos],&data->byte[pos+sz],data->size-pos-sz);
-        data->size-=sz;
-        Data* nd=reinterpret_cast<Data*>(std::realloc(data,sizeOfData+data->size));
-        if(nd!=nullptr)
-          data=nd;
-        } else {
-        data->refcount--;
-        char* ptr=reinterpret_cast<char*>(std::malloc(sizeOfData+data->size-sz));
-        if(ptr==nullptr)
-          throw std::bad_alloc();
-        char* src=reinterpret_cast<char*>(data);
-        std::memcpy(ptr,                src,                   sizeOfData+pos);
-        std::memcpy(ptr+sizeOfData+pos, src+sizeOfData+pos+sz, data->size-pos-sz);
-        data = reinterpret_cast<Data*>(ptr);
-        data->refcount=1;
-        data->size-=sz;
-        }
+    void push(const Slot& s) {
+      if(size==cap && erased>0 && locks==0)
+        compact();
+      if(size==cap)
+        grow();
+      data()[size] = s;
+      ++size;
       }
 
-    const IT* begin() const {
-      if(data!=nullptr)
-        return reinterpret_cast<const IT*>(&data->byte[0]); else
-        return nullptr;
+    void erase(uint32_t at) {
+      data()[at].clear();
+      ++erased;
+      if(locks==0 && erased*2>=size)
+        compact();
       }
 
-    const IT* end() const {
-      if(data!=nullptr)
-        return reinterpret_cast<const IT*>(&data->byte[0]+data->size); else
-        return nullptr;
+    uint32_t    count() const { return size; }
+    Slot*       data()        { return heap!=nullptr ? heap : inl; }
+    const Slot* data()  const { return heap!=nullptr ? heap : inl; }
+
+    // keeps indices stable while slots are called
+    void lock() { ++locks; }
+    void unlock() {
+      if(--locks==0 && erased>0)
+        compact();
       }
 
   private:
-    Data* data=nullptr;
-
-    Data* implRealloc(Data* d,size_t nsize){
-      Data* ndata;
-      if(d->refcount>1){
-        d->refcount--;
-        ndata=reinterpret_cast<Data*>(std::malloc(sizeOfData+nsize));
-        if(ndata==nullptr)
-          throw std::bad_alloc();
-        std::memcpy(ndata,d,sizeOfData+d->size);
-        ndata->refcount=1;
-        } else {
-        ndata=reinterpret_cast<Data*>(std::realloc(d,sizeOfData+nsize));
-        if(ndata==nullptr)
-          throw std::bad_alloc();
+    Slot     inl[Inline];
+    Slot*    heap   = nullptr;
+    uint32_t size   = 0;
+    uint32_t cap    = Inline;
+    uint32_t erased = 0;
+    uint32_t locks  = 0;
+
+    void moveFrom(SgStorage& other) {
+      std::memcpy(static_cast<void*>(inl),other.inl,sizeof(inl));
+      heap   = other.heap;
+      size   = other.size;
+      cap    = other.cap;
+      erased = other.erased;
+      // locks belong to emissions of this object
+
+      other.heap   = nullptr;
+      other.size   = 0;
+      other.cap    = Inline;
+      other.erased = 0;
+      }
+
+    void copyFrom(const SgStorage& other) {
+      const Slot* d = other.data();
+      for(uint32_t i=0;i<other.size;++i)
+        if(!d[i].empty())
+          push(d[i]);
+      }
+
+    void grow() {
+      const uint32_t ncap = cap*2;
+      Slot* n = new Slot[ncap];
+      std::memcpy(static_cast<void*>(n),data(),size*sizeof(Slot));
+      delete[] heap;
+      heap = n;
+      cap  = ncap;
+      }
+
+    void compact() {
+      Slot*    d = data();
+      uint32_t n = 0;
+      for(uint32_t i=0;i<size;++i) {
+        if(d[i].empty())
+          continue;
+        if(n!=i)
+          d[n] = d[i];
+        ++n;
+        }
+      size   = n;
+      erased = 0;
+
+      if(heap!=nullptr && size<=Inline) {
+        std::memcpy(static_cast<void*>(inl),heap,size*sizeof(Slot));
+        delete[] heap;
+        heap = nullptr;
+        cap  = Inline;
         }
-      return ndata;
       }
   };
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <cstddef>
+#include <vector>
 
 #include "signalstorage.h"
 
@@ -11,166 +14,214 @@ namespace Tempest {
 template<class T>
 class Signal;
 
+template<class T>
+class AtomicSignal;
+
 template<class ... Args>
 class Signal<void(Args...args)> {
   public:
     Signal()=default;
     Signal(const Signal&)=delete;
-    Signal(Signal&& other)=default;
-    Signal& operator=(Signal&& other)=default;
+    Signal(Signal&& other):storage(std::move(other.storage)){}
+    ~Signal() {
+      // slot destroyed signal: running emissions must not touch it anymore
+      for(auto e=emitting;e!=nullptr;e=e->prev)
+        e->destroyed = true;
+      }
+    Signal& operator=(Signal&& other) {
+      storage = std::move(other.storage);
+      return *this;
+      }
 
     template<class T,class Base,class Ret,class ... TArgs>
     void bind(T* obj,Ret (Base::*fn)(TArgs...a)) {
       using Check=decltype((std::declval<T>().*fn)(std::declval<Args>()...)); // beautify compiller error message
       static_assert(std::is_same<Check,Ret>::value,""); // unused type warning
-      storage.template push<TImpl<T,Base,Ret,TArgs...>>(obj,fn);
+      storage.push(Slot::make(obj,fn));
       }
 
     template<class T,class Base,class Ret,class ... TArgs>
     void bind(T* obj,Ret (Base::*fn)(TArgs...a) const) {
       using Check=decltype((std::declval<T>().*fn)(std::declval<Args>()...)); // beautify compiller error message
       static_assert(std::is_same<Check,Ret>::value,""); // unused type warning
-      storage.template push<TImplConst<T,Base,Ret,TArgs...>>(obj,fn);
+      storage.push(Slot::make(obj,fn));
       }
 
     template<class T,class Base,class Ret,class ... TArgs>
     void ubind(T* obj,Ret (Base::*fn)(TArgs...a)) {
-      auto b = storage.begin();
-      auto e = storage.end();
-
-      TImpl<T,Base,Ret,TArgs...> ref(obj,fn);
-      for(auto i=b;i!=e;i=i->next()){
-        if(i->equals(ref)) {
-          storage.erase(i,uint32_t(sizeof(ref)));
-          return;
-          }
-        }
+      implUbind(Slot::make(obj,fn));
       }
 
     template<class T,class Base,class Ret,class ... TArgs>
     void ubind(T* obj,Ret (Base::*fn)(TArgs...a) const) {
-      auto b = storage.begin();
-      auto e = storage.end();
-
-      TImplConst<T,Base,Ret,TArgs...> ref(obj,fn);
-      for(auto i=b;i!=e;i=i->next()){
-        if(i->equals(ref)) {
-          storage.erase(i,uint32_t(sizeof(ref)));
-          return;
-          }
-        }
+      implUbind(Slot::make(obj,fn));
       }
 
+    // slots bound during emission are called starting from next emission,
+    // slots unbound during emission are not called anymore
     void operator()(Args... args) const {
-      Detail::SgStorage<Impl> stk(storage);
-      auto b = stk.begin();
-      auto e = stk.end();
-
-      for(auto i=b;i!=e;i=i->next()){
-        i->call(args...);
+      const uint32_t n = storage.count();
+      if(n==0)
+        return;
+      Emission em(*this);
+      // storage may grow or be moved away inside of call: re-fetch; call itself reads slot only before invocation
+      for(uint32_t i=0;i<n && i<storage.count();++i) {
+        const Slot& s = storage.data()[i];
+        if(s.empty())
+          continue;
+        s.call(args...);
+        if(em.destroyed)
+          return;
         }
       }
 
   private:
-    template<class T,class Base,class Ret,class ... TArgs>
-    struct TImpl;
-
-    template<class T,class Base,class Ret,class ... TArgs>
-    struct TImplConst;
-
-    struct alignas(std::max_align_t) Impl { // force maximum aligment to emplace Impl's into SignalStorage
-      struct VTbl {
-        void (*call)  (const void* self,Args&... a);
-        bool (*equals)(const void* self,const Impl& other);
-        size_t size;
-        };
-
-      const VTbl* vtbl;
-
-      void call(Args&... a) const {
-        vtbl->call(this,a...);
+    using Slot    = Detail::SgSlot<Args...>;
+    using Storage = Detail::SgStorage<Slot,2>;
+
+    void implUbind(const Slot& ref) {
+      Slot* d = storage.data();
+      for(uint32_t i=0;i<storage.count();++i) {
+        if(!d[i].empty() && d[i].equals(ref)) {
+          storage.erase(i);
+          return;
+          }
         }
+      }
 
-      const Impl* next() const {
-        return reinterpret_cast<const Impl*>(reinterpret_cast<const char*>(this)+vtbl->size);
+    // lives on stack of operator(); chained for nested emissions
+    struct Emission {
+      explicit Emission(const Signal& s):sig(s),prev(s.emitting) {
+        sig.emitting = this;
+        sig.storage.lock();
         }
-
-      bool equals(Impl& other) const {
-        if(vtbl==other.vtbl){
-          return vtbl->equals(this,other);
-          }
-        return false;
+      ~Emission() {
+        if(destroyed)
+          return;
+        sig.emitting = prev;
+        sig.storage.unlock();
         }
+      const Signal& sig;
+      Emission*     prev      = nullptr;
+      bool          destroyed = false;
       };
 
-    template<class T,class Base,class Ret,class ... TArgs>
-    struct alignas(std::max_align_t) TImpl : Impl {
-      T*  obj;
-      Ret (Base::*fn)(TArgs...a);
-
-      TImpl(T* obj,Ret (Base::*fn)(TArgs...a)):obj(obj),fn(fn){
-        this->vtbl = getVtbl();
-        }
+    mutable Storage   storage;
+    mutable Emission* emitting = nullptr;
+  };
 
-      static const typename Impl::VTbl* getVtbl(){
-        static const auto t=implVtbl();
-        return &t;
-        }
+// signal, that can be emitted from any thread: bind/ubind are serialized by mutex,
+// emit is lock-free and reads immutable snapshot of slots
+// replaced snapshots are freed, once emissions of two epochs back are done (never blocks bind)
+// note: slot can still be running in other thread, when ubind returns
+template<class ... Args>
+class AtomicSignal<void(Args...args)> {
+  public:
+    AtomicSignal()=default;
+    AtomicSignal(const AtomicSignal&)=delete;
+    AtomicSignal& operator=(const AtomicSignal&)=delete;
+    ~AtomicSignal() {
+      delete slots.load();
+      for(auto& r:retired)
+        for(auto i:r)
+          delete i;
+      }
 
-      static typename Impl::VTbl implVtbl(){
-        typename Impl::VTbl t;
-        t.call   = &call;
-        t.equals = &equals;
-        t.size   = sizeof(TImpl);
-        return t;
-        }
+    template<class T,class Base,class Ret,class ... TArgs>
+    void bind(T* obj,Ret (Base::*fn)(TArgs...a)) {
+      using Check=decltype((std::declval<T>().*fn)(std::declval<Args>()...)); // beautify compiller error message
+      static_assert(std::is_same<Check,Ret>::value,""); // unused type warning
+      implBind(Slot::make(obj,fn));
+      }
 
-      static bool equals(const void* self,const Impl& other) {
-        auto& a=*reinterpret_cast<const TImpl*>(self);
-        auto& b=*reinterpret_cast<const TImpl*>(&other);
-        return a.obj==b.obj && a.fn==b.fn;
-        }
+    template<class T,class Base,class Ret,class ... TArgs>
+    void bind(T* obj,Ret (Base::*fn)(TArgs...a) const) {
+      using Check=decltype((std::declval<T>().*fn)(std::declval<Args>()...)); // beautify compiller error message
+      static_assert(std::is_same<Check,Ret>::value,""); // unused type warning
+      implBind(Slot::make(obj,fn));
+      }
 
-      static void call(const void* self,Args&... a) {
-        auto& ptr=*reinterpret_cast<const TImpl*>(self);
-        ((ptr.obj)->*(ptr.fn))(a...);
-        }
-      };
+    template<class T,class Base,class Ret,class ... TArgs>
+    void ubind(T* obj,Ret (Base::*fn)(TArgs...a)) {
+      implUbind(Slot::make(obj,fn));
+      }
 
     template<class T,class Base,class Ret,class ... TArgs>
-    struct alignas(std::max_align_t) TImplConst : Impl {
-      T* obj;
-      Ret (Base::*fn)(TArgs...a) const;
+    void ubind(T* obj,Ret (Base::*fn)(TArgs...a) const) {
+      implUbind(Slot::make(obj,fn));
+      }
 
-      TImplConst(T* obj,Ret (Base::*fn)(TArgs...a) const):obj(obj),fn(fn){
-        this->vtbl = getVtbl();
-        }
+    void operator()(Args... args) const {
+      Reader r(*this);
+      const Snapshot* s = slots.load();
+      if(s==nullptr)
+        return;
+      for(auto& i:*s)
+        i.call(args...);
+      }
 
-      static const typename Impl::VTbl* getVtbl(){
-        static const auto t=implVtbl();
-        return &t;
+  private:
+    using Slot     = Detail::SgSlot<Args...>;
+    using Snapshot = std::vector<Slot>;
+
+    // registers emission in current epoch; retries, if epoch was advanced in between
+    struct Reader {
+      explicit Reader(const AtomicSignal& s) {
+        while(true) {
+          const uint32_t e = s.epoch.load();
+          r = &s.readers[e%2];
+          r->fetch_add(1);
+          if(s.epoch.load()==e)
+            break;
+          r->fetch_sub(1);
+          }
         }
+      ~Reader(){ r->fetch_sub(1); }
+      std::atomic<uint32_t>* r = nullptr;
+      };
 
-      static typename Impl::VTbl implVtbl(){
-        typename Impl::VTbl t;
-        t.call   = &call;
-        t.equals = &equals;
-        t.size   = sizeof(TImplConst);
-        return t;
-        }
+    void implBind(const Slot& s) {
+      std::lock_guard<std::mutex> guard(sync);
+      auto cur = slots.load();
+      std::unique_ptr<Snapshot> n(cur!=nullptr ? new Snapshot(*cur) : new Snapshot());
+      n->push_back(s);
+      publish(n.release());
+      }
 
-      static bool equals(const void* self,const Impl& other) {
-        auto& a=*reinterpret_cast<const TImplConst*>(self);
-        auto& b=*reinterpret_cast<const TImplConst*>(&other);
-        return a.obj==b.obj && a.fn==b.fn;
+    void implUbind(const Slot& ref) {
+      std::lock_guard<std::mutex> guard(sync);
+      auto cur = slots.load();
+      if(cur==nullptr)
+        return;
+      for(size_t i=0;i<cur->size();++i) {
+        if((*cur)[i].equals(ref)) {
+          std::unique_ptr<Snapshot> n(new Snapshot(*cur));
+          n->erase(n->begin()+ptrdiff_t(i));
+          publish(n.release());
+          return;
+          }
         }
+      }
 
-      static void call(const void* self,Args&... a) {
-        auto& ptr=*reinterpret_cast<const TImplConst*>(self);
-        ((ptr.obj)->*(ptr.fn))(a...);
-        }
-      };
+    void publish(Snapshot* n) {
+      const uint32_t e = epoch.load();
+      // reader, that enters after this point, sees only new snapshot
+      retired[e%2].push_back(slots.exchange(n));
+
+      // only readers of epochs e and e-1 exist; once e-1 is drained, snapshots retired in e-1 are unreachable
+      auto& prev = retired[(e+1)%2];
+      if(readers[(e+1)%2].load()!=0)
+        return;
+      for(auto i:prev)
+        delete i;
+      prev.clear();
+      epoch.store(e+1);
+      }
 
-    Detail::SgStorage<Impl> storage;
+    std::mutex                     sync;
+    std::atomic<const Snapshot*>   slots{nullptr};
+    std::atomic<uint32_t>          epoch{0};
+    mutable std::atomic<uint32_t>  readers[2] = {};
+    std::vector<const Snapshot*>   retired[2];
   };
 }
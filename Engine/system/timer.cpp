@@ -5,6 +5,7 @@
 using namespace Tempest;
 
 Timer::Timer() {
+  node.owner = this;
   }
 
 Timer::~Timer() {
@@ -13,7 +14,9 @@ Timer::~Timer() {
 
 void Timer::start(uint64_t t) {
   m.interval = t;
-  setRunning(true);
+  if(m.running)
+    Application::implAddTimer(*this); else
+    setRunning(true);
   }
 
 void Timer::stop() {
@@ -24,19 +27,17 @@ void Timer::setRunning(bool b) {
   if(m.running==b)
     return;
   if(b) {
-    Application::implAddTimer(*this);
     m.lastEmit = Application::tickCount();
+    Application::implAddTimer(*this);
     } else {
     Application::implDelTimer(*this);
     }
   m.running = b;
   }
 
-bool Timer::process(uint64_t now) {
-  if(now>=m.lastEmit && now-m.lastEmit>=m.interval){
-    m.lastEmit += m.interval;
-    timeout();
-    return true;
-    }
-  return false;
+void Timer::process() {
+  m.lastEmit += m.interval;
+  // reschedule before emit: handler is allowed to stop or restart timer
+  Application::implAddTimer(*this);
+  timeout();
   }
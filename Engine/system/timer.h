@@ -3,6 +3,8 @@
 #include <Tempest/Signal>
 #include <limits>
 
+#include "timerwheel.h"
+
 namespace Tempest {
 
 class Timer final {
@@ -20,13 +22,14 @@ class Timer final {
 
   private:
     void     setRunning(bool b);
-    bool     process(uint64_t now);
+    void     process();
 
     struct {
       uint64_t interval=0;
       uint64_t lastEmit=0;
       bool     running=false;
       } m;
+    Detail::TimerWheel::Node node;
 
   friend class Application;
   };
@@ -0,0 +1,150 @@
+#include "timerwheel.h"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+const uint64_t TimerWheel::infinite;
+
+static uint8_t lowestBit(uint64_t v) {
+#if defined(__GNUC__)
+  return uint8_t(__builtin_ctzll(v));
+#else
+  uint8_t r = 0;
+  while((v & 1)==0) {
+    v >>= 1;
+    ++r;
+    }
+  return r;
+#endif
+  }
+
+static uint8_t highestBit(uint64_t v) {
+#if defined(__GNUC__)
+  return uint8_t(63-__builtin_clzll(v));
+#else
+  uint8_t r = 0;
+  while(v>>=1)
+    ++r;
+  return r;
+#endif
+  }
+
+TimerWheel::TimerWheel(uint64_t now)
+  :cur(now) {
+  }
+
+void TimerWheel::insert(Node& n, uint64_t deadline) {
+  if(isLinked(n))
+    remove(n);
+  n.deadline = deadline;
+  place(n);
+  ++count;
+  }
+
+void TimerWheel::remove(Node& n) {
+  if(!isLinked(n))
+    return;
+  if(n.level==Expired && n.next==nullptr)
+    expiredTail = n.pprev;
+  *n.pprev = n.next;
+  if(n.next!=nullptr)
+    n.next->pprev = n.pprev;
+  if(n.level<Levels && slots[n.level][n.slot]==nullptr)
+    mask[n.level] &= ~(uint64_t(1) << n.slot);
+  n.next  = nullptr;
+  n.pprev = nullptr;
+  --count;
+  }
+
+void TimerWheel::advance(uint64_t now) {
+  // due nodes were inserted in the past, but after previous advance
+  while(due!=nullptr) {
+    Node& n = *due;
+    remove(n);
+    ++count;
+    linkBack(n);
+    }
+
+  while(true) {
+    uint8_t  level = 0, slot = 0;
+    uint64_t t     = nextEvent(level,slot);
+    if(t>now)
+      break;
+    cur = t;
+
+    Node* list = slots[level][slot];
+    slots[level][slot] = nullptr;
+    mask[level] &= ~(uint64_t(1) << slot);
+    while(list!=nullptr) {
+      Node& n = *list;
+      list = n.next;
+      n.pprev = nullptr;
+      n.next  = nullptr;
+      if(n.deadline<=cur)
+        linkBack(n); else
+        place(n);
+      }
+    }
+  if(now>cur)
+    cur = now;
+  }
+
+TimerWheel::Node* TimerWheel::popExpired() {
+  Node* n = expired;
+  if(n!=nullptr)
+    remove(*n);
+  return n;
+  }
+
+uint64_t TimerWheel::nextDeadline() const {
+  if(expired!=nullptr || due!=nullptr)
+    return cur;
+  uint8_t level = 0, slot = 0;
+  return nextEvent(level,slot);
+  }
+
+void TimerWheel::link(Node*& head, Node& n, uint8_t level, uint8_t slot) {
+  n.level = level;
+  n.slot  = slot;
+  n.next  = head;
+  n.pprev = &head;
+  if(head!=nullptr)
+    head->pprev = &n.next;
+  head = &n;
+  }
+
+void TimerWheel::linkBack(Node& n) {
+  n.level      = Expired;
+  n.slot       = 0;
+  n.next       = nullptr;
+  n.pprev      = expiredTail;
+  *expiredTail = &n;
+  expiredTail  = &n.next;
+  }
+
+void TimerWheel::place(Node& n) {
+  if(n.deadline<=cur) {
+    link(due,n,Due,0);
+    return;
+    }
+  // level is the highest slot-group, where deadline and current time differ
+  const uint8_t level = uint8_t(highestBit(n.deadline ^ cur)/SlotBits);
+  const uint8_t slot  = uint8_t((n.deadline >> (level*SlotBits)) & (Slots-1));
+  link(slots[level][slot],n,level,slot);
+  mask[level] |= (uint64_t(1) << slot);
+  }
+
+uint64_t TimerWheel::nextEvent(uint8_t& level, uint8_t& slot) const {
+  // every node of lower level lies within current slot of upper level, so lowest occupied level wins
+  for(uint8_t l=0;l<Levels;++l) {
+    if(mask[l]==0)
+      continue;
+    const uint32_t shift = l*SlotBits;
+    level = l;
+    slot  = lowestBit(mask[l]);
+    const uint32_t upper = shift+SlotBits;
+    const uint64_t base  = upper>=64 ? 0 : ((cur >> upper) << upper);
+    return base | (uint64_t(slot) << shift);
+    }
+  return infinite;
+  }
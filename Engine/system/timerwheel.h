@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Tempest {
+namespace Detail {
+
+// hierarchical timer wheel: 64 slots per level, 11 levels cover whole uint64_t range
+// insert/remove are O(1); advance cascades only occupied slots
+class TimerWheel final {
+  public:
+    struct Node {
+      void*    owner    = nullptr;
+      uint64_t deadline = 0;
+
+      private:
+        Node*    next  = nullptr;
+        Node**   pprev = nullptr;
+        uint8_t  level = 0;
+        uint8_t  slot  = 0;
+      friend class TimerWheel;
+      };
+
+    static const uint64_t infinite = uint64_t(-1);
+
+    explicit TimerWheel(uint64_t now=0);
+    TimerWheel(const TimerWheel&)=delete;
+    TimerWheel& operator=(const TimerWheel&)=delete;
+
+    void     insert(Node& n, uint64_t deadline);
+    void     remove(Node& n);
+    bool     isLinked(const Node& n) const { return n.pprev!=nullptr; }
+
+    // moves every node with deadline<=now to expired list
+    // nodes inserted with deadline<=now after this call are expired only by next advance
+    void     advance(uint64_t now);
+    Node*    popExpired();
+
+    // earliest time, when advance has work to do; may be earlier than actual deadline
+    uint64_t nextDeadline() const;
+    uint64_t time() const { return cur; }
+    size_t   size() const { return count; }
+
+  private:
+    enum : uint8_t {
+      SlotBits = 6,
+      Slots    = 1<<SlotBits,
+      Levels   = (64+SlotBits-1)/SlotBits,
+      Due      = Levels,
+      Expired  = Levels+1,
+      };
+
+    uint64_t cur   = 0;
+    size_t   count = 0;
+    uint64_t mask[Levels] = {};
+    Node*    slots[Levels][Slots] = {};
+    Node*    due     = nullptr;
+    Node*    expired = nullptr;
+    Node**   expiredTail = &expired;
+
+    void     link(Node*& head, Node& n, uint8_t level, uint8_t slot);
+    void     linkBack(Node& n);
+    void     place(Node& n);
+    uint64_t nextEvent(uint8_t& level, uint8_t& slot) const;
+  };
+
+}
+}
@@ -209,6 +209,7 @@ class PaintEvent: public Event {
     using Event::accept;
 
   friend class Painter;
+  friend class Widget;
   };
 
 /*!
@@ -65,8 +65,10 @@ Widget *Layout::takeWidget(size_t i) {
   if(i<w->wx.size()){
     Widget* wx=w->wx[i];
     w->wx.erase(w->wx.begin()+int(i));
+    w->implInvalidateHitTest();
     wx->ow=nullptr;
-    applyLayout();
+    Widget::implSetWindow(wx,nullptr);
+    w->implInvalidateLayout();
     return wx;
     }
   return nullptr;
@@ -89,54 +91,50 @@ void LinearLayout::applyLayout(Widget &w, Orientation ori) {
 
 template<bool hor>
 void LinearLayout::implApplyLayout(Widget &w) {
-  int    fixSize  = 0;
-  int    prefSize = 0;
-  int    expSize  = 0;
-
   size_t count = w.widgetsCount();
-  int    pref  = 0;
-  int    exp   = 0;
-
-  size_t visCount = 0;
-  for(size_t i=0;i<count;++i){
-    if(w.widget(i).isVisible())
-      visCount++;
-    }
-
-  for(size_t i=0;i<count;++i){
-    Widget& wx = w.widget(i);
-    if(!wx.isVisible())
-      continue;
-
-    switch(getType<hor>(wx.sizePolicy())) {
-      case Fixed: {
-        int max  = getW<hor>(wx.maxSize());
-        int min  = getW<hor>(wx.minSize());
-        int hint = getW<hor>(wx.sizeHint());
-        if(hint>max)
-          hint=max;
-        if(hint<min)
-          hint=min;
-        fixSize+=hint;
-        break;
+  if(!met.actual) {
+    met = Metrics();
+    for(size_t i=0;i<count;++i){
+      Widget& wx = w.widget(i);
+      if(!wx.isVisible())
+        continue;
+      met.visCount++;
+
+      switch(getType<hor>(wx.sizePolicy())) {
+        case Fixed: {
+          int max  = getW<hor>(wx.maxSize());
+          int min  = getW<hor>(wx.minSize());
+          int hint = getW<hor>(wx.sizeHint());
+          if(hint>max)
+            hint=max;
+          if(hint<min)
+            hint=min;
+          met.fixSize+=hint;
+          break;
+          }
+        case Preferred:
+          met.prefSize += getW<hor>(wx.sizeHint());
+          met.pref++;
+          break;
+        case Expanding:
+          met.expSize  += getW<hor>(wx.sizeHint());
+          met.exp++;
+          break;
         }
-      case Preferred:
-        prefSize += getW<hor>(wx.sizeHint());
-        pref++;
-        break;
-      case Expanding:
-        expSize  += getW<hor>(wx.sizeHint());
-        exp++;
-        break;
       }
+    met.actual = true;
     }
 
+  const size_t visCount = met.visCount;
+  const int    exp      = met.exp;
+  const int    pref     = met.pref;
+
   int freeSpace = getW<hor>(w.size())-(hor ? w.margins().xMargin() : w.margins().yMargin());
-  freeSpace -= (fixSize+prefSize+expSize);
+  freeSpace -= (met.fixSize+met.prefSize+met.expSize);
   freeSpace -= (visCount==0 ? 0 : (int(visCount)-1)*w.spacing());
   if(freeSpace<0)
     freeSpace=0;
-  implApplyLayout<hor>(w,count,visCount,exp>0,((exp>0) ? expSize : prefSize),freeSpace,(exp>0) ? exp : pref);
+  implApplyLayout<hor>(w,count,visCount,exp>0,((exp>0) ? met.expSize : met.prefSize),freeSpace,(exp>0) ? exp : pref);
   }
 
 template<bool hor>
@@ -19,6 +19,8 @@ class Layout {
     Widget* takeWidget(Widget* w);
 
     virtual void applyLayout(){}
+    // size hints, size policies or visibility of children were changed
+    virtual void invalidate(){}
 
   protected:
     Widget*       owner(){ return w; }
@@ -37,10 +39,22 @@ class LinearLayout : public Layout {
     LinearLayout(Orientation ori):ori(ori){}
 
     void applyLayout() override { applyLayout(*owner(),ori); }
+    void invalidate()  override { met.actual=false; }
     Orientation orientation() const { return ori; }
 
   private:
+    struct Metrics {
+      int    fixSize  = 0;
+      int    prefSize = 0;
+      int    expSize  = 0;
+      int    pref     = 0;
+      int    exp      = 0;
+      size_t visCount = 0;
+      bool   actual   = false;
+      };
+
     Orientation ori;
+    Metrics     met;
 
     void applyLayout(Widget& w,Orientation ori);
 
@@ -5,6 +5,7 @@
 #include <Tempest/TextCodec>
 
 #include <cstring>
+#include <cmath>
 #include "utility/utf8_helper.h"
 
 using namespace Tempest;
@@ -74,9 +75,7 @@ TextModel::CommandErase::CommandErase(TextModel::Cursor beg, TextModel::Cursor e
   }
 
 void TextModel::CommandErase::redo(TextModel& subj) {
-  auto s = subj.cursorCast(begin);
-  auto e = subj.cursorCast(end);
-  if(e-s<3) {
+  if(subj.distance(begin,end)<3) {
     subj.fetch(begin,end,prevShort);
     } else {
     subj.fetch(begin,end,prev);
@@ -91,43 +90,72 @@ void TextModel::CommandErase::undo(TextModel& subj) {
   }
 
 
-TextModel::TextModel(const char *str)
-  :txt(std::strlen(str)+1){
-  std::memcpy(txt.data(),str,txt.size());
-  buildIndex();
+TextModel::TextModel(const char *str) {
+  buildIndex(str);
   }
 
 void TextModel::setText(const char *str) {
-  txt.resize(std::strlen(str)+1);
-  std::memcpy(txt.data(),str,txt.size());
-  buildIndex();
+  buildIndex(str);
   sz.actual=false;
   }
 
 void TextModel::insert(const char* t, Cursor where) {
-  if(txt.size()==0) {
+  if(line.size()==0) {
     setText(t);
     return;
     }
-  size_t at  = cursorCast(where);
-  size_t len = std::strlen(t);
 
-  txt.insert(txt.begin()+at,t,t+len);
-  buildIndex();
-  sz.actual=false;
+  const bool rescan = isWidest(where.line,where.line+1);
+  const char* e     = std::strchr(t,'\n');
+  auto&       ln    = line[where.line];
+  if(e==nullptr) {
+    ln.txt.insert(where.offset,t);
+    updateSize(where.line,where.line+1,rescan);
+    return;
+    }
+
+  std::string tail = ln.txt.substr(where.offset);
+  ln.txt.resize(where.offset);
+  ln.txt.append(t,e);
+
+  std::vector<Line> ins;
+  while(true) {
+    const char* b = e+1;
+    e = std::strchr(b,'\n');
+
+    Line l;
+    if(e==nullptr) {
+      l.txt.reserve(std::strlen(b)+tail.size());
+      l.txt.append(b);
+      l.txt.append(tail);
+      ins.emplace_back(std::move(l));
+      break;
+      }
+    l.txt.assign(b,e);
+    ins.emplace_back(std::move(l));
+    }
 
-  cursorCast(at+len);
+  line.insert(line.begin()+ptrdiff_t(where.line+1),
+              std::make_move_iterator(ins.begin()),std::make_move_iterator(ins.end()));
+  updateSize(where.line,where.line+1+ins.size(),rescan);
   }
 
-void TextModel::erase(Cursor cs, Cursor ce) {
-  size_t s = cursorCast(cs);
-  size_t e = cursorCast(ce);
+void TextModel::erase(Cursor s, Cursor e) {
+  if(line.size()==0)
+    return;
   if(e<s)
     std::swap(s,e);
 
-  txt.erase(txt.begin()+s,txt.begin()+e);
-  buildIndex();
-  sz.actual=false;
+  const bool rescan = isWidest(s.line,e.line+1);
+  auto&      ln     = line[s.line];
+  if(s.line==e.line) {
+    ln.txt.erase(s.offset,e.offset-s.offset);
+    } else {
+    ln.txt.resize(s.offset);
+    ln.txt.append(line[e.line].txt,e.offset,std::string::npos);
+    line.erase(line.begin()+ptrdiff_t(s.line+1),line.begin()+ptrdiff_t(e.line+1));
+    }
+  updateSize(s.line,s.line+1,rescan);
   }
 
 void TextModel::erase(TextModel::Cursor s, size_t count) {
@@ -135,71 +163,96 @@ void TextModel::erase(TextModel::Cursor s, size_t count) {
   erase(s,e);
   }
 
-void TextModel::replace(const char* t, TextModel::Cursor cs, TextModel::Cursor ce) {
-  if(txt.size()==0) {
+void TextModel::replace(const char* t, TextModel::Cursor s, TextModel::Cursor e) {
+  if(line.size()==0) {
     setText(t);
     return;
     }
-  size_t s   = cursorCast(cs);
-  size_t e   = cursorCast(ce);
-  size_t len = std::strlen(t);
   if(e<s)
     std::swap(s,e);
-
-  txt.erase (txt.begin()+s,txt.begin()+e);
-  txt.insert(txt.begin()+s,t,t+len);
-
-  buildIndex();
-  sz.actual=false;
+  erase (s,e);
+  insert(t,s);
   }
 
 void TextModel::fetch(TextModel::Cursor cs, TextModel::Cursor ce, std::string& buf) {
-  size_t s = cursorCast(cs);
-  size_t e = cursorCast(ce);
-  if(s==e)
+  size_t sz = distance(cs,ce);
+  if(sz==0)
     return;
-  if(e<s)
-    std::swap(s,e);
-  buf.resize(e-s);
-  std::memcpy(&buf[0],&txt[s],buf.size());
+  buf.resize(sz);
+  fetch(cs,ce,&buf[0]);
   }
 
-void TextModel::fetch(TextModel::Cursor cs, TextModel::Cursor ce, char* buf) {
-  size_t s = cursorCast(cs);
-  size_t e = cursorCast(ce);
-  if(s==e)
+void TextModel::fetch(TextModel::Cursor s, TextModel::Cursor e, char* buf) {
+  if(line.size()==0 || s==e)
     return;
   if(e<s)
     std::swap(s,e);
-  std::memcpy(&buf[0],&txt[s],e-s);
+
+  if(s.line==e.line) {
+    std::memcpy(buf,line[s.line].txt.data()+s.offset,e.offset-s.offset);
+    return;
+    }
+
+  auto& first = line[s.line].txt;
+  std::memcpy(buf,first.data()+s.offset,first.size()-s.offset);
+  buf += first.size()-s.offset;
+  *buf = '\n';
+  ++buf;
+  for(size_t i=s.line+1;i<e.line;++i) {
+    auto& ln = line[i].txt;
+    std::memcpy(buf,ln.data(),ln.size());
+    buf += ln.size();
+    *buf = '\n';
+    ++buf;
+    }
+  std::memcpy(buf,line[e.line].txt.data(),e.offset);
   }
 
-TextModel::Cursor TextModel::advance(TextModel::Cursor src, int32_t offset) const {
-  size_t c = cursorCast(src);
+TextModel::Cursor TextModel::advance(TextModel::Cursor c, int32_t offset) const {
+  if(line.size()==0)
+    return c;
+
   if(offset>0) {
-    const char* str = txt.data()+c, *end = txt.data()+txt.size()-(txt.size() ? 1 : 0);
-    for(int32_t i=0;i<offset && str<end;++i) {
-      const auto l = Detail::utf8LetterLength(str);
-      str+=l;
+    for(int32_t i=0;i<offset;++i) {
+      auto& ln = line[c.line].txt;
+      if(c.offset<ln.size()) {
+        const auto l = Detail::utf8LetterLength(&ln[c.offset]);
+        c.offset = std::min(c.offset+std::max<size_t>(l,1),ln.size());
+        }
+      else if(c.line+1<line.size()) {
+        c.line++;
+        c.offset = 0;
+        }
+      else {
+        break;
+        }
       }
-    return cursorCast(std::distance(txt.data(),str));
     } else {
     offset = -offset;
-    const char* str = txt.data()+c, *begin = txt.data();
     for(int32_t i=0;i<offset;++i) {
-      while(str!=begin) {
-        str--;
-        if((uint8_t(*str) >> 6) != 0x2)
-          break;
+      auto& ln = line[c.line].txt;
+      if(c.offset>0) {
+        c.offset--;
+        while(c.offset>0 && (uint8_t(ln[c.offset]) >> 6) == 0x2)
+          c.offset--;
+        }
+      else if(c.line>0) {
+        c.line--;
+        c.offset = line[c.line].txt.size();
+        }
+      else {
+        break;
         }
       }
-    return cursorCast(std::distance(txt.data(),str));
     }
+  return c;
   }
 
 void TextModel::setFont(const Font &f) {
   fnt      =f;
   sz.actual=false;
+  for(auto& ln:line)
+    ln.run.clear();
   }
 
 const Font& TextModel::font() const {
@@ -219,7 +272,7 @@ Size TextModel::wrapSize() const {
   }
 
 bool TextModel::isEmpty() const {
-  return txt.size()<=1;
+  return line.size()==0 || (line.size()==1 && line[0].txt.empty());
   }
 
 void TextModel::paint(Painter& p, int x, int y) const {
@@ -227,93 +280,159 @@ void TextModel::paint(Painter& p, int x, int y) const {
   }
 
 void TextModel::paint(Painter &p,const Font& fnt,int fx,int fy) const {
-  float x = float(fx);
-  float y = float(fy);
+  const float px    = fnt.pixelSize();
+  size_t      begin = 0, end = 0;
+  if(!visibleLines(p,px,fy-int(px),begin,end))
+    return;
+
+  const Rect  sc     = p.scissor();
+  const bool  cached = (&fnt==&this->fnt);
+  float       y      = float(fy)+float(begin)*px;
 
+  std::vector<Glyph> tmp;
   auto pb=p.brush();
-  Utf8Iterator i(txt.data());
+  for(size_t i=begin;i<end;++i) {
+    auto& ln  = line[i];
+    auto& run = cached ? ln.run : tmp;
+    if(!cached || (run.size()==0 && ln.txt.size()>0))
+      shapeLine(fnt,ln,p,run);
+
+    for(auto& g:run) {
+      const int x = fx+g.x;
+      if(x>sc.x+sc.w)
+        break;
+      auto& l = *g.letter;
+      if(l.view.isEmpty() || x+l.dpos.x+l.view.w()<sc.x)
+        continue;
+      p.setBrush(Brush(l.view,Color(1.0),PaintDevice::Alpha));
+      p.drawRect(int(float(x)+l.dpos.x),int(y+l.dpos.y),l.view.w(),l.view.h());
+      }
+    y += px;
+    }
+  p.setBrush(pb);
+  }
+
+void TextModel::shapeLine(const Font& fnt, const Line& ln, Painter& p, std::vector<Glyph>& run) const {
+  run.clear();
+
+  int x = 0;
+  Utf8Iterator i(ln.txt.data(),ln.txt.size());
   while(i.hasData()) {
     auto ch=i.next();
-    if(ch=='\0'){
-      p.setBrush(pb);
-      return;
-      }
-    if(ch=='\n'){
-      x =  0;
-      y += fnt.pixelSize();
+    if(ch=='\0')
       continue;
-      }
+    Glyph g;
+    g.letter = &fnt.letter(ch,p);
+    g.x      = x;
+    run.push_back(g);
+    x += g.letter->advance.x;
+    }
+  }
 
-    auto l=fnt.letter(ch,p);
-    if(!l.view.isEmpty()) {
-      p.setBrush(Brush(l.view,Color(1.0),PaintDevice::Alpha));
-      p.drawRect(int(x+l.dpos.x),int(y+l.dpos.y),l.view.w(),l.view.h());
-      }
+bool TextModel::visibleLines(const Painter& p, float px, int y, size_t& begin, size_t& end) const {
+  const Rect sc = p.scissor();
+  if(line.size()==0 || sc.w<=0 || sc.h<=0)
+    return false;
 
-    x += l.advance.x;
-    }
-  p.setBrush(pb);
+  // all lines have same height, so visible range is computed directly;
+  // one extra line on each side covers glyphs overhanging the line box
+  const float b  = std::floor(float(sc.y-y)/px)-1.f;
+  const float e  = std::floor(float(sc.y+sc.h-y)/px)+2.f;
+  if(e<=0.f || b>=float(line.size()))
+    return false;
+
+  begin = b>0.f ? size_t(b) : 0;
+  end   = std::min(line.size(),size_t(e));
+  return begin<end;
   }
 
 void TextModel::calcSize() const {
-  sz = calcSize(fnt);
+  sz.width = 0;
+  for(auto& ln:line) {
+    calcLine(ln);
+    sz.width = std::max(sz.width,ln.width);
+    }
+  commitSize();
   }
 
-TextModel::Sz TextModel::calcSize(const Font& fnt) const {
-  float x=0, w=0;
-  int   y=0, top=0;
+void TextModel::calcLine(const Line& ln) const {
+  int x=0, y=0;
 
-  Utf8Iterator i(txt.data());
+  Utf8Iterator i(ln.txt.data(),ln.txt.size());
   while(i.hasData()){
     char32_t ch = i.next();
-    if(ch=='\n'){
-      w = std::max(w,x);
-      x = 0;
-      y = 0;
-      top+=int(fnt.pixelSize());
-      } else {
-      auto l=fnt.letterGeometry(ch);
-      x += l.advance.x;
-      y =  std::max(-l.dpos.y,y);
-      }
+    auto l=fnt.letterGeometry(ch);
+    x += l.advance.x;
+    y =  std::max(-l.dpos.y,y);
     }
-  w = std::max(w,x);
+  ln.width  = x;
+  ln.ascent = y;
+  }
+
+void TextModel::commitSize() const {
+  const int px  = int(fnt.pixelSize());
+  const int top = line.size()>0 ? int(line.size()-1)*px : 0;
 
-  Sz sz;
-  sz.wrapHeight=y+top;
-  sz.sizeHint  =Size(int(std::ceil(w)),top+int(fnt.pixelSize()));
-  return sz;
+  sz.wrapHeight = (line.size()>0 ? line.back().ascent : 0)+top;
+  sz.sizeHint   = Size(sz.width,top+px);
+  sz.actual     = true;
   }
 
-void TextModel::buildIndex() {
-  if(txt.size()==0) {
-    line.clear();
+void TextModel::updateSize(size_t begin, size_t end, bool rescan) {
+  flatActual = false;
+  for(size_t i=begin;i<end;++i)
+    line[i].run.clear();
+  if(!sz.actual)
     return;
+
+  // only touched lines are re-measured; full rescan of cached widths is needed
+  // only when the widest line was modified and got narrower
+  int w = 0;
+  for(size_t i=begin;i<end;++i) {
+    calcLine(line[i]);
+    w = std::max(w,line[i].width);
     }
 
+  if(rescan && w<sz.width) {
+    for(auto& ln:line)
+      w = std::max(w,ln.width);
+    sz.width = w;
+    } else {
+    sz.width = std::max(sz.width,w);
+    }
+  commitSize();
+  }
+
+bool TextModel::isWidest(size_t begin, size_t end) const {
+  if(!sz.actual)
+    return false;
+  for(size_t i=begin;i<end;++i)
+    if(line[i].width>=sz.width)
+      return true;
+  return false;
+  }
+
+void TextModel::buildIndex(const char* str) {
+  flatActual = false;
+  line.clear();
+
   size_t count=0;
-  for(auto c:txt)
-    if(c=='\n')
+  for(const char* i=str;*i;++i)
+    if(*i=='\n')
       count++;
   line.resize(count+1);
 
-  size_t beg=0;
-  size_t ln =0;
-  Utf8Iterator i(txt.data());
-  while(i.hasData()){
-    char32_t ch = i.next();
-    if(ch=='\n') {
-      size_t ipos=i.pos();
-      line[ln].txt  = &txt[beg];
-      line[ln].size = ipos-1-beg;
-
-      beg=ipos;
+  const char* beg = str;
+  size_t      ln  = 0;
+  for(const char* i=str;;++i) {
+    if(*i=='\n' || *i=='\0') {
+      line[ln].txt.assign(beg,i);
+      if(*i=='\0')
+        break;
+      beg = i+1;
       ln++;
       }
     }
-
-  line[ln].txt  = txt.data()+beg;
-  line[ln].size = txt.size()-beg-1;
   }
 
 TextModel::Cursor TextModel::charAt(int x, int y) const {
@@ -334,7 +453,12 @@ TextModel::Cursor TextModel::charAt(int x, int y) const {
     c.line=line.size()-1;
 
   auto& ln = line[c.line];
-  Utf8Iterator i(ln.txt,ln.size);
+  if(sz.actual && x>=ln.width) {
+    c.offset = ln.txt.size();
+    return c;
+    }
+
+  Utf8Iterator i(ln.txt.data(),ln.txt.size());
   int    px      = 0;
   size_t prevPos = 0;
   while(i.hasData()){
@@ -349,7 +473,7 @@ TextModel::Cursor TextModel::charAt(int x, int y) const {
       }
     px += l.advance.x;
     }
-  c.offset = ln.size;
+  c.offset = ln.txt.size();
   return c;
   }
 
@@ -359,8 +483,12 @@ Point TextModel::mapToCoords(Cursor c) const {
   Point p;
   p.y = int(c.line*fnt.pixelSize());
   auto& ln = line[c.line];
+  if(sz.actual && c.offset==ln.txt.size()) {
+    p.x = ln.width;
+    return p;
+    }
 
-  Utf8Iterator str(ln.txt,ln.size);
+  Utf8Iterator str(ln.txt.data(),ln.txt.size());
   while(str.hasData() && str.pos()<c.offset){
     char32_t ch = str.next();
     auto l=fnt.letterGeometry(ch);
@@ -370,15 +498,28 @@ Point TextModel::mapToCoords(Cursor c) const {
   }
 
 const char* TextModel::c_str() const {
-  if(txt.size()==0)
+  if(line.size()==0)
     return "";
-  return txt.data();
+  if(!flatActual) {
+    size_t len = 0;
+    for(auto& ln:line)
+      len += ln.txt.size()+1;
+    flat.clear();
+    flat.reserve(len);
+    for(size_t i=0;i<line.size();++i) {
+      if(i>0)
+        flat.push_back('\n');
+      flat.append(line[i].txt);
+      }
+    flatActual = true;
+    }
+  return flat.c_str();
   }
 
 bool TextModel::isValid(TextModel::Cursor c) const {
   if(c.line>=line.size())
     return false;
-  return c.offset<=line[c.line].size;
+  return c.offset<=line[c.line].txt.size();
   }
 
 TextModel::Cursor TextModel::clamp(const TextModel::Cursor& c) const {
@@ -388,35 +529,28 @@ TextModel::Cursor TextModel::clamp(const TextModel::Cursor& c) const {
     r.offset = 0;
     return r;
     }
-  r.line   = std::max<size_t>(0,std::min<size_t>(c.line,line.size()-1));
-  r.offset = std::max<size_t>(0,std::min<size_t>(c.offset,line[r.offset].size));
+  r.line   = std::min<size_t>(c.line,line.size()-1);
+  r.offset = std::min<size_t>(c.offset,line[r.line].txt.size());
   return r;
   }
 
-size_t TextModel::cursorCast(Cursor c) const {
+size_t TextModel::distance(Cursor s, Cursor e) const {
   if(line.size()==0)
     return 0;
-  size_t r=std::distance(txt.data(),line[c.line].txt);
-  return r+c.offset;
-  }
-
-TextModel::Cursor TextModel::cursorCast(size_t c) const {
-  Cursor cx;
-  for(size_t i=0;i<line.size();++i) {
-    size_t b = std::distance(txt.data(),line[i].txt);
+  if(e<s)
+    std::swap(s,e);
+  if(s.line==e.line)
+    return e.offset-s.offset;
 
-    if(b<=c && c<=b+line[i].size) {
-      cx.line   = i;
-      cx.offset = c-b;
-      return cx;
-      }
-    }
-  return cx;
+  size_t r = line[s.line].txt.size()-s.offset+1;
+  for(size_t i=s.line+1;i<e.line;++i)
+    r += line[i].txt.size()+1;
+  return r+e.offset;
   }
 
 void TextModel::drawCursor(Painter& p, int x, int y,TextModel::Cursor c) const {
   if(!isValid(c) &&
-     !(txt.size()==0 && c.line==0 && c.offset==0))
+     !(line.size()==0 && c.line==0 && c.offset==0))
     return;
 
   auto pos = mapToCoords(c)+Point(x,y);
@@ -436,7 +570,7 @@ void TextModel::drawCursor(Painter &p, int x, int y, Cursor s, Cursor e) const {
   if(s.line>e.line)
     std::swap(s,e);
   Cursor s1 = s;
-  s1.offset = line[s.line].size;
+  s1.offset = line[s.line].txt.size();
 
   int lnH = int(fnt.pixelSize());
   if(s.line!=e.line) {
@@ -446,10 +580,18 @@ void TextModel::drawCursor(Painter &p, int x, int y, Cursor s, Cursor e) const {
 
     p.drawRect(x+posS0.x,y+posS0.y,posS1.x-posS0.x,lnH);
     p.drawRect(x,        y+posE.y,posE.x,          lnH);
-    for(size_t ln=s.line+1;ln<e.line;++ln) {
+
+    size_t begin=0, end=0;
+    if(!visibleLines(p,fnt.pixelSize(),y,begin,end)) {
+      p.setBrush(b);
+      return;
+      }
+    begin = std::max(begin,s.line+1);
+    end   = std::min(end,  e.line);
+    for(size_t ln=begin;ln<end;++ln) {
       Cursor cx;
       cx.line   = ln;
-      cx.offset = line[ln].size;
+      cx.offset = line[ln].txt.size();
       auto posLn = mapToCoords(cx);
       p.drawRect(x,y+posLn.y,posLn.x,lnH);
       }
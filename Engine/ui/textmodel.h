@@ -134,25 +134,38 @@ class TextModel final {
     struct Sz {
       Size sizeHint;
       int  wrapHeight=0;
+      int  width     =0;
       bool actual=false;
       };
 
+    struct Glyph {
+      const Font::Letter* letter=nullptr;
+      int                 x     =0;
+      };
+
     struct Line {
-      const char* txt =nullptr;
-      size_t      size=0;
+      std::string                txt;
+      mutable int                width =0;
+      mutable int                ascent=0;
+      mutable std::vector<Glyph> run;
       };
 
-    size_t      cursorCast(Cursor c) const;
-    Cursor      cursorCast(size_t c) const;
+    size_t      distance(Cursor s,Cursor e) const;
+    bool        isWidest(size_t begin,size_t end) const;
 
     void        calcSize() const;
-    Sz          calcSize(const Font& fnt) const;
-    void        buildIndex();
-
-    mutable Sz        sz;
-    std::vector<char> txt;
-    std::vector<Line> line;
-    Tempest::Font     fnt;
+    void        calcLine(const Line& ln) const;
+    void        shapeLine(const Font& fnt, const Line& ln, Painter& p, std::vector<Glyph>& run) const;
+    bool        visibleLines(const Painter& p, float px, int y, size_t& begin, size_t& end) const;
+    void        commitSize() const;
+    void        updateSize(size_t begin, size_t end, bool rescan);
+    void        buildIndex(const char* str);
+
+    mutable Sz          sz;
+    mutable std::string flat;
+    mutable bool        flatActual=false;
+    std::vector<Line>   line;
+    Tempest::Font       fnt;
   };
 
 }
@@ -3,6 +3,15 @@
 #include <Tempest/Layout>
 #include <Tempest/Application>
 #include <Tempest/UiOverlay>
+#include <Tempest/Window>
+
+#include <Tempest/Painter>
+#include <Tempest/Device>
+#include <Tempest/Encoder>
+#include <Tempest/Profiler>
+
+#include "widgetindex.h"
+#include "widgetlayer.h"
 
 using namespace Tempest;
 
@@ -82,7 +91,6 @@ Widget::~Widget() {
   }
 
 void Widget::setLayout(Orientation ori) noexcept {
-  static_assert(sizeof(LinearLayout)<=sizeof(layBuf),"layBuf is too small");
   freeLayout();
   new(layBuf) LinearLayout(ori);
   lay=reinterpret_cast<Layout*>(layBuf);
@@ -98,13 +106,17 @@ void Widget::setLayout(Layout *l) {
   }
 
 void Widget::applyLayout() {
+  lay->invalidate();
   lay->applyLayout();
   }
 
 void Widget::removeAllWidgets() {
+  implInvalidateHitTest();
   std::vector<Widget*> rm=std::move(wx);
-  for(auto& w:rm)
+  for(auto& w:rm) {
     w->ow=nullptr;
+    implSetWindow(w,nullptr);
+    }
 
   astate.focus = nullptr;
 
@@ -121,6 +133,55 @@ void Widget::freeLayout() noexcept {
     }
   }
 
+void Widget::implInvalidateLayout() {
+  lay->invalidate();
+  implRequestLayout();
+  }
+
+void Widget::implRequestLayout() {
+  if(wnd==nullptr || !wnd->deferLayout || wnd->layoutFlush) {
+    astate.needToLayout = false;
+    lay->applyLayout();
+    return;
+    }
+
+  // deferred: mark path to the root, Window::flushLayout will apply it once before paint
+  astate.needToLayout = true;
+  for(Widget* w=ow; w!=nullptr && !w->astate.childToLayout; w=w->ow)
+    w->astate.childToLayout = true;
+  update();
+  }
+
+void Widget::implSetWindow(Widget* w, Window* wnd) {
+  if(w->wnd==wnd)
+    return;
+  w->wnd = wnd;
+  for(auto i:w->wx)
+    implSetWindow(i,wnd);
+  }
+
+void Widget::implFlushLayout() {
+  if(astate.needToLayout) {
+    astate.needToLayout = false;
+    lay->applyLayout();
+    }
+  if(!astate.childToLayout)
+    return;
+  astate.childToLayout = false;
+  for(size_t i=0;i<wx.size();++i)
+    wx[i]->implFlushLayout();
+  }
+
+void Widget::implInvalidateHitTest() noexcept {
+  if(hitIdx!=nullptr)
+    hitIdx->invalidate();
+  }
+
+void Widget::implUpdateHitTest() {
+  if(ow!=nullptr && ow->hitIdx!=nullptr)
+    ow->hitIdx->update(*this);
+  }
+
 void Widget::implDisableSum(Widget *root,int diff) noexcept {
   root->astate.disable += diff;
 
@@ -131,6 +192,7 @@ void Widget::implDisableSum(Widget *root,int diff) noexcept {
   }
 
 void Widget::dispatchPaintEvent(PaintEvent& e) {
+  T_PROFILE_ZONE("Widget::dispatchPaintEvent");
   astate.needToUpdate = false;
 
   paintEvent(e);
@@ -149,10 +211,61 @@ void Widget::dispatchPaintEvent(PaintEvent& e) {
       continue;
 
     PaintEvent ex(e,wx.x(),wx.y(),sc.x,sc.y,sc.w,sc.h);
-    wx.dispatchPaintEvent(ex);
+    if(wx.layer!=nullptr)
+      wx.implPaintLayer(ex); else
+      wx.dispatchPaintEvent(ex);
     }
   }
 
+void Widget::implPaintLayer(PaintEvent& e) {
+  auto& l = *layer;
+  if(astate.needToUpdate || l.size!=size()) {
+    l.size = size();
+    l.image.clear();
+    PaintEvent le(l.image,e.ta,w(),h());
+    dispatchPaintEvent(le);
+    l.needRender = true;
+    }
+
+  if(l.needRender || l.tex.isEmpty() || l.tex.size()!=l.size) {
+    // texture is not up to date, see Window::dispatchLayers
+    dispatchPaintEvent(e);
+    return;
+    }
+
+  Painter p(e);
+  p.setBrush(Brush(textureCast(l.tex),PaintDevice::Premultiplied,ClampMode::ClampToEdge));
+  p.drawRect(0,0,w(),h());
+  l.sampled = true;
+  }
+
+void Widget::implRenderLayers(Device& dev, Swapchain& sw, Encoder<CommandBuffer>& cmd) {
+  if(!isVisible())
+    return;
+
+  // nested layers first: they are sampled by outer ones
+  for(auto i:wx)
+    i->implRenderLayers(dev,sw,cmd);
+
+  if(layer==nullptr || !layer->needRender)
+    return;
+
+  auto& l = *layer;
+  if(l.size.isEmpty())
+    return;
+  if(l.tex.isEmpty() || l.tex.size()!=l.size || l.sampled) {
+    // never render over texture, that frame in flight may sample: fresh one instead;
+    // old texture and fbo are released through device retire queue, once gpu is done with them
+    l.tex     = dev.attachment(TextureFormat::RGBA8,uint32_t(l.size.w),uint32_t(l.size.h));
+    l.fbo     = dev.frameBuffer(l.tex);
+    l.pass    = dev.pass(FboMode(FboMode::PreserveOut,Color(0.f,0.f,0.f,0.f)));
+    l.sampled = false;
+    }
+  cmd.setFramebuffer(l.fbo,l.pass);
+  l.image.draw(dev,sw,cmd);
+  l.needRender = false;
+  }
+
 void Widget::dispatchPolishEvent(PolishEvent& e) {
   polishEvent(e);
   Widget::Iterator it(this);
@@ -175,6 +288,7 @@ void Widget::setOwner(Widget *w) {
   if(ow)
     ow->takeWidget(this);
   ow=w;
+  implSetWindow(this,w!=nullptr ? w->wnd : nullptr);
   }
 
 void Widget::deleteLater() noexcept {
@@ -217,11 +331,14 @@ Widget& Widget::implAddWidget(Widget *w,size_t at) {
       wx[i]=wx[i-1];
     wx[at] = w;
     }
+  implInvalidateHitTest();
   if(w->checkFocus())
     astate.focus = w;
   if(astate.disable>0)
     implDisableSum(w,astate.disable);
-  lay->applyLayout();
+  if(w->astate.needToLayout || w->astate.childToLayout)
+    w->implFlushLayout();
+  implInvalidateLayout();
   update();
   return *w;
   }
@@ -260,6 +377,7 @@ void Widget::setPosition(int x, int y) {
 
   wrect.x = x;
   wrect.y = y;
+  implUpdateHitTest();
   update();
   }
 
@@ -272,10 +390,11 @@ void Widget::setGeometry(const Rect &rect) {
     return;
   bool resize=(wrect.w!=rect.w || wrect.h!=rect.h);
   wrect=rect;
+  implUpdateHitTest();
   update();
 
   if(resize) {
-    lay->applyLayout();
+    implRequestLayout();
     SizeEvent e(uint32_t(rect.w),uint32_t(rect.h));
     resizeEvent( e );
     }
@@ -294,8 +413,9 @@ void Widget::resize(int w, int h) {
     return;
   wrect.w=w;
   wrect.h=h;
+  implUpdateHitTest();
 
-  lay->applyLayout();
+  implRequestLayout();
   SizeEvent e(w,h);
   resizeEvent( e );
   }
@@ -305,7 +425,7 @@ void Widget::setSizeHint(const Size &s) {
     return;
   szHint=s;
   if(ow!=nullptr)
-    ow->lay->applyLayout();
+    ow->implInvalidateLayout();
   }
 
 void Widget::setSizeHint(const Size &s, const Margin &add) {
@@ -313,7 +433,10 @@ void Widget::setSizeHint(const Size &s, const Margin &add) {
   }
 
 void Widget::setWidgetState(const WidgetState& st) {
+  const bool vis = (wstate.visible!=st.visible);
   wstate = st;
+  if(vis && ow!=nullptr)
+    ow->implInvalidateLayout();
   }
 
 void Widget::setSizePolicy(SizePolicyType hv) {
@@ -327,7 +450,7 @@ void Widget::setSizePolicy(SizePolicyType h, SizePolicyType v) {
   szPolicy.typeV=v;
 
   if(ow!=nullptr)
-    ow->lay->applyLayout();
+    ow->implInvalidateLayout();
   }
 
 void Widget::setSizePolicy(const SizePolicy &sp) {
@@ -335,7 +458,7 @@ void Widget::setSizePolicy(const SizePolicy &sp) {
     return;
   szPolicy=sp;
   if(ow!=nullptr)
-    ow->lay->applyLayout();
+    ow->implInvalidateLayout();
   }
 
 void Widget::setFocusPolicy(FocusPolicy f) {
@@ -345,14 +468,14 @@ void Widget::setFocusPolicy(FocusPolicy f) {
 void Widget::setMargins(const Margin &m) {
   if(marg!=m){
     marg=m;
-    lay->applyLayout();
+    implRequestLayout();
     }
   }
 
 void Widget::setSpacing(int s) {
   if(s!=spa){
     spa=s;
-    lay->applyLayout();
+    implRequestLayout();
     }
   }
 
@@ -363,7 +486,7 @@ void Widget::setMaximumSize(const Size &s) {
   szPolicy.maxSize = s;
 
   if( owner() )
-    owner()->applyLayout();
+    owner()->implInvalidateLayout();
 
   if(wrect.w>s.w || wrect.h>s.h)
     setGeometry( wrect.x, wrect.y, std::min(s.w, wrect.w), std::min(s.h, wrect.h) );
@@ -375,7 +498,7 @@ void Widget::setMinimumSize(const Size &s) {
 
   szPolicy.minSize = s;
   if( owner() )
-    owner()->applyLayout();
+    owner()->implInvalidateLayout();
 
   if(wrect.w<s.w || wrect.h<s.h )
     setGeometry( wrect.x, wrect.y, std::max(s.w, wrect.w), std::max(s.h, wrect.h) );
@@ -429,10 +552,11 @@ void Widget::setVisible(bool v) {
   wstate.visible = v;
   if( !wstate.visible )
     astate.needToUpdate = false;
+  implUpdateHitTest();
 
   if( auto w = owner() ){
     w->update();
-    w->applyLayout();
+    w->implInvalidateLayout();
     }
   }
 
@@ -440,6 +564,23 @@ bool Widget::isVisible() const {
   return wstate.visible;
   }
 
+void Widget::setLayer(bool enable) {
+  if(enable==(layer!=nullptr))
+    return;
+  if(enable)
+    layer.reset(new Detail::WidgetLayer()); else
+    layer.reset();
+  update();
+  }
+
+void Widget::setHitTestIndex(bool enable) {
+  if(enable==(hitIdx!=nullptr))
+    return;
+  if(enable)
+    hitIdx.reset(new Detail::WidgetIndex(*this)); else
+    hitIdx.reset();
+  }
+
 void Widget::setFocus(bool b) {
   implSetFocus(b,Event::FocusReason::UnknownReason);
   }
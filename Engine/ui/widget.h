@@ -5,6 +5,7 @@
 #include <Tempest/Event>
 #include <Tempest/Style>
 #include <Tempest/WidgetState>
+#include <Tempest/Layout>
 
 #include <vector>
 #include <memory>
@@ -12,8 +13,18 @@
 
 namespace Tempest {
 
-class Layout;
 class Shortcut;
+class Window;
+class Device;
+class Swapchain;
+class CommandBuffer;
+template<class T>
+class Encoder;
+
+namespace Detail {
+class WidgetIndex;
+struct WidgetLayer;
+}
 
 enum FocusPolicy : uint8_t {
   NoFocus     = 0,
@@ -97,6 +108,13 @@ class Widget {
     void setVisible(bool v);
     bool isVisible() const;
 
+    void setHitTestIndex(bool enable);
+    bool hasHitTestIndex() const { return hitIdx!=nullptr; }
+
+    // cache subtree into offscreen texture; texture is rendered by Window::dispatchLayers, until then subtree is painted directly
+    void setLayer(bool enable);
+    bool isLayer() const { return layer!=nullptr; }
+
     void setFocus(bool b);
     bool hasFocus() const { return wstate.focus; }
 
@@ -167,9 +185,11 @@ class Widget {
       };
 
     struct Additive {
-      Widget*  focus        = nullptr;
-      uint16_t disable      = 0;
-      bool     needToUpdate = false;
+      Widget*  focus         = nullptr;
+      uint16_t disable       = 0;
+      bool     needToUpdate  = false;
+      bool     needToLayout  = false;
+      bool     childToLayout = false;
       };
 
     Widget*                 ow=nullptr;
@@ -189,9 +209,14 @@ class Widget {
     std::vector<Shortcut*>  sCuts;
 
     std::shared_ptr<Ref>    selfRef;
+    std::unique_ptr<Detail::WidgetIndex> hitIdx;
+    std::unique_ptr<Detail::WidgetLayer> layer;
 
     Layout*                 lay=reinterpret_cast<Layout*>(layBuf);
-    char                    layBuf[sizeof(void*)*3]={};
+    // in-place storage for built-in layouts; LinearLayout is the largest
+    alignas(LinearLayout) char layBuf[sizeof(LinearLayout)]={};
+    // top-level window, this widget is attached to
+    Window*                 wnd=nullptr;
 
     const Style*            stl = nullptr;
 
@@ -199,6 +224,12 @@ class Widget {
     void                    implUnregisterSCut(Shortcut* s);
 
     void                    freeLayout() noexcept;
+    void                    implInvalidateLayout();
+    void                    implRequestLayout();
+    static void             implSetWindow(Widget* w, Window* wnd);
+    void                    implFlushLayout();
+    void                    implInvalidateHitTest() noexcept;
+    void                    implUpdateHitTest();
     void                    implDisableSum(Widget *root,int diff) noexcept;
     Widget&                 implAddWidget(Widget* w,size_t at);
     void                    implSetFocus(bool b,Event::FocusReason reason);
@@ -210,6 +241,8 @@ class Widget {
     void                    implAttachFocus();
 
     void                    dispatchPaintEvent (PaintEvent&  e);
+    void                    implPaintLayer(PaintEvent& e);
+    void                    implRenderLayers(Device& dev, Swapchain& sw, Encoder<CommandBuffer>& cmd);
     void                    dispatchPolishEvent(PolishEvent& e);
 
     auto                    selfReference() -> const std::shared_ptr<Ref>&;
@@ -0,0 +1,126 @@
+#include "widgetindex.h"
+
+#include <Tempest/Widget>
+
+#include <algorithm>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+WidgetIndex::WidgetIndex(Widget& owner)
+  :owner(owner) {
+  }
+
+void WidgetIndex::invalidate() {
+  actual = false;
+  }
+
+void WidgetIndex::update(Widget& w) {
+  if(!actual)
+    return;
+  auto it = slot.find(&w);
+  if(it==slot.end()) {
+    actual = false;
+    return;
+    }
+  auto& s = it->second;
+  if(s.visible==w.isVisible() && s.rect==w.rect())
+    return;
+  remove(&w,s);
+  s.rect    = w.rect();
+  s.visible = w.isVisible();
+  insert(&w,s);
+  }
+
+void WidgetIndex::query(const Point& p, std::vector<size_t>& out) {
+  if(!actual)
+    rebuild();
+
+  out.clear();
+  auto c = cell.find(key(cellOf(p.x),cellOf(p.y)));
+  if(c!=cell.end()) {
+    for(auto w:c->second)
+      if(w->rect().contains(p))
+        out.push_back(slot[w].id);
+    }
+  for(auto w:large)
+    if(w->rect().contains(p))
+      out.push_back(slot[w].id);
+
+  // topmost widget first, same as reverse iteration over children
+  std::sort(out.begin(),out.end(),[](size_t a,size_t b){ return a>b; });
+  }
+
+void WidgetIndex::rebuild() {
+  slot.clear();
+  cell.clear();
+  large.clear();
+
+  for(size_t i=0;i<owner.widgetsCount();++i) {
+    Widget& w = owner.widget(i);
+    Slot&   s = slot[&w];
+    s.rect    = w.rect();
+    s.id      = i;
+    s.visible = w.isVisible();
+    insert(&w,s);
+    }
+  actual = true;
+  }
+
+void WidgetIndex::insert(Widget* w, Slot& s) {
+  if(!s.visible || s.rect.w<=0 || s.rect.h<=0)
+    return;
+
+  const int x0 = cellOf(s.rect.x), x1 = cellOf(s.rect.x+s.rect.w-1);
+  const int y0 = cellOf(s.rect.y), y1 = cellOf(s.rect.y+s.rect.h-1);
+  s.large = (int64_t(x1-x0+1)*int64_t(y1-y0+1)>MaxCells);
+  if(s.large) {
+    large.push_back(w);
+    return;
+    }
+
+  for(int y=y0;y<=y1;++y)
+    for(int x=x0;x<=x1;++x)
+      cell[key(x,y)].push_back(w);
+  }
+
+void WidgetIndex::remove(Widget* w, Slot& s) {
+  if(!s.visible || s.rect.w<=0 || s.rect.h<=0)
+    return;
+
+  if(s.large) {
+    erase(large,w);
+    return;
+    }
+
+  const int x0 = cellOf(s.rect.x), x1 = cellOf(s.rect.x+s.rect.w-1);
+  const int y0 = cellOf(s.rect.y), y1 = cellOf(s.rect.y+s.rect.h-1);
+  for(int y=y0;y<=y1;++y)
+    for(int x=x0;x<=x1;++x) {
+      auto c = cell.find(key(x,y));
+      if(c==cell.end())
+        continue;
+      erase(c->second,w);
+      if(c->second.empty())
+        cell.erase(c);
+      }
+  }
+
+int WidgetIndex::cellOf(int v) {
+  if(v>=0)
+    return v/CellSize;
+  return (v-CellSize+1)/CellSize;
+  }
+
+uint64_t WidgetIndex::key(int x, int y) {
+  return (uint64_t(uint32_t(x))<<32) | uint64_t(uint32_t(y));
+  }
+
+void WidgetIndex::erase(std::vector<Widget*>& v, Widget* w) {
+  for(size_t i=0;i<v.size();++i)
+    if(v[i]==w) {
+      v[i] = v.back();
+      v.pop_back();
+      return;
+      }
+  }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Tempest/Rect>
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace Tempest {
+
+class Widget;
+
+namespace Detail {
+
+// uniform grid over direct children of a widget, used for mouse hit-tests
+class WidgetIndex final {
+  public:
+    explicit WidgetIndex(Widget& owner);
+
+    void invalidate();
+    void update(Widget& w);
+
+    bool isActual() const { return actual; }
+    void query(const Point& p, std::vector<size_t>& out);
+
+  private:
+    enum {
+      CellSize = 64,
+      MaxCells = 64,
+      };
+
+    struct Slot {
+      Rect   rect;
+      size_t id     =0;
+      bool   visible=false;
+      bool   large  =false;
+      };
+
+    Widget&                                        owner;
+    std::unordered_map<Widget*,Slot>               slot;
+    std::unordered_map<uint64_t,std::vector<Widget*>> cell;
+    std::vector<Widget*>                           large;
+    bool                                           actual=false;
+
+    void            rebuild();
+    void            insert(Widget* w, Slot& s);
+    void            remove(Widget* w, Slot& s);
+
+    static int      cellOf(int v);
+    static uint64_t key(int x,int y);
+    static void     erase(std::vector<Widget*>& v, Widget* w);
+  };
+
+}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <Tempest/VectorImage>
+#include <Tempest/Attachment>
+#include <Tempest/FrameBuffer>
+#include <Tempest/RenderPass>
+
+namespace Tempest {
+namespace Detail {
+
+// offscreen copy of widget subtree: geometry is kept in 'image' and rendered to 'tex' only after repaint
+struct WidgetLayer final {
+  WidgetLayer() { image.setPremultipliedTarget(true); }
+
+  VectorImage image;
+  Size        size;
+  Attachment  tex;
+  FrameBuffer fbo;
+  RenderPass  pass;
+  bool        needRender=false;
+  bool        sampled=false; // 'tex' is referenced by recorded frame, that may be in flight
+  };
+
+}
+}
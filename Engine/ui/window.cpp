@@ -6,7 +6,8 @@
 using namespace Tempest;
 
 Window::Window() {
-  id = Tempest::SystemApi::createWindow(this,800,600);
+  wnd = this;
+  id  = Tempest::SystemApi::createWindow(this,800,600);
   if(id==nullptr)
     throw std::system_error(Tempest::SystemErrc::UnableToCreateWindow);
   setGeometry(SystemApi::windowClientRect(id));
@@ -15,7 +16,8 @@ Window::Window() {
   }
 
 Window::Window(Window::ShowMode sm) {
-  id = Tempest::SystemApi::createWindow(this,SystemApi::ShowMode(sm));
+  wnd = this;
+  id  = Tempest::SystemApi::createWindow(this,SystemApi::ShowMode(sm));
   if(id==nullptr)
     throw std::system_error(Tempest::SystemErrc::UnableToCreateWindow);
   setGeometry(SystemApi::windowClientRect(id));
@@ -27,10 +29,25 @@ Window::~Window() {
   Tempest::SystemApi::destroyWindow(id);
   }
 
+void Window::setDeferredLayout(bool d) {
+  if(deferLayout==d)
+    return;
+  deferLayout = d;
+  if(!deferLayout)
+    flushLayout();
+  }
+
 void Window::render() {
   }
 
+void Window::flushLayout() {
+  layoutFlush = true;
+  implFlushLayout();
+  layoutFlush = false;
+  }
+
 void Window::dispatchPaintEvent(VectorImage &surface,TextureAtlas& ta) {
+  flushLayout();
   surface.clear();
 
   PaintEvent p(surface,ta,this->w(),this->h());
@@ -39,6 +56,10 @@ void Window::dispatchPaintEvent(VectorImage &surface,TextureAtlas& ta) {
   SystemApi::dispatchOverlayRender(*this,p);
   }
 
+void Window::dispatchLayers(Device& dev, Swapchain& sw, Encoder<CommandBuffer>& cmd) {
+  implRenderLayers(dev,sw,cmd);
+  }
+
 void Window::closeEvent(CloseEvent& e) {
   e.ignore();
   }
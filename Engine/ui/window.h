@@ -21,6 +21,19 @@ class Window : public Widget {
     Window( ShowMode sm );
     ~Window() override;
 
+    void setDeferredLayout(bool d);
+    bool isDeferredLayout() const { return deferLayout; }
+
+    // renders textures of widget layers (see Widget::setLayer), that were repainted by dispatchPaintEvent.
+    // Call after dispatchPaintEvent, before render pass of the surface, in the same encoder:
+    //
+    //   dispatchPaintEvent(surface,atlas);
+    //   auto enc = cmd.startEncoding(device);
+    //   dispatchLayers(device,swapchain,enc);
+    //   enc.setFramebuffer(fbo[imgId],pass);
+    //   surface.draw(device,swapchain,enc);
+    void         dispatchLayers(Device& dev, Swapchain& sw, Encoder<CommandBuffer>& cmd);
+
   protected:
     virtual void render();
     void         dispatchPaintEvent(VectorImage &e,TextureAtlas &ta);
@@ -30,9 +43,14 @@ class Window : public Widget {
 
   private:
     SystemApi::Window* id=nullptr;
+    bool               deferLayout=false;
+    bool               layoutFlush=false;
+
+    void               flushLayout();
 
   friend class UiOverlay;
   friend class EventDispatcher;
+  friend class Widget;
   };
 
 }
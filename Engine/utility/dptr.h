@@ -12,6 +12,16 @@ class Encoder;
 
 namespace Detail {
 
+// destruction sink for gpu objects: deletes them once no in-flight submission can reference them
+class Retirer {
+  public:
+    using Deleter = void(*)(void* obj);
+    virtual void retire(void* obj, Deleter del) = 0;
+
+  protected:
+    ~Retirer()=default;
+  };
+
 template<class Handler>
 class DPtr {
   public:
@@ -85,9 +95,21 @@ class DSharedPtr {
     void decRef() const {
       if(handler->counter.fetch_sub(1,std::memory_order_release)==1) {
         std::atomic_thread_fence(std::memory_order_acquire);
-        delete handler;
+        dispose(handler,0);
         }
       }
+
+    template<class T>
+    static auto dispose(T* h, int) -> decltype(h->retirer, void()) {
+      if(h->retirer!=nullptr)
+        h->retirer->retire(h,[](void* p){ delete reinterpret_cast<T*>(p); }); else
+        delete h;
+      }
+
+    template<class T>
+    static void dispose(T* h, long) {
+      delete h;
+      }
   };
 
 template<class T>
@@ -11,191 +11,504 @@
 #define snprintf sprintf_s
 #endif
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace Tempest;
 
-Log::Context& Log::getCtx() {
-  static Context ctx;
-  return ctx;
-  }
+static const size_t ringSize   = 64*1024;
+static const size_t maxStrLen  = ringSize/4;
+// size(4) + mode(1) + seq(8)
+static const size_t headerSize = 13;
+
+enum WriterState : uint8_t {
+  W_None,
+  W_Alive,
+  W_Destroyed
+  };
+static std::atomic<uint8_t> writerState{W_None};
+static std::atomic<bool>    flushOnError{false};
+
+// single producer (owner thread), single consumer (writer thread)
+struct Log::Ring {
+  Ring():data(new uint8_t[ringSize]) {}
+
+  void put(size_t at, const void* src, size_t sz) {
+    at %= ringSize;
+    const size_t n = std::min(sz,ringSize-at);
+    std::memcpy(data.get()+at,src,n);
+    std::memcpy(data.get(),reinterpret_cast<const uint8_t*>(src)+n,sz-n);
+    }
+
+  void get(size_t at, void* dst, size_t sz) const {
+    at %= ringSize;
+    const size_t n = std::min(sz,ringSize-at);
+    std::memcpy(dst,data.get()+at,n);
+    std::memcpy(reinterpret_cast<uint8_t*>(dst)+n,data.get(),sz-n);
+    }
+
+  std::unique_ptr<uint8_t[]> data;
+  std::atomic<size_t>        head{0};
+  std::atomic<size_t>        tail{0};
+  std::atomic<bool>          orphaned{false};
+  };
+
+struct Log::Writer {
+  struct ThreadRing {
+    ~ThreadRing() {
+      if(ring!=nullptr)
+        ring->orphaned.store(true);
+      }
+    std::shared_ptr<Ring> ring;
+    };
+
+  struct Item {
+    uint64_t seq;
+    size_t   at;
+    };
+
+  struct Span {
+    Mode   mode;
+    size_t at;
+    size_t len;
+    };
+
+  Writer() {
+    writerState.store(W_Alive);
+    th = std::thread([this](){ run(); });
+    }
+
+  ~Writer() {
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    stop = true;
+    }
+    cv.notify_one();
+    th.join();
+    if(file!=nullptr)
+      std::fclose(file);
+    writerState.store(W_Destroyed);
+    }
+
+  Ring& threadRing() {
+    auto& r = local.ring;
+    if(r==nullptr) {
+      r = std::make_shared<Ring>();
+      std::lock_guard<std::mutex> guard(sync);
+      rings.push_back(r);
+      }
+    return *r;
+    }
+
+  void run() {
+    std::unique_lock<std::mutex> lk(sync);
+    while(true) {
+      const uint64_t req = flushReq;
+      const bool     fin = stop;
+      lk.unlock();
+      pending.exchange(false,std::memory_order_acq_rel);
+      drain();
+      lk.lock();
+      flushDone = req;
+      flushCv.notify_all();
+      if(fin)
+        break;
+      cv.wait(lk,[this](){ return stop || flushReq!=flushDone || pending.load(std::memory_order_acquire); });
+      }
+    }
+
+  void drain() {
+    std::vector<std::shared_ptr<Ring>> rs;
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    rs = rings;
+    }
+
+    batch.clear();
+    items.clear();
+    for(auto& r:rs) {
+      const bool orphaned = r->orphaned.load();
+      size_t     t        = r->tail.load(std::memory_order_relaxed);
+      const size_t h      = r->head.load(std::memory_order_acquire);
+      while(t<h) {
+        uint32_t sz  = 0;
+        uint64_t seq = 0;
+        r->get(t,  &sz, 4);
+        r->get(t+5,&seq,8);
+        const size_t at = batch.size();
+        batch.resize(at+sz);
+        r->get(t,batch.data()+at,sz);
+        items.push_back({seq,at});
+        t += sz;
+        }
+      r->tail.store(t,std::memory_order_release);
+      if(orphaned) {
+        std::lock_guard<std::mutex> guard(sync);
+        rings.erase(std::remove(rings.begin(),rings.end(),r),rings.end());
+        }
+      }
+
+    std::sort(items.begin(),items.end(),[](const Item& a,const Item& b){ return a.seq<b.seq; });
 
-void Log::flush(Mode m, char *&out, size_t &count) {
-  Context& c = getCtx();
-  if(count!=sizeof(c.buffer)){
-    *out = '\0';
+    // format without any lock held
+    text.clear();
+    spans.clear();
+    for(auto& i:items) {
+      Mode m = Info;
+      std::memcpy(&m,batch.data()+i.at+4,1);
+      format(line,batch.data()+i.at+headerSize);
+      spans.push_back({m,text.size(),line.size()});
+      text += line;
+      }
+
+    const uint64_t lost = dropped.load();
+    if(lost!=reported) {
+      line  = "Log: ";
+      line += std::to_string(lost-reported);
+      line += " messages dropped";
+      spans.push_back({Error,text.size(),line.size()});
+      text += line;
+      reported = lost;
+      }
+
+    // ioSync is shared only with setFile, producers never wait for output
+    std::lock_guard<std::mutex> guard(ioSync);
+    for(auto& i:spans) {
+      line.assign(text,i.at,i.len);
+      write(i.mode,line);
+      }
+    flushSinks();
+    }
 
+  void write(Mode m, const std::string& l) {
+    if(l.empty())
+      return;
+    if(file!=nullptr) {
+      fileBuf += l;
+      fileBuf += '\n';
+      }
+    if(console)
+      writeConsole(m,l,out,err);
+    }
+
+  void flushSinks() {
+    if(!out.empty()) {
+      std::fwrite(out.data(),1,out.size(),stdout);
+      std::fflush(stdout);
+      out.clear();
+      }
+    if(!err.empty()) {
+      std::fwrite(err.data(),1,err.size(),stderr);
+      std::fflush(stderr);
+      err.clear();
+      }
+    if(!fileBuf.empty() && file!=nullptr) {
+      std::fwrite(fileBuf.data(),1,fileBuf.size(),file);
+      std::fflush(file);
+      }
+    fileBuf.clear();
+    }
+
+  static void writeConsole(Mode m, const std::string& l, std::string& out, std::string& err) {
 #ifdef __ANDROID__
-    switch (m) {
+    (void)out;
+    (void)err;
+    switch(m) {
       case Error:
-        __android_log_print(ANDROID_LOG_ERROR, "app", "%s", c.buffer);
+        __android_log_print(ANDROID_LOG_ERROR, "app", "%s", l.c_str());
         break;
       case Debug:
-        __android_log_print(ANDROID_LOG_DEBUG, "app", "%s", c.buffer);
+        __android_log_print(ANDROID_LOG_DEBUG, "app", "%s", l.c_str());
         break;
       case Info:
       default:
-        __android_log_print(ANDROID_LOG_INFO,  "app", "%s", c.buffer);
+        __android_log_print(ANDROID_LOG_INFO,  "app", "%s", l.c_str());
         break;
       }
-#elif defined(__WINDOWS_PHONE__)
-#if !defined(_DEBUG)
-  OutputDebugStringA(c.buffer);
-  OutputDebugStringA("\r\n");
-#endif
+#elif defined(__WINDOWS_PHONE__) || (defined(_MSC_VER) && !defined(_NDEBUG))
+    (void)m;
+    (void)out;
+    (void)err;
+    OutputDebugStringA(l.c_str());
+    OutputDebugStringA("\r\n");
 #else
-#if defined(_MSC_VER) && !defined(_NDEBUG)
-  (void)m;
-  OutputDebugStringA(c.buffer);
-  OutputDebugStringA("\r\n");
-#else
-  if( m==Error ){
-    std::cerr << c.buffer << std::endl;
-    std::cerr.flush();
-    }
-    else
-    std::cout << c.buffer << std::endl;
-#endif
+    std::string& dst = (m==Error) ? err : out;
+    dst += l;
+    dst += '\n';
 #endif
     }
-  out   = c.buffer;
-  count = sizeof(c.buffer);
-  }
 
-void Log::printImpl(Mode m,char* out, size_t count){
-  flush(m,out,count);
-  }
+  static const uint8_t* format(std::string& l, const uint8_t* p) {
+    l.clear();
+    char sym[64] = {};
+    while(true) {
+      const Type t = Type(*p);
+      ++p;
+      switch(t) {
+        case T_None:
+          return p;
+        case T_Str: {
+          uint32_t len = 0;
+          std::memcpy(&len,p,4);
+          l.append(reinterpret_cast<const char*>(p+4),len);
+          p += 4+len;
+          continue;
+          }
+        case T_Char:
+          l += char(*p);
+          p += 1;
+          continue;
+        case T_Int: {
+          int64_t v = 0;
+          std::memcpy(&v,p,8);
+          snprintf(sym,sizeof(sym),"%lld",static_cast<long long>(v));
+          break;
+          }
+        case T_UInt: {
+          uint64_t v = 0;
+          std::memcpy(&v,p,8);
+          snprintf(sym,sizeof(sym),"%llu",static_cast<unsigned long long>(v));
+          break;
+          }
+        case T_Float: {
+          double v = 0;
+          std::memcpy(&v,p,8);
+          snprintf(sym,sizeof(sym),"%f",v);
+          break;
+          }
+        case T_Ptr: {
+          uint64_t v = 0;
+          std::memcpy(&v,p,8);
+          snprintf(sym,sizeof(sym),"0x%0*llx",int(sizeof(void*)*2),static_cast<unsigned long long>(v));
+          break;
+          }
+        }
+      l += sym;
+      p += 8;
+      }
+    }
 
-void Log::write(Log::Mode m, char *&out, size_t &count, const std::string &msg) {
-  write(m,out,count,msg.c_str());
-  }
+  std::mutex                         sync;
+  std::condition_variable            cv, flushCv;
+  std::vector<std::shared_ptr<Ring>> rings;
+  uint64_t                           flushReq  = 0;
+  uint64_t                           flushDone = 0;
+  bool                               stop      = false;
 
-void Log::write(Mode m, char *&out, size_t &count, float msg) {
-  char sym[16];
-  snprintf(sym,sizeof(sym),"%f",double(msg));
-  write(m,out,count,sym);
-  }
+  // set by producers after push, cleared by writer before drain
+  std::atomic<bool>                  pending{false};
+  std::atomic<uint64_t>              seq{0};
+  std::atomic<uint64_t>              dropped{0};
+  uint64_t                           reported = 0;
 
-void Log::write(Mode m, char *&out, size_t &count, double msg) {
-  char sym[16];
-  snprintf(sym,sizeof(sym),"%f",msg);
-  write(m,out,count,sym);
-  }
+  // guards sinks: held by writer during output and by setFile
+  std::mutex                         ioSync;
+  FILE*                              file    = nullptr;
+  bool                               console = true;
 
-void Log::write(Log::Mode m, char *&out, size_t &count, const void *msg) {
-  char sym[sizeof(void*)*2+3];
-  sym[sizeof(sym)-1] = '\0';
-  int pos = sizeof(sym)-2;
-
-  uintptr_t ptr = uintptr_t(msg);
-  for(size_t i=0; i<sizeof(void*)*2; ++i){
-    auto num = ptr%16;
-    sym[pos] = num<=9 ? char(num+'0') : char(num-10+'a');
-    ptr/=16;
-    --pos;
-    }
-  sym[pos] = 'x';
-  --pos;
-  sym[pos] = '0';
-  write(m,out,count,sym+pos);
-  }
+  // writer thread only
+  std::vector<uint8_t>               batch;
+  std::vector<Item>                  items;
+  std::vector<Span>                  spans;
+  std::string                        line, text, out, err, fileBuf;
 
-void Log::write(Log::Mode m, char *&out, size_t &count, std::thread::id msg) {
-  std::hash<std::thread::id> h;
-  write(m,out,count,h(msg));
-  }
+  std::thread                        th;
 
-void Log::write(Mode m, char*& out, size_t& count, int16_t msg){
-  writeInt(m,out,count,msg);
-  }
+  static thread_local ThreadRing     local;
+  };
 
-void Log::write(Log::Mode m, char *&out, size_t &count, uint16_t msg) {
-  writeUInt(m,out,count,msg);
-  }
+thread_local Log::Writer::ThreadRing Log::Writer::local;
 
-void Log::write(Mode m, char*& out, size_t& count, int32_t msg){
-  writeInt(m,out,count,msg);
+Log::Writer& Log::writer() {
+  static Writer w;
+  return w;
   }
 
-void Log::write(Log::Mode m, char *&out, size_t &count, uint32_t msg) {
-  writeUInt(m,out,count,msg);
-  }
+void Log::emit(Mode m, const Arg* args, size_t count) {
+  size_t sz = headerSize+1;
+  for(size_t i=0;i<count;++i) {
+    auto& a = args[i];
+    switch(a.type) {
+      case T_None:  break;
+      case T_Str:   sz += 1+4+a.len; break;
+      case T_Char:  sz += 1+1;       break;
+      default:      sz += 1+8;       break;
+      }
+    }
 
-void Log::write(Log::Mode m, char *&out, size_t &count, int64_t msg) {
-  writeInt(m,out,count,msg);
-  }
+  if(writerState.load()==W_Destroyed) {
+    // static destruction: no writer thread anymore
+    std::vector<uint8_t> rec(sz);
+    encode(rec.data(),m,0,args,count);
+    std::string l, out, err;
+    Writer::format(l,rec.data()+headerSize);
+    if(l.empty())
+      return;
+    Writer::writeConsole(m,l,out,err);
+    std::fwrite(out.data(),1,out.size(),stdout);
+    std::fwrite(err.data(),1,err.size(),stderr);
+    return;
+    }
+
+  Writer& w = writer();
+  Ring&   r = w.threadRing();
+  const size_t h = r.head.load(std::memory_order_relaxed);
+  size_t       t = r.tail.load(std::memory_order_acquire);
+  if(sz>ringSize-(h-t) && m==Error && flushOnError.load(std::memory_order_relaxed)) {
+    flush();
+    t = r.tail.load(std::memory_order_acquire);
+    }
+  if(sz>ringSize-(h-t)) {
+    w.dropped.fetch_add(1,std::memory_order_relaxed);
+    return;
+    }
+
+  uint8_t  buf[256];
+  uint8_t* rec = sz<=sizeof(buf) ? buf : nullptr;
+  std::unique_ptr<uint8_t[]> big;
+  if(rec==nullptr) {
+    big.reset(new uint8_t[sz]);
+    rec = big.get();
+    }
+  encode(rec,m,w.seq.fetch_add(1,std::memory_order_relaxed),args,count);
+  r.put(h,rec,sz);
+  r.head.store(h+sz,std::memory_order_release);
 
-void Log::write(Log::Mode m, char *&out, size_t &count, uint64_t msg) {
-  writeUInt(m,out,count,msg);
+  if(!w.pending.exchange(true,std::memory_order_acq_rel)) {
+    // lock pairs with predicate check in Writer::run: no lost wakeup;
+    // writer never holds sync during output, so this is short
+    std::lock_guard<std::mutex> guard(w.sync);
+    w.cv.notify_one();
+    }
+
+  if(m==Error && flushOnError.load(std::memory_order_relaxed))
+    flush();
   }
 
-void Log::write(Mode m, char*& out, size_t& count, const char* msg){
-  while(*msg){
-    if(count<=1)
-      flush(m,out,count);
-    if(*msg=='\n'){
-      flush(m,out,count);
-      ++msg;
-      } else {
-      *out = *msg;
-      ++out;
-      ++msg;
-      --count;
+void Log::encode(uint8_t* out, Mode m, uint64_t seq, const Arg* args, size_t count) {
+  uint8_t* p = out+headerSize;
+  for(size_t i=0;i<count;++i) {
+    auto& a = args[i];
+    if(a.type==T_None)
+      continue;
+    *p = a.type;
+    ++p;
+    switch(a.type) {
+      case T_None:
+        break;
+      case T_Str: {
+        const uint32_t len = uint32_t(a.len);
+        std::memcpy(p,&len,4);
+        std::memcpy(p+4,a.str,len);
+        p += 4+len;
+        break;
+        }
+      case T_Char:
+        *p = uint8_t(a.i);
+        p += 1;
+        break;
+      case T_Int:
+      case T_UInt:
+      case T_Float:
+      case T_Ptr:
+        std::memcpy(p,&a.u,8);
+        p += 8;
+        break;
       }
     }
+  *p = T_None;
+  ++p;
+
+  const uint32_t sz = uint32_t(p-out);
+  std::memcpy(out,  &sz, 4);
+  std::memcpy(out+4,&m,  1);
+  std::memcpy(out+5,&seq,8);
   }
 
-void Log::write(Log::Mode m, char *&out, size_t &count, char msg) {
-  if(count<=1)
-    flush(m,out,count);
-  *out = msg;
-  ++out;
-  ++msg;
-  --count;
+void Log::flush() {
+  if(writerState.load()!=W_Alive) {
+    std::fflush(stdout);
+    std::fflush(stderr);
+    return;
+    }
+  Writer& w = writer();
+  std::unique_lock<std::mutex> lk(w.sync);
+  const uint64_t ticket = ++w.flushReq;
+  w.cv.notify_one();
+  w.flushCv.wait(lk,[&](){ return w.flushDone>=ticket; });
+  }
+
+bool Log::setFile(const char* path, bool console) {
+  Writer& w = writer();
+  flush();
+
+  FILE* f = nullptr;
+  if(path!=nullptr) {
+#if defined(_MSC_VER)
+    if(fopen_s(&f,path,"ab")!=0)
+      f = nullptr;
+#else
+    f = std::fopen(path,"ab");
+#endif
+    if(f==nullptr)
+      return false;
+    }
+
+  std::lock_guard<std::mutex> guard(w.ioSync);
+  if(w.file!=nullptr)
+    std::fclose(w.file);
+  w.file    = f;
+  w.console = console || f==nullptr;
+  return true;
   }
 
-void Log::write(Log::Mode m, char *&out, size_t &count, int8_t msg) {
-  writeInt(m,out,count,msg);
+void Log::setFlushOnError(bool sync) {
+  flushOnError.store(sync);
   }
 
-void Log::write(Log::Mode m, char *&out, size_t &count, uint8_t msg) {
-  writeUInt(m,out,count,msg);
+uint64_t Log::dropped() {
+  if(writerState.load()!=W_Alive)
+    return 0;
+  return writer().dropped.load();
   }
 
-template< class T >
-void Log::writeInt(Mode m, char*& out, size_t& count, T msg){
-  char sym[32];
-  sym[sizeof(sym)-1] = '\0';
-  int pos = sizeof(sym)-2;
+Log::Arg Log::arg(const std::string& msg) {
+  Arg a;
+  a.type = T_Str;
+  a.str  = msg.data();
+  a.len  = std::min(msg.size(),maxStrLen);
+  return a;
+  }
 
-  if(msg<0){
-    write(m,out,count,'-');
-    msg = -msg;
-    }
+Log::Arg Log::arg(const char* msg) {
+  Arg a;
+  a.type = T_Str;
+  a.str  = msg==nullptr ? "" : msg;
+  a.len  = std::min(std::strlen(a.str),maxStrLen);
+  return a;
+  }
 
-  while(pos>=0){
-    sym[pos] = msg%10+'0';
-    msg/=10;
-    if(msg==0)
-      break;
-    --pos;
-    }
-  write(m,out,count,sym+pos);
+Log::Arg Log::arg(char msg) {
+  Arg a;
+  a.type = T_Char;
+  a.i    = msg;
+  return a;
   }
 
-template< class T >
-void Log::writeUInt(Mode m, char*& out, size_t& count, T msg){
-  char sym[32];
-  sym[sizeof(sym)-1] = '\0';
-  int pos = sizeof(sym)-2;
+Log::Arg Log::arg(const void* msg) {
+  Arg a;
+  a.type = T_Ptr;
+  a.u    = uint64_t(uintptr_t(msg));
+  return a;
+  }
 
-  while(pos>=0){
-    sym[pos] = msg%10+'0';
-    msg/=10;
-    if(msg==0)
-      break;
-    --pos;
-    }
-  write(m,out,count,sym+pos);
+Log::Arg Log::arg(std::thread::id msg) {
+  std::hash<std::thread::id> h;
+  return uarg(h(msg));
   }
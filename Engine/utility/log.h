@@ -1,83 +1,99 @@
 #pragma once
 
-#include <sstream>
-#include <mutex>
+#include <string>
+#include <cstddef>
 #include <cstdint>
 #include <thread>
 
 namespace Tempest{
 
+// asynchronous logger: arguments are stored as binary records in per-thread ring buffer,
+// formatting and output happen on background writer thread
 class Log final {
   public:
     template< class ... Args >
     static void i(const Args& ... args){
-      Context& c = getCtx();
-      std::lock_guard<std::mutex> g(c.mutex);
-      (void)g;
-      printImpl(Info,c.buffer,sizeof(c.buffer),args...);
+      const Arg a[sizeof...(args)+1] = {arg(args)...};
+      emit(Info,a,sizeof...(args));
       }
 
     template< class ... Args >
     static void d(const Args& ... args){
-      Context& c = getCtx();
-      std::lock_guard<std::mutex> g(c.mutex);
-      (void)g;
-      printImpl(Debug,c.buffer,sizeof(c.buffer),args...);
+      const Arg a[sizeof...(args)+1] = {arg(args)...};
+      emit(Debug,a,sizeof...(args));
       }
 
     template< class ... Args >
     static void e(const Args& ... args){
-      Context& c = getCtx();
-      std::lock_guard<std::mutex> g(c.mutex);
-      (void)g;
-      printImpl(Error,c.buffer,sizeof(c.buffer),args...);
+      const Arg a[sizeof...(args)+1] = {arg(args)...};
+      emit(Error,a,sizeof...(args));
       }
 
+    // blocks until everything logged before this call is written
+    static void     flush();
+    // Log::e blocks until message is written; off by default, so logging keeps bounded latency
+    static void     setFlushOnError(bool sync);
+    // additionally write log to file; nullptr closes the file
+    static bool     setFile(const char* path, bool console=true);
+    // number of messages lost, because thread buffer was full
+    static uint64_t dropped();
+
   private:
-    enum Mode {
+    enum Mode : uint8_t {
       Info,
       Error,
       Debug
       };
 
-    struct Context {
-      char buffer[128];
-      std::mutex mutex;
+    enum Type : uint8_t {
+      T_None,
+      T_Str,
+      T_Char,
+      T_Int,
+      T_UInt,
+      T_Float,
+      T_Ptr,
       };
 
-    Log() = delete;
+    struct Arg {
+      Type type = T_None;
+      union {
+        const char* str;
+        int64_t     i;
+        uint64_t    u;
+        double      f;
+        const void* ptr;
+        };
+      size_t        len = 0;
+      };
 
-    static Context& getCtx();
+    struct Ring;
+    struct Writer;
 
-    static void flush(Mode m, char*& msg, size_t& count);
-    static void write(Mode m, char*& out, size_t& count, const std::string& msg);
-    static void write(Mode m, char*& out, size_t& count, const char*     msg);
-    static void write(Mode m, char*& out, size_t& count, char            msg);
-    static void write(Mode m, char*& out, size_t& count, int8_t          msg);
-    static void write(Mode m, char*& out, size_t& count, uint8_t         msg);
-    static void write(Mode m, char*& out, size_t& count, int16_t         msg);
-    static void write(Mode m, char*& out, size_t& count, uint16_t        msg);
-    static void write(Mode m, char*& out, size_t& count, int32_t         msg);
-    static void write(Mode m, char*& out, size_t& count, uint32_t        msg);
-    static void write(Mode m, char*& out, size_t& count, uint64_t        msg);
-    static void write(Mode m, char*& out, size_t& count, int64_t         msg);
-    static void write(Mode m, char*& out, size_t& count, float           msg);
-    static void write(Mode m, char*& out, size_t& count, double          msg);
-    static void write(Mode m, char*& out, size_t& count, const void*     msg);
-    static void write(Mode m, char*& out, size_t& count, std::thread::id msg);
+    Log() = delete;
 
-    static void printImpl(Mode m,char* out, size_t count);
-    template<class T, class ... Args>
-    static void printImpl(Mode m, char* out, size_t count,
-                          const T& t, const Args& ... args){
-      write(m,out,count,t);
-      printImpl(m,out,count,args...);
-      }
+    static Writer& writer();
+    static void    emit(Mode m, const Arg* args, size_t count);
+    static void    encode(uint8_t* out, Mode m, uint64_t seq, const Arg* args, size_t count);
 
-    template< class T >
-    static void writeInt(Mode m, char*& out, size_t& count, T msg);
+    static Arg arg(const std::string& msg);
+    static Arg arg(const char*     msg);
+    static Arg arg(char            msg);
+    static Arg arg(int8_t          msg) { return iarg(msg); }
+    static Arg arg(uint8_t         msg) { return uarg(msg); }
+    static Arg arg(int16_t         msg) { return iarg(msg); }
+    static Arg arg(uint16_t        msg) { return uarg(msg); }
+    static Arg arg(int32_t         msg) { return iarg(msg); }
+    static Arg arg(uint32_t        msg) { return uarg(msg); }
+    static Arg arg(uint64_t        msg) { return uarg(msg); }
+    static Arg arg(int64_t         msg) { return iarg(msg); }
+    static Arg arg(float           msg) { return farg(double(msg)); }
+    static Arg arg(double          msg) { return farg(msg); }
+    static Arg arg(const void*     msg);
+    static Arg arg(std::thread::id msg);
 
-    template< class T >
-    static void writeUInt(Mode m, char*& out, size_t& count, T msg);
+    static Arg iarg(int64_t  v) { Arg a; a.type=T_Int;   a.i=v; return a; }
+    static Arg uarg(uint64_t v) { Arg a; a.type=T_UInt;  a.u=v; return a; }
+    static Arg farg(double   v) { Arg a; a.type=T_Float; a.f=v; return a; }
   };
 }
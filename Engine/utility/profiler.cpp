@@ -0,0 +1,227 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace Tempest;
+
+std::atomic<bool> Profiler::enabled{false};
+
+struct Profiler::Ring {
+  enum : uint64_t {
+    Size = 1<<14,
+    Mask = Size-1,
+    };
+
+  // fields are atomic, so dump can read ring, while owner thread writes it
+  struct Event {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t>    time{0};
+    std::atomic<int64_t>     value{0};
+    std::atomic<uint8_t>     kind{0};
+    };
+
+  struct Snapshot {
+    const char* name;
+    uint64_t    time;
+    int64_t     value;
+    Kind        kind;
+    };
+
+  explicit Ring(uint32_t tid):ev(new Event[Size]), tid(tid) {}
+
+  void push(Kind k, const char* name, uint64_t time, int64_t value) {
+    const uint64_t h = head.load(std::memory_order_relaxed);
+    Event&         e = ev[h&Mask];
+    e.name .store(name, std::memory_order_relaxed);
+    e.time .store(time, std::memory_order_relaxed);
+    e.value.store(value,std::memory_order_relaxed);
+    e.kind .store(k,    std::memory_order_relaxed);
+    head.store(h+1,std::memory_order_release);
+    }
+
+  void read(std::vector<Snapshot>& out) const {
+    const uint64_t h0    = head.load(std::memory_order_acquire);
+    const uint64_t begin = h0>Size ? h0-Size : 0;
+    const size_t   base  = out.size();
+    for(uint64_t i=begin;i<h0;++i) {
+      const Event& e = ev[i&Mask];
+      out.push_back({e.name.load(std::memory_order_relaxed),e.time.load(std::memory_order_relaxed),
+                     e.value.load(std::memory_order_relaxed),Kind(e.kind.load(std::memory_order_relaxed))});
+      }
+    // writer may have overwritten oldest events, while they were copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t h1 = head.load(std::memory_order_relaxed);
+    if(h1>=Size && h1-Size+1>begin) {
+      const size_t lost = size_t(std::min(h1-Size+1,h0)-begin);
+      out.erase(out.begin()+ptrdiff_t(base),out.begin()+ptrdiff_t(base+lost));
+      }
+    }
+
+  std::unique_ptr<Event[]> ev;
+  std::atomic<uint64_t>    head{0};
+  const uint32_t           tid;
+  std::atomic<const char*> threadName{nullptr};
+  std::atomic<bool>        orphaned{false};
+  };
+
+struct Profiler::Registry {
+  struct ThreadRing {
+    ~ThreadRing() {
+      if(ring!=nullptr)
+        ring->orphaned.store(true);
+      }
+    std::shared_ptr<Ring> ring;
+    };
+
+  std::mutex                         sync;
+  std::vector<std::shared_ptr<Ring>> rings;
+  Counter*                           counters = nullptr;
+  uint32_t                           nextTid  = 1;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  static thread_local ThreadRing     local;
+  };
+
+thread_local Profiler::Registry::ThreadRing Profiler::Registry::local;
+
+Profiler::Registry& Profiler::registry() {
+  static Registry r;
+  return r;
+  }
+
+Profiler::Counter::Counter(const char* name)
+  :name(name) {
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.sync);
+  next       = r.counters;
+  r.counters = this;
+  }
+
+void Profiler::setEnabled(bool e) {
+  registry();
+  enabled.store(e);
+  }
+
+uint64_t Profiler::now() {
+  auto dt = std::chrono::steady_clock::now()-registry().start;
+  // zero is reserved for 'zone is not recorded'
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count())+1;
+  }
+
+Profiler::Ring& Profiler::threadRing() {
+  auto& r = Registry::local.ring;
+  if(r==nullptr) {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.sync);
+    r = std::make_shared<Ring>(reg.nextTid++);
+    reg.rings.push_back(r);
+    }
+  return *r;
+  }
+
+void Profiler::push(Kind k, const char* name, uint64_t time, int64_t value) {
+  threadRing().push(k,name,time,value);
+  }
+
+void Profiler::complete(const char* name, uint64_t start) {
+  const uint64_t end = now();
+  push(K_Zone,name,start,int64_t(end-start));
+  }
+
+void Profiler::counter(const char* name, int64_t value) {
+  if(!isEnabled())
+    return;
+  push(K_Counter,name,now(),value);
+  }
+
+void Profiler::frame() {
+  if(!isEnabled())
+    return;
+  const uint64_t t = now();
+  push(K_Frame,"frame",t,0);
+
+  auto& reg = registry();
+  std::lock_guard<std::mutex> guard(reg.sync);
+  for(auto c=reg.counters;c!=nullptr;c=c->next)
+    push(K_Counter,c->name,t,c->value.exchange(0,std::memory_order_relaxed));
+  }
+
+void Profiler::setThreadName(const char* name) {
+  threadRing().threadName.store(name);
+  }
+
+static void writeString(std::FILE* f, const char* s) {
+  std::fputc('"',f);
+  for(;s!=nullptr && *s;++s) {
+    const unsigned char c = static_cast<unsigned char>(*s);
+    if(c=='"' || c=='\\')
+      std::fprintf(f,"\\%c",c); else
+    if(c<0x20)
+      std::fprintf(f,"\\u%04x",c); else
+      std::fputc(c,f);
+    }
+  std::fputc('"',f);
+  }
+
+bool Profiler::dump(const char* path) {
+  std::FILE* f = std::fopen(path,"wb");
+  if(f==nullptr)
+    return false;
+
+  auto& reg = registry();
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+  std::lock_guard<std::mutex> guard(reg.sync);
+  rings = reg.rings;
+  // data of finished threads is written one last time
+  reg.rings.erase(std::remove_if(reg.rings.begin(),reg.rings.end(),[](const std::shared_ptr<Ring>& r){
+    return r->orphaned.load();
+    }),reg.rings.end());
+  }
+
+  std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n",f);
+  bool                       first = true;
+  std::vector<Ring::Snapshot> ev;
+  for(auto& r:rings) {
+    if(auto name = r->threadName.load()) {
+      std::fprintf(f,"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                   first ? "" : ",\n",unsigned(r->tid));
+      writeString(f,name);
+      std::fputs("}}",f);
+      first = false;
+      }
+
+    ev.clear();
+    r->read(ev);
+    for(auto& e:ev) {
+      std::fputs(first ? "" : ",\n",f);
+      first = false;
+
+      const double ts = double(e.time-1)/1000.0;
+      switch(e.kind) {
+        case K_Zone:
+          std::fputs("{\"ph\":\"X\",\"name\":",f);
+          writeString(f,e.name);
+          std::fprintf(f,",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",unsigned(r->tid),ts,double(e.value)/1000.0);
+          break;
+        case K_Counter:
+          std::fputs("{\"ph\":\"C\",\"name\":",f);
+          writeString(f,e.name);
+          std::fprintf(f,",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}",unsigned(r->tid),ts,static_cast<long long>(e.value));
+          break;
+        case K_Frame:
+          std::fprintf(f,"{\"ph\":\"i\",\"s\":\"g\",\"name\":\"frame\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",unsigned(r->tid),ts);
+          break;
+        }
+      }
+    }
+  std::fputs("\n]}\n",f);
+
+  const bool ok = std::ferror(f)==0;
+  return std::fclose(f)==0 && ok;
+  }
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// engine instrumentation; compiled in with TEMPEST_PROFILING, recording is enabled at runtime by Profiler::setEnabled
+#define T_PROFILE_CAT2(a,b) a##b
+#define T_PROFILE_CAT(a,b)  T_PROFILE_CAT2(a,b)
+
+#if defined(TEMPEST_PROFILING)
+#define T_PROFILE_ZONE(name)             ::Tempest::Profiler::Zone T_PROFILE_CAT(tProfileZone,__LINE__)(name)
+#define T_PROFILE_COUNTER(var,name)      static ::Tempest::Profiler::Counter var(name)
+#define T_PROFILE_ADD(var,n)             var.add(n)
+#define T_PROFILE_FRAME()                ::Tempest::Profiler::frame()
+#else
+#define T_PROFILE_ZONE(name)
+#define T_PROFILE_COUNTER(var,name)
+#define T_PROFILE_ADD(var,n)
+#define T_PROFILE_FRAME()
+#endif
+
+namespace Tempest {
+
+// cpu profiler: zones are written to per-thread ring buffers (oldest events are overwritten),
+// dump writes chrome trace json, loadable in Perfetto or chrome://tracing
+class Profiler final {
+  public:
+    Profiler() = delete;
+
+    class Zone final {
+      public:
+        explicit Zone(const char* name):name(name), start(isEnabled() ? now() : 0) {}
+        ~Zone() { if(start!=0) complete(name,start); }
+        Zone(const Zone&) = delete;
+        Zone& operator = (const Zone&) = delete;
+
+      private:
+        const char* name;
+        uint64_t    start;
+      };
+
+    // accumulates value during a frame; sampled and reset by frame()
+    class Counter final {
+      public:
+        explicit Counter(const char* name);
+        Counter(const Counter&) = delete;
+        Counter& operator = (const Counter&) = delete;
+
+        void add(int64_t n) { if(isEnabled()) value.fetch_add(n,std::memory_order_relaxed); }
+
+      private:
+        const char*          name;
+        std::atomic<int64_t> value{0};
+        Counter*             next = nullptr;
+      friend class Profiler;
+      };
+
+    static void setEnabled(bool e);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // frame marker + samples of all counters
+    static void frame();
+    // instant counter sample
+    static void counter(const char* name, int64_t value);
+    // names events of calling thread in trace
+    static void setThreadName(const char* name);
+
+    static bool dump(const char* path);
+
+  private:
+    struct Ring;
+    struct Registry;
+
+    enum Kind : uint8_t {
+      K_Zone,
+      K_Counter,
+      K_Frame,
+      };
+
+    static std::atomic<bool> enabled;
+
+    static uint64_t now();
+    static void     complete(const char* name, uint64_t start);
+    static void     push(Kind k, const char* name, uint64_t time, int64_t value);
+    static Ring&    threadRing();
+    static Registry& registry();
+  };
+
+}
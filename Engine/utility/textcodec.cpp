@@ -2,74 +2,322 @@
 
 #include "utf8_helper.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define TEMPEST_TEXT_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TEMPEST_TEXT_NEON
+#include <arm_neon.h>
+#endif
+
 using namespace Tempest;
 
-std::string TextCodec::toUtf8(const std::u16string &s) {
-  return toUtf8(s.c_str());
+const size_t TextCodec::npos;
+
+namespace {
+
+// converts leading ascii run; returns number of code units consumed, multiple of vector width
+size_t asciiToUtf16(const uint8_t* s, size_t len, char16_t* dst) {
+  size_t i = 0;
+#if defined(TEMPEST_TEXT_SSE)
+  const __m128i zero = _mm_setzero_si128();
+  for(;i+32<=len;i+=32) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i+16));
+    if(_mm_movemask_epi8(_mm_or_si128(a,b))!=0)
+      break;
+    __m128i* d = reinterpret_cast<__m128i*>(dst+i);
+    _mm_storeu_si128(d+0,_mm_unpacklo_epi8(a,zero));
+    _mm_storeu_si128(d+1,_mm_unpackhi_epi8(a,zero));
+    _mm_storeu_si128(d+2,_mm_unpacklo_epi8(b,zero));
+    _mm_storeu_si128(d+3,_mm_unpackhi_epi8(b,zero));
+    }
+  for(;i+16<=len;i+=16) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s+i));
+    if(_mm_movemask_epi8(a)!=0)
+      break;
+    __m128i* d = reinterpret_cast<__m128i*>(dst+i);
+    _mm_storeu_si128(d+0,_mm_unpacklo_epi8(a,zero));
+    _mm_storeu_si128(d+1,_mm_unpackhi_epi8(a,zero));
+    }
+#elif defined(TEMPEST_TEXT_NEON)
+  for(;i+16<=len;i+=16) {
+    const uint8x16_t a = vld1q_u8(s+i);
+    if(vmaxvq_u8(a)>=0x80)
+      break;
+    uint16_t* d = reinterpret_cast<uint16_t*>(dst+i);
+    vst1q_u16(d+0,vmovl_u8(vget_low_u8(a)));
+    vst1q_u16(d+8,vmovl_high_u8(a));
+    }
+#else
+  (void)s;
+  (void)len;
+  (void)dst;
+#endif
+  return i;
   }
 
-std::string TextCodec::toUtf8(const char16_t *inS) {
-  const uint16_t* s  = reinterpret_cast<const uint16_t*>(inS);
+size_t asciiToUtf8(const char16_t* s, size_t len, char* dst) {
+  size_t i = 0;
+#if defined(TEMPEST_TEXT_SSE)
+  const __m128i mask = _mm_set1_epi16(int16_t(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  for(;i+32<=len;i+=32) {
+    const __m128i* p = reinterpret_cast<const __m128i*>(s+i);
+    const __m128i  a = _mm_loadu_si128(p+0);
+    const __m128i  b = _mm_loadu_si128(p+1);
+    const __m128i  c = _mm_loadu_si128(p+2);
+    const __m128i  d = _mm_loadu_si128(p+3);
+    const __m128i  x = _mm_and_si128(_mm_or_si128(_mm_or_si128(a,b),_mm_or_si128(c,d)),mask);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi16(x,zero))!=0xFFFF)
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),   _mm_packus_epi16(a,b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i+16),_mm_packus_epi16(c,d));
+    }
+  for(;i+16<=len;i+=16) {
+    const __m128i* p = reinterpret_cast<const __m128i*>(s+i);
+    const __m128i  a = _mm_loadu_si128(p+0);
+    const __m128i  b = _mm_loadu_si128(p+1);
+    const __m128i  x = _mm_and_si128(_mm_or_si128(a,b),mask);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi16(x,zero))!=0xFFFF)
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+i),_mm_packus_epi16(a,b));
+    }
+#elif defined(TEMPEST_TEXT_NEON)
+  for(;i+16<=len;i+=16) {
+    const uint16_t*  p = reinterpret_cast<const uint16_t*>(s+i);
+    const uint16x8_t a = vld1q_u16(p);
+    const uint16x8_t b = vld1q_u16(p+8);
+    if(vmaxvq_u16(vorrq_u16(a,b))>=0x80)
+      break;
+    vst1q_u8(reinterpret_cast<uint8_t*>(dst+i),vcombine_u8(vmovn_u16(a),vmovn_u16(b)));
+    }
+#else
+  (void)s;
+  (void)len;
+  (void)dst;
+#endif
+  return i;
+  }
 
-  size_t sz=0;
-  for(size_t i=0;s[i];) {
-    uint32_t cp = 0;
-    size_t   l  = Detail::utf16ToCodepoint(&s[i],cp);
-    sz += Detail::codepointToUtf8(cp);
-    i  += l;
+// decodes one non-ascii sequence; returns length or 0 if malformed
+inline size_t decodeUtf8(const uint8_t* s, size_t avail, uint32_t& cp) {
+  const uint32_t c0 = s[0];
+  if(c0>=0xE0) {
+    if(avail<3)
+      return 0;
+    const uint32_t c1 = s[1], c2 = s[2];
+    if(c0<=0xEF) {
+      if(((c1 & 0xC0) | ((c2 & 0xC0) << 8))!=0x8080)
+        return 0;
+      if((c0==0xE0 && c1<0xA0) || (c0==0xED && c1>=0xA0)) // overlong or surrogate
+        return 0;
+      cp = ((c0 & 0x0F) << 12) | ((c1 & 0x3F) << 6) | (c2 & 0x3F);
+      return 3;
+      }
+    if(c0>0xF4 || avail<4)
+      return 0;
+    const uint32_t c3 = s[3];
+    if(((c1 & 0xC0) | ((c2 & 0xC0) << 8) | ((c3 & 0xC0) << 16))!=0x808080)
+      return 0;
+    if((c0==0xF0 && c1<0x90) || (c0==0xF4 && c1>=0x90))        // overlong or above U+10FFFF
+      return 0;
+    cp = ((c0 & 0x07) << 18) | ((c1 & 0x3F) << 12) | ((c2 & 0x3F) << 6) | (c3 & 0x3F);
+    return 4;
     }
+  if(c0<0xC2 || avail<2 || (s[1] & 0xC0)!=0x80)
+    return 0;
+  cp = ((c0 & 0x1F) << 6) | (s[1] & 0x3F);
+  return 2;
+  }
 
-  std::string u(sz,'?');
-  sz=0;
-  for(size_t i=0;s[i];) {
-    uint32_t cp = 0;
-    size_t   l  = Detail::utf16ToCodepoint(&s[i],cp);
-    sz += Detail::codepointToUtf8(cp,&u[sz]);
-    i  += l;
+inline void error(TextCodec::Result& r, size_t at) {
+  if(r.errors==0)
+    r.firstError = at;
+  ++r.errors;
+  }
+
+template<bool write>
+TextCodec::Result utf8ToUtf16(const uint8_t* s, size_t len, char16_t* dst) {
+  TextCodec::Result r;
+  char16_t* out = dst;
+  size_t    i   = 0;
+  while(i<len) {
+    if(s[i]<0x80) {
+      if(write) {
+        const size_t n = asciiToUtf16(s+i,len-i,out);
+        i   += n;
+        out += n;
+        }
+      while(i<len && s[i]<0x80) {
+        if(write)
+          *out = char16_t(s[i]);
+        ++out;
+        ++i;
+        }
+      continue;
+      }
+
+    uint32_t     cp = 0;
+    const size_t l  = decodeUtf8(s+i,len-i,cp);
+    if(l==0) {
+      error(r,i);
+      if(write)
+        *out = u'?';
+      ++out;
+      ++i;
+      continue;
+      }
+    if(cp>0xFFFF) {
+      cp -= 0x10000;
+      if(write) {
+        out[0] = char16_t(0xD800 + (cp >> 10));
+        out[1] = char16_t(0xDC00 + (cp & 0x3FF));
+        }
+      out += 2;
+      } else {
+      if(write)
+        *out = char16_t(cp);
+      ++out;
+      }
+    i += l;
     }
+  r.length = size_t(out-dst);
+  return r;
+  }
+
+template<bool write>
+TextCodec::Result utf16ToUtf8(const char16_t* s, size_t len, char* dst) {
+  TextCodec::Result r;
+  char*  out = dst;
+  size_t i   = 0;
+  while(i<len) {
+    uint32_t cp = s[i];
+    if(cp<0x80) {
+      if(write) {
+        const size_t n = asciiToUtf8(s+i,len-i,out);
+        i   += n;
+        out += n;
+        }
+      while(i<len && s[i]<0x80) {
+        if(write)
+          *out = char(s[i]);
+        ++out;
+        ++i;
+        }
+      continue;
+      }
+
+    if(cp<0x800) {
+      if(write) {
+        out[0] = char(0xC0 | (cp >> 6));
+        out[1] = char(0x80 | (cp & 0x3F));
+        }
+      out += 2;
+      ++i;
+      continue;
+      }
+
+    if(0xD800<=cp && cp<=0xDFFF) {
+      const uint32_t next = i+1<len ? s[i+1] : 0;
+      if(cp>0xDBFF || next<0xDC00 || next>0xDFFF) {
+        error(r,i);
+        if(write)
+          *out = '?';
+        ++out;
+        ++i;
+        continue;
+        }
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (next - 0xDC00);
+      if(write) {
+        out[0] = char(0xF0 | (cp >> 18));
+        out[1] = char(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = char(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = char(0x80 | (cp & 0x3F));
+        }
+      out += 4;
+      i   += 2;
+      continue;
+      }
 
+    if(write) {
+      out[0] = char(0xE0 | (cp >> 12));
+      out[1] = char(0x80 | ((cp >> 6) & 0x3F));
+      out[2] = char(0x80 | (cp & 0x3F));
+      }
+    out += 3;
+    ++i;
+    }
+  r.length = size_t(out-dst);
+  return r;
+  }
+
+size_t length(const char16_t* s) {
+  size_t n = 0;
+  while(s[n])
+    ++n;
+  return n;
+  }
+
+}
+
+std::string TextCodec::toUtf8(const std::u16string &s) {
+  return toUtf8(s.data(),s.size());
+  }
+
+std::string TextCodec::toUtf8(const char16_t *s) {
+  return toUtf8(s,length(s));
+  }
+
+std::string TextCodec::toUtf8(const char16_t* s, size_t len) {
+  std::string u(len*3,'\0');
+  auto r = toUtf8(s,len,&u[0]);
+  u.resize(r.length);
+  if(u.capacity()-u.size()>64*1024)
+    u.shrink_to_fit();
   return u;
   }
 
+TextCodec::Result TextCodec::toUtf8(const char16_t* s, size_t len, char* dst) {
+  return utf16ToUtf8<true>(s,len,dst);
+  }
+
 void TextCodec::toUtf8(const uint32_t codePoint, char (&ret)[3]) {
   size_t sz = Detail::codepointToUtf8(codePoint,ret);
   ret[sz] = '\0';
   }
 
 std::u16string TextCodec::toUtf16(const std::string &s) {
-  return toUtf16(s.c_str());
+  return toUtf16(s.data(),s.size());
   }
 
-std::u16string TextCodec::toUtf16(const char *inS) {
-  const uint8_t* s  = reinterpret_cast<const uint8_t*>(inS);
-  size_t         sz = 0;
-
-  for(size_t i=0;s[i];) {
-    uint32_t cp = 0;
-    size_t   l  = Detail::utf8ToCodepoint(&s[i],cp);
-
-    if(cp > 0xFFFF)
-      sz+=2; else
-      sz+=1;
+std::u16string TextCodec::toUtf16(const char *s) {
+  return toUtf16(s,std::strlen(s));
+  }
 
-    i+=l;
-    }
+std::u16string TextCodec::toUtf16(const char* s, size_t len) {
+  std::u16string u(len,u'\0');
+  auto r = toUtf16(s,len,&u[0]);
+  u.resize(r.length);
+  return u;
+  }
 
-  std::u16string u(sz,'?');
-  size_t l = 0;
-  for(size_t i=0;i<sz;) {
-    uint32_t cp = 0;
-    l += Detail::utf8ToCodepoint(&s[l],cp);
+TextCodec::Result TextCodec::toUtf16(const char* s, size_t len, char16_t* dst) {
+  return utf8ToUtf16<true>(reinterpret_cast<const uint8_t*>(s),len,dst);
+  }
 
-    if(cp > 0xFFFF) {
-      cp  -= 0x10000;
-      u[i] = 0xD800 + ((cp >> 10) & 0x3FF);
-      cp   = 0xDC00 + (cp & 0x3FF);
-      ++i;
-      }
-    u[i] = char16_t(cp);
-    ++i;
-    }
+bool TextCodec::validate(const char* s, size_t len, size_t* errorPos) {
+  auto r = utf8ToUtf16<false>(reinterpret_cast<const uint8_t*>(s),len,nullptr);
+  if(errorPos!=nullptr)
+    *errorPos = r.firstError;
+  return r.errors==0;
+  }
 
-  return u;
+bool TextCodec::validate(const char16_t* s, size_t len, size_t* errorPos) {
+  auto r = utf16ToUtf8<false>(s,len,nullptr);
+  if(errorPos!=nullptr)
+    *errorPos = r.firstError;
+  return r.errors==0;
   }
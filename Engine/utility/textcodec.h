@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <cstddef>
+#include <cstdint>
 
 namespace Tempest {
 
@@ -8,14 +10,30 @@ class TextCodec final {
   public:
     TextCodec()=delete;
 
+    static const size_t npos = size_t(-1);
+
+    struct Result {
+      size_t length     = 0;    // code units written to dst
+      size_t errors     = 0;    // malformed sequences, each replaced by '?'
+      size_t firstError = npos; // source offset of first malformed sequence
+      };
+
     static std::string    toUtf8 (const std::u16string& s);
     static std::string    toUtf8 (const char16_t* s);
+    static std::string    toUtf8 (const char16_t* s, size_t len);
+    // dst must have room for 3*len bytes; no terminating zero is written
+    static Result         toUtf8 (const char16_t* s, size_t len, char* dst);
 
     static void           toUtf8 (const uint32_t codePoint, char (&ret)[3]);
 
     static std::u16string toUtf16(const std::string& s);
     static std::u16string toUtf16(const char* s);
+    static std::u16string toUtf16(const char* s, size_t len);
+    // dst must have room for len code units; no terminating zero is written
+    static Result         toUtf16(const char* s, size_t len, char16_t* dst);
+
+    static bool           validate(const char*     s, size_t len, size_t* errorPos=nullptr);
+    static bool           validate(const char16_t* s, size_t len, size_t* errorPos=nullptr);
   };
 
 }
-
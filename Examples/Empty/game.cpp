@@ -91,6 +91,7 @@ void Game::render(){
 
     {
     auto enc = cmd.startEncoding(device);
+    dispatchLayers(device,swapchain,enc);
     enc.setFramebuffer(fbo[imgId],pass);
     surface.draw(device,swapchain,enc);
     }
@@ -91,3 +91,75 @@ TEST(main, DeviceAllocatorAlign1) {
   memory.free(p1);
   memory.free(p3);
   }
+
+TEST(main, DeviceAllocatorStats) {
+  using Alloc = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Alloc      memory(device);
+
+  auto p1 = memory.alloc(64, 1,0,0);
+  auto p2 = memory.alloc(128,1,0,0);
+  auto p3 = memory.alloc(32, 1,0,0);
+  auto d0 = memory.dedicatedAlloc(256,1,2,1);
+
+  std::vector<Alloc::Stats> st;
+  memory.stats(st);
+  ASSERT_EQ(st.size(),3u);
+  EXPECT_EQ(st[0].used,       224u);
+  EXPECT_EQ(st[0].reserved,   uint64_t(Alloc::DEFAULT_PAGE_SIZE));
+  EXPECT_EQ(st[0].largestFree,uint64_t(Alloc::DEFAULT_PAGE_SIZE-224));
+  EXPECT_EQ(st[0].pages,      1u);
+  EXPECT_EQ(st[0].dedicated,  0u);
+  EXPECT_EQ(st[0].allocations,3u);
+  EXPECT_EQ(st[1].pages,      0u);
+  EXPECT_EQ(st[2].used,       256u);
+  EXPECT_EQ(st[2].reserved,   256u);
+  EXPECT_EQ(st[2].largestFree,0u);
+  EXPECT_EQ(st[2].dedicated,  1u);
+
+  memory.free(p2);
+  memory.free(d0);
+  st.clear();
+  memory.stats(st);
+  EXPECT_EQ(st[0].used,       96u);
+  ASSERT_EQ(st.size(),1u);
+  EXPECT_EQ(st[0].allocations,2u);
+
+  memory.free(p1);
+  memory.free(p3);
+  st.clear();
+  memory.stats(st);
+  EXPECT_EQ(st.size(),0u);
+  }
+
+TEST(main, DeviceAllocatorSparsePages) {
+  using Alloc = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Alloc      memory(device);
+
+  const size_t half = Alloc::DEFAULT_PAGE_SIZE/2;
+  auto p0 = memory.alloc(half+64,1,0,0);
+  auto p1 = memory.alloc(half+64,1,0,0); // second page
+  auto s0 = memory.alloc(128,    1,0,0);
+  ASSERT_NE(p0.page,p1.page);
+
+  memory.free(p1);
+  // now: page0 is half full, page1 is almost empty
+  std::vector<Alloc::PageRef> sparse;
+  memory.sparsePages(sparse,0.25f);
+  ASSERT_EQ(sparse.size(),1u);
+  EXPECT_EQ(sparse[0],s0.page);
+  EXPECT_NE(s0.page,p0.page);
+
+  auto m = memory.allocExcept(128,1,0,sparse[0]);
+  EXPECT_EQ(m.page,p0.page);
+  EXPECT_EQ(memory.allocExcept(128,1,1,nullptr).page,nullptr);
+  memory.free(s0);
+
+  sparse.clear();
+  memory.sparsePages(sparse,0.25f);
+  EXPECT_TRUE(sparse.empty());
+
+  memory.free(m);
+  memory.free(p0);
+  }
@@ -0,0 +1,60 @@
+#include "../assets/assetpack.h"
+
+#include <Tempest/File>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <cstring>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+TEST(main,AssetPack) {
+  const char                 spv[] = "\x03\x02\x23\x07 shader";
+  const std::vector<uint8_t> text(4096,'a');
+
+  {
+  AssetPack::Writer w(64);
+  w.add("shader/a.sprv",spv,sizeof(spv),AssetPack::Shader,AssetPack::None);
+  w.add("text.txt",text.data(),text.size(),AssetPack::Unknown,AssetPack::Zlib);
+  w.add("empty",nullptr,0,AssetPack::Unknown,AssetPack::Zlib);
+  WFile f("AssetPack.pak");
+  w.save(f);
+  }
+
+  AssetPack pack("AssetPack.pak");
+  EXPECT_EQ(pack.size(),3u);
+  EXPECT_EQ(pack.find("missing"),nullptr);
+
+  auto sh = pack.find("shader/a.sprv");
+  ASSERT_NE(sh,nullptr);
+  EXPECT_EQ(sh->type,AssetPack::Shader);
+  EXPECT_EQ(pack.name(*sh),"shader/a.sprv");
+  ASSERT_NE(pack.data(*sh),nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(pack.data(*sh))%64,0u);
+  EXPECT_EQ(std::memcmp(pack.data(*sh),spv,sizeof(spv)),0);
+
+  auto tx = pack.find("text.txt");
+  ASSERT_NE(tx,nullptr);
+  EXPECT_EQ(tx->compression,AssetPack::Zlib);
+  EXPECT_LT(tx->size,tx->rawSize);
+  EXPECT_EQ(pack.data(*tx),nullptr);
+
+  std::vector<uint8_t> buf;
+  pack.read(*tx,buf);
+  EXPECT_EQ(buf,text);
+
+  auto em = pack.find("empty");
+  ASSERT_NE(em,nullptr);
+  pack.read(*em,buf);
+  EXPECT_TRUE(buf.empty());
+  }
+
+TEST(main,AssetPackDetectType) {
+  EXPECT_EQ(AssetPack::detectType("a.png",reinterpret_cast<const uint8_t*>("\x89PNG"),4),AssetPack::Image);
+  EXPECT_EQ(AssetPack::detectType("a.bin",reinterpret_cast<const uint8_t*>("OTTO"),4),AssetPack::Font);
+  EXPECT_EQ(AssetPack::detectType("A.TGA",reinterpret_cast<const uint8_t*>("\0\0\2\0"),4),AssetPack::Image);
+  EXPECT_EQ(AssetPack::detectType("a.txt",reinterpret_cast<const uint8_t*>("text"),4),AssetPack::Unknown);
+  }
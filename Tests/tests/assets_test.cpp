@@ -0,0 +1,233 @@
+#include <Tempest/VulkanApi>
+#include <Tempest/Device>
+#include <Tempest/Assets>
+#include <Tempest/Pixmap>
+#include <Tempest/Platform>
+#include <Tempest/Log>
+#include <Tempest/Except>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <cstdio>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__WINDOWS__)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace testing;
+using namespace Tempest;
+
+// Assets resolve path relative to executable
+static std::string exeDir() {
+  char buf[4096] = {};
+#if defined(__WINDOWS__)
+  DWORD len = GetModuleFileNameA(nullptr,buf,sizeof(buf));
+#else
+  ssize_t len = ::readlink("/proc/self/exe",buf,sizeof(buf)-1);
+#endif
+  std::string ret(buf,len>0 ? size_t(len) : 0);
+  auto slash = ret.find_last_of("/\\");
+  return slash==std::string::npos ? std::string() : ret.substr(0,slash+1);
+  }
+
+static void writeImage(const char* name, uint32_t w, uint8_t fill) {
+  Pixmap pm(w,w,Pixmap::Format::RGBA);
+  std::memset(pm.data(),fill,pm.dataSize());
+  pm.save((exeDir()+name).c_str());
+  }
+
+TEST(main,AssetsBudgetLru) {
+  try {
+    VulkanApi api;
+    Device    device(api);
+
+    writeImage("assets_lru_a.png",64,1);
+    writeImage("assets_lru_b.png",64,2);
+    writeImage("assets_lru_c.png",64,3);
+    const size_t sz = 64*64*4;
+
+    Assets assets("",device);
+    // loaded in order a, b, c; handles dropped right away
+    assets["assets_lru_a.png"];
+    assets["assets_lru_b.png"];
+    assets["assets_lru_c.png"];
+    EXPECT_EQ(assets.stats().pixmapBytes,3*sz);
+
+    assets.setBudget(2*sz,0);
+    EXPECT_EQ(assets.stats().evictions,1u);
+    EXPECT_EQ(assets.stats().pixmapBytes,2*sz);
+
+    // 'a' is reloaded and held by handle; least recent of others is 'b'
+    Asset         ha = assets["assets_lru_a.png"];
+    const Pixmap& a  = ha.get<Pixmap>();
+    EXPECT_EQ(a.w(),64u);
+    EXPECT_EQ(assets.stats().evictions,2u);
+    EXPECT_EQ(assets.stats().pixmapBytes,2*sz);
+
+    // 'c' is still resident: no reload, no eviction
+    assets["assets_lru_c.png"].get<Pixmap>();
+    EXPECT_EQ(assets.stats().evictions,2u);
+
+    // referenced content is never evicted
+    assets.setBudget(1,0);
+    EXPECT_EQ(a.w(),64u);
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(a.data())[0],1);
+
+    // once handle is dropped, 'a' is evicted and reloaded transparently
+    ha = Asset();
+    assets.setBudget(1,0);
+    EXPECT_EQ(assets.stats().pixmapBytes,0u);
+    const uint64_t evicted = assets.stats().evictions;
+    ha = assets["assets_lru_a.png"];
+    const Pixmap&  re      = ha.get<Pixmap>();
+    EXPECT_EQ(re.w(),64u);
+    EXPECT_EQ(assets.stats().evictions,evicted);
+
+    std::remove((exeDir()+"assets_lru_a.png").c_str());
+    std::remove((exeDir()+"assets_lru_b.png").c_str());
+    std::remove((exeDir()+"assets_lru_c.png").c_str());
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+// polls, until pred is true or ~5 seconds passed
+template<class F>
+static bool waitFor(F pred) {
+  for(int i=0;i<5000;++i) {
+    if(pred())
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  return pred();
+  }
+
+struct LoadedLog {
+  std::vector<std::string> names;
+  void onLoaded(const AsyncAsset& a) { names.push_back(a.name()); }
+  };
+
+TEST(main,AssetsAsync) {
+  try {
+    VulkanApi api;
+    Device    device(api);
+
+    writeImage("assets_async.png",64,5);
+
+    Assets assets("",device);
+    LoadedLog log;
+    assets.onLoaded.bind(&log,&LoadedLog::onLoaded);
+
+    AsyncAsset a       = assets.loadAsync("assets_async.png",Assets::High);
+    AsyncAsset missing = assets.loadAsync("assets_async_missing.png");
+    ASSERT_TRUE(waitFor([&](){ return a.isReady() && missing.isFailed(); }));
+
+    const Pixmap* pm = a.tryGet<Pixmap>();
+    ASSERT_NE(pm,nullptr);
+    EXPECT_EQ(pm->w(),64u);
+    EXPECT_EQ(missing.tryGet<Pixmap>(),nullptr);
+
+    assets.dispatchLoaded();
+    EXPECT_THAT(log.names,Contains("assets_async.png"));
+
+    std::remove((exeDir()+"assets_async.png").c_str());
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+TEST(main,AssetsAsyncCancel) {
+  try {
+    VulkanApi api;
+    Device    device(api);
+
+    writeImage("assets_cancel.png",16,7);
+
+    Assets assets("",device);
+    LoadedLog log;
+    assets.onLoaded.bind(&log,&LoadedLog::onLoaded);
+
+    std::vector<AsyncAsset> h;
+    for(int i=0;i<256;++i)
+      h.push_back(assets.loadAsync("assets_cancel.png",Assets::Low));
+    for(size_t i=1;i<h.size();i+=2)
+      h[i].cancel();
+    // dropped handle cancels too
+    assets.loadAsync("assets_cancel.png",Assets::Low);
+
+    ASSERT_TRUE(waitFor([&](){
+      for(size_t i=0;i<h.size();i+=2)
+        if(!h[i].isReady())
+          return false;
+      return true;
+      }));
+
+    size_t ready = 0;
+    for(size_t i=1;i<h.size();i+=2) {
+      // either was already in progress, or never loaded
+      EXPECT_FALSE(h[i].isFailed());
+      if(h[i].isReady())
+        ready++; else
+        EXPECT_EQ(h[i].tryGet<Pixmap>(),nullptr);
+      }
+
+    assets.dispatchLoaded();
+    EXPECT_GE(log.names.size(),h.size()/2);
+    EXPECT_LE(log.names.size(),h.size()/2+ready);
+
+    h.clear();
+    std::remove((exeDir()+"assets_cancel.png").c_str());
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+#if defined(__LINUX__)
+TEST(main,AssetsHotReload) {
+  try {
+    VulkanApi api;
+    Device    device(api);
+
+    writeImage("assets_hot.png",32,1);
+
+    Assets assets("",device);
+    Asset  a = assets["assets_hot.png"];
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(a.get<Pixmap>().data())[0],1);
+
+    assets.setHotReload(true);
+    writeImage("assets_hot.png",32,9);
+
+    // live handle is updated on owner thread, once watcher has decoded new file
+    const bool reloaded = waitFor([&](){
+      assets.dispatchLoaded();
+      return reinterpret_cast<const uint8_t*>(a.get<Pixmap>().data())[0]==9;
+      });
+    EXPECT_TRUE(reloaded);
+
+    assets.setHotReload(false);
+    std::remove((exeDir()+"assets_hot.png").c_str());
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+#endif
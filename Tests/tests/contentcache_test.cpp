@@ -0,0 +1,58 @@
+#include "../graphics/contentcache.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct Immediate : Retirer {
+  void retire(void* obj, Deleter del) override { ++count; del(obj); }
+  int  count = 0;
+  };
+
+}
+
+TEST(main,ContentCacheHash) {
+  const char a[] = "0123456789abcdef-tail";
+  const char b[] = "0123456789abcdef-tajl";
+
+  EXPECT_TRUE (ContentCache::hash(a,sizeof(a))==ContentCache::hash(a,sizeof(a)));
+  EXPECT_FALSE(ContentCache::hash(a,sizeof(a))==ContentCache::hash(b,sizeof(b)));
+  EXPECT_FALSE(ContentCache::hash(a,sizeof(a))==ContentCache::hash(a,sizeof(a)-1));
+
+  // lanes are independent
+  auto d = ContentCache::hash(a,sizeof(a));
+  EXPECT_NE(d.h0,d.h1);
+  }
+
+TEST(main,ContentCacheWeak) {
+  Immediate    next;
+  ContentCache cache(next);
+  const auto   h = ContentCache::hash("spv",3);
+
+  {
+  ContentCache::PShader sh(new AbstractGraphicsApi::Shader());
+  cache.putShader(h,3,sh);
+
+  auto p = cache.findShader(h,3);
+  EXPECT_EQ(p.handler,sh.handler);
+  EXPECT_EQ(p.handler->counter.load(),2u);
+  EXPECT_EQ(cache.findShader(h,4).handler,nullptr);
+  }
+
+  // last reference is gone: entry expired, object is passed further
+  EXPECT_EQ(next.count,1);
+  EXPECT_EQ(cache.findShader(h,3).handler,nullptr);
+
+  cache.setEnabled(false);
+  {
+  ContentCache::PShader sh(new AbstractGraphicsApi::Shader());
+  cache.putShader(h,3,sh);
+  EXPECT_EQ(cache.findShader(h,3).handler,nullptr);
+  }
+  EXPECT_EQ(next.count,1);
+  }
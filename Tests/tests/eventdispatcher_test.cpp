@@ -80,3 +80,46 @@ TEST(main,EventDispatcher_MouseEvent) {
   EXPECT_EQ(b0.up,  1);
   EXPECT_EQ(b0.move,1);
   }
+
+TEST(main,EventDispatcher_HitTestIndex) {
+  Widget wx;
+  wx.resize(1000,1000);
+  wx.setHitTestIndex(true);
+
+  EventDispatcher dis(wx);
+
+  std::vector<TstButton*> btn;
+  for(int i=0;i<100;++i) {
+    TstButton& b = wx.addWidget(new TstButton());
+    b.setGeometry((i%10)*100,(i/10)*100,50,50);
+    btn.push_back(&b);
+    }
+  // overlaps btn[11], and is on top of it
+  TstButton& top = wx.addWidget(new TstButton());
+  top.setGeometry(110,110,100,100);
+
+  auto evt0 = mkMEvent(Event::MouseDown,120,120);
+  dis.dispatchMouseDown(wx,evt0);
+  auto evt1 = mkMEvent(Event::MouseUp,120,120);
+  dis.dispatchMouseUp(wx,evt1);
+  EXPECT_EQ(top.down,    1);
+  EXPECT_EQ(btn[11]->down,0);
+
+  top.setVisible(false);
+  dis.dispatchMouseDown(wx,evt0);
+  dis.dispatchMouseUp(wx,evt1);
+  EXPECT_EQ(top.down,    1);
+  EXPECT_EQ(btn[11]->down,1);
+
+  btn[11]->setPosition(760,760);
+  dis.dispatchMouseDown(wx,evt0);
+  dis.dispatchMouseUp(wx,evt1);
+  EXPECT_EQ(btn[11]->down,1);
+
+  auto evt2 = mkMEvent(Event::MouseDown,770,770);
+  dis.dispatchMouseDown(wx,evt2);
+  auto evt3 = mkMEvent(Event::MouseUp,770,770);
+  dis.dispatchMouseUp(wx,evt3);
+  EXPECT_EQ(btn[11]->down,2);
+  EXPECT_EQ(btn[77]->down,0);
+  }
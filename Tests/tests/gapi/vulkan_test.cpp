@@ -8,6 +8,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <cstring>
+
 #include "gapi_test_common.h"
 
 using namespace testing;
@@ -74,3 +76,189 @@ TEST(VulkanApi,MipMaps) {
       throw;
     }
   }
+
+TEST(VulkanApi,GpuTimers) {
+  using namespace Tempest;
+
+  try {
+    VulkanApi   api{ApiFlags::Validation};
+    Device      device(api);
+
+    device.setGpuProfiling(true);
+    if(!device.hasGpuProfiling()) {
+      Log::d("Skipping graphics testcase: no timestamp queries");
+      return;
+      }
+
+    auto tex  = device.attachment(TextureFormat::RGBA8,128,128,true);
+    auto fbo  = device.frameBuffer(tex);
+    auto rp   = device.pass(FboMode(FboMode::PreserveOut,Color(0.f,0.f,1.f)));
+    auto sync = device.fence();
+
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.beginTimer("frame");
+      enc.beginTimer("clear");
+      enc.setFramebuffer(fbo,rp);
+      enc.endTimer();
+      enc.setFramebuffer(nullptr);
+      enc.beginTimer("mips");
+      enc.generateMipmaps(tex);
+      enc.endTimer();
+      enc.endTimer();
+    }
+    device.submit(cmd,sync);
+    sync.wait();
+    device.waitIdle();
+
+    GpuFrameReport r;
+    ASSERT_TRUE(device.gpuReport(r));
+    ASSERT_EQ(r.scopes.size(),3u);
+    EXPECT_STREQ(r.scopes[0].name,"frame");
+    EXPECT_EQ(r.scopes[0].depth,0u);
+    EXPECT_EQ(r.scopes[1].depth,1u);
+    EXPECT_EQ(r.dropped,0u);
+    for(auto& i:r.scopes)
+      EXPECT_LE(i.start+i.time,r.gpuTime+1e-6);
+    EXPECT_FALSE(device.gpuReport(r));
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+TEST(VulkanApi,MemoryStats) {
+  using namespace Tempest;
+
+  try {
+    VulkanApi api{ApiFlags::Validation};
+    Device    device(api);
+
+    std::vector<float> data(1024*1024);
+    auto ssbo = device.ssbo(data);
+
+    MemoryStats st = device.memoryStats();
+    ASSERT_FALSE(st.heaps.empty());
+    ASSERT_FALSE(st.types.empty());
+
+    uint64_t used = 0, reserved = 0;
+    for(auto& h:st.heaps) {
+      EXPECT_LE(h.used,h.reserved);
+      EXPECT_GT(h.budget,0u);
+      used     += h.used;
+      reserved += h.reserved;
+      }
+    EXPECT_GE(used,data.size()*sizeof(float));
+    EXPECT_GE(reserved,used);
+
+    uint64_t typeUsed = 0;
+    for(auto& t:st.types) {
+      EXPECT_LT(t.heap,st.heaps.size());
+      typeUsed += t.used;
+      }
+    EXPECT_EQ(typeUsed,used);
+
+    size_t calls = 0;
+    device.setMemoryBudgetCallback(0.f,[&calls](const MemoryStats&, uint32_t, bool over){
+      EXPECT_TRUE(over);
+      ++calls;
+      });
+    device.waitIdle();
+    EXPECT_GT(calls,0u);
+    const size_t calls0 = calls;
+    device.waitIdle();
+    EXPECT_EQ(calls,calls0);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+TEST(VulkanApi,Defragment) {
+  using namespace Tempest;
+
+  try {
+    VulkanApi api{ApiFlags::Validation};
+    Device    device(api);
+
+    auto cs  = device.loadShader("shader/simple_test.comp.sprv");
+    auto pso = device.pipeline(cs);
+
+    Pixmap pm(64,64,Pixmap::Format::RGBA);
+    std::memset(pm.data(),7,pm.dataSize());
+    auto tex = device.loadTexture(pm,false);
+
+    // 48Mb each: two per 128Mb page, so a, b end up in first page and c, d in second
+    const size_t          count = 48*1024*1024/sizeof(Vec4);
+    std::vector<Vec4>     data(count);
+    std::vector<StorageBuffer<Vec4>> buf;
+    for(int k=0;k<4;++k) {
+      for(size_t i=0;i<count;++i)
+        data[i] = Vec4(float(k),float(i%1024),0,0);
+      buf.push_back(device.ssbo(data));
+      }
+
+    // 'a' and 'd' stay: each page is used below 50% and fits into other one
+    StorageBuffer<Vec4> live[2] = {std::move(buf[0]),std::move(buf[3])};
+    buf.clear();
+
+    StorageBuffer<Vec4> out[2];
+    Uniforms            ubo[2];
+    for(int k=0;k<2;++k) {
+      out[k] = device.ssbo<Vec4>(nullptr,3);
+      ubo[k] = device.uniforms(pso.layout());
+      ubo[k].set(0,live[k]);
+      ubo[k].set(1,out[k]);
+      }
+    device.waitIdle();
+
+    size_t moved = 0;
+    for(int i=0;i<16;++i) {
+      const size_t sz = device.defragment(64*1024*1024);
+      if(sz==0)
+        break;
+      moved += sz;
+      }
+    EXPECT_GT(moved,0u);
+
+    // descriptor sets, written before defragment, must point to new location
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      for(int k=0;k<2;++k) {
+        enc.setUniforms(pso,ubo[k]);
+        enc.dispatch(3,1,1);
+        }
+    }
+    auto sync = device.fence();
+    device.submit(cmd,sync);
+    sync.wait();
+
+    const float id[2] = {0,3};
+    for(int k=0;k<2;++k) {
+      Vec4 result[3] = {};
+      device.readBytes(out[k],result,3);
+      for(size_t i=0;i<3;++i)
+        EXPECT_EQ(result[i],Vec4(id[k],float(i),0,0));
+
+      device.readBytes(live[k],data.data(),count);
+      for(size_t i=0;i<count;++i)
+        ASSERT_EQ(data[i],Vec4(id[k],float(i%1024),0,0));
+      }
+
+    Pixmap px = device.readPixels(tex);
+    auto   p  = reinterpret_cast<const uint8_t*>(px.data());
+    for(size_t r=0;r<px.dataSize();++r)
+      ASSERT_EQ(p[r],7);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
@@ -1,11 +1,16 @@
 #include <Tempest/File>
 #include <Tempest/MemWriter>
 #include <Tempest/MemReader>
+#include <Tempest/BufferedReader>
+#include <Tempest/AsyncReader>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <system_error>
 
 using namespace testing;
 using namespace Tempest;
@@ -86,3 +91,97 @@ TEST(main,FileUnget) {
   RFile fin("FileUnget.bin");
   UngetCommon(fin);
   }
+
+TEST(main,MappedFileUnget) {
+  {
+  WFile fout("MappedFileUnget.bin");
+  EXPECT_EQ(fout.write(bytes,sizeof(bytes)),sizeof(bytes));
+  }
+
+  MappedFile fin("MappedFileUnget.bin");
+  EXPECT_EQ(fin.size(),sizeof(bytes));
+  EXPECT_EQ(std::memcmp(fin.data(),bytes,sizeof(bytes)),0);
+  UngetCommon(fin);
+  }
+
+TEST(main,MappedFileEmpty) {
+  {
+  WFile fout("MappedFileEmpty.bin");
+  }
+
+  MappedFile fin("MappedFileEmpty.bin");
+  uint8_t buf[4]={};
+  EXPECT_EQ(fin.size(),0u);
+  EXPECT_EQ(fin.read(buf,sizeof(buf)),0u);
+  EXPECT_EQ(fin.peek(),0);
+  }
+
+TEST(main,BufferedUnget) {
+  MemReader      src(bytes,sizeof(bytes));
+  BufferedReader fin(src);
+  UngetCommon(fin);
+  }
+
+TEST(main,BufferedReadAhead) {
+  std::vector<uint8_t> tmp(1024);
+  for(size_t i=0;i<tmp.size();++i)
+    tmp[i] = uint8_t(i);
+
+  MemReader src(tmp);
+  {
+  BufferedReader fin(src,256);
+  uint8_t buf[300]={};
+  EXPECT_EQ(fin.peek(),0);
+  EXPECT_EQ(fin.read(buf,8),8u);
+  EXPECT_EQ(fin.unget(8),8u);
+  EXPECT_EQ(fin.read(buf,sizeof(buf)),sizeof(buf));
+  EXPECT_EQ(buf[299],uint8_t(299));
+  EXPECT_EQ(fin.seek(100),100u);
+  EXPECT_EQ(fin.peek(),uint8_t(400));
+  EXPECT_EQ(fin.unget(350),350u);
+  EXPECT_EQ(fin.peek(),uint8_t(50));
+  EXPECT_EQ(fin.read(buf,4),4u);
+  }
+  // unconsumed read-ahead is returned to the source
+  EXPECT_EQ(src.cursorPosition(),54u);
+  }
+
+TEST(main,AsyncRead) {
+  std::vector<uint8_t> data(256*1024);
+  for(size_t i=0;i<data.size();++i)
+    data[i] = uint8_t(i*7+i/256);
+  {
+  WFile fout("AsyncRead.bin");
+  EXPECT_EQ(fout.write(data.data(),data.size()),data.size());
+  }
+
+  AsyncReader rd(8);
+  auto f = rd.open("AsyncRead.bin");
+  EXPECT_EQ(rd.size(f),data.size());
+
+  const size_t chunk = 4096;
+  const size_t count = data.size()/chunk;
+  std::vector<uint8_t> dst(data.size()+chunk);
+  for(size_t i=0;i<count;++i)
+    rd.submit(f,i*chunk,chunk,dst.data()+i*chunk,i);
+  // crosses end of file
+  rd.submit(f,data.size()-100,chunk,dst.data()+data.size(),count);
+
+  std::vector<bool> seen(count+1);
+  AsyncReader::Completion c[16];
+  while(rd.inFlight()>0) {
+    size_t n = rd.wait(c,16);
+    for(size_t i=0;i<n;++i) {
+      EXPECT_TRUE(c[i].ok);
+      EXPECT_EQ(c[i].size,c[i].tag==count ? 100u : chunk);
+      seen[size_t(c[i].tag)] = true;
+      }
+    }
+  EXPECT_EQ(rd.wait(c,16),0u);
+  EXPECT_EQ(std::count(seen.begin(),seen.end(),true),ptrdiff_t(count+1));
+  EXPECT_EQ(std::memcmp(dst.data(),data.data(),data.size()),0);
+  EXPECT_EQ(std::memcmp(dst.data()+data.size(),data.data()+data.size()-100,100),0);
+  rd.close(f);
+  EXPECT_THROW(rd.submit(f,0,chunk,dst.data(),0),std::system_error);
+  std::remove("AsyncRead.bin");
+  }
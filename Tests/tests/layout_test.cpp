@@ -31,6 +31,26 @@ TEST(main,LinearLayoutMaxSize) {
   EXPECT_EQ(b1.h(),50);
   }
 
+TEST(main,LinearLayoutInvalidate) {
+  Widget w;
+  w.resize(1000,1000);
+  w.setLayout(Vertical);
+
+  Widget& b0=w.addWidget(new Widget());
+  Widget& b1=w.addWidget(new Widget());
+  b1.setMinimumSize(50,50);
+  b1.setSizePolicy(Fixed);
+  EXPECT_EQ(b1.h(),50);
+
+  b1.setMinimumSize(80,80);
+  EXPECT_EQ(b1.h(),80);
+  EXPECT_EQ(w.h(),b0.h()+b1.h()+w.spacing());
+
+  w.resize(1000,500);
+  EXPECT_EQ(b1.h(),80);
+  EXPECT_EQ(w.h(),b0.h()+b1.h()+w.spacing());
+  }
+
 TEST(main,LinearLayoutVisibility) {
   Widget w;
   w.resize(300,300);
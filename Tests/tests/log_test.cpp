@@ -0,0 +1,90 @@
+#include <Tempest/Log>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace Tempest;
+
+TEST(main,LogFile) {
+  const char* path = "log_test.txt";
+  std::remove(path);
+  ASSERT_TRUE(Log::setFile(path,false));
+
+  const int      thCount = 4;
+  const int      msgCount = 2000;
+  const uint64_t lost0   = Log::dropped();
+
+  std::vector<std::thread> th;
+  for(int i=0;i<thCount;++i)
+    th.emplace_back([i](){
+      for(int r=0;r<msgCount;++r)
+        Log::i("th=",i," msg=",r," f=",0.5f," s=",std::string("str"));
+      });
+  for(auto& i:th)
+    i.join();
+  Log::d("single ",'c',' ',int64_t(-7),' ',uint8_t(200));
+  Log::flush();
+  ASSERT_TRUE(Log::setFile(nullptr));
+
+  std::ifstream in(path);
+  std::string   line, last;
+  size_t        lines = 0;
+  while(std::getline(in,line)) {
+    if(line.compare(0,4,"Log:")==0)
+      continue;
+    ++lines;
+    last = line;
+    }
+  const uint64_t lost = Log::dropped()-lost0;
+
+  EXPECT_EQ(lines+lost,size_t(thCount*msgCount+1));
+  EXPECT_EQ(last,"single c -7 200");
+  std::remove(path);
+  }
+
+TEST(main,LogFormat) {
+  const char* path = "log_format_test.txt";
+  std::remove(path);
+  ASSERT_TRUE(Log::setFile(path,false));
+
+  Log::e("int=",int32_t(-42)," uint=",uint64_t(18446744073709551615ull)," float=",1.25," ptr=",reinterpret_cast<void*>(0x10));
+  Log::i("");
+  Log::flush();
+  ASSERT_TRUE(Log::setFile(nullptr));
+
+  std::ifstream in(path);
+  std::string   line;
+  ASSERT_TRUE(bool(std::getline(in,line)));
+  std::string ptr = "0x"+std::string(sizeof(void*)*2-2,'0')+"10";
+  EXPECT_EQ(line,"int=-42 uint=18446744073709551615 float=1.250000 ptr="+ptr);
+  EXPECT_FALSE(bool(std::getline(in,line)));
+  std::remove(path);
+  }
+
+TEST(main,LogErrorSync) {
+  const char* path = "log_error_test.txt";
+  std::remove(path);
+  ASSERT_TRUE(Log::setFile(path,false));
+  Log::setFlushOnError(true);
+
+  Log::i("info");
+  Log::e("error");
+  Log::setFlushOnError(false);
+  // no flush: error is written before Log::e returns, along with everything before it
+  std::ifstream in(path);
+  std::string   line;
+  ASSERT_TRUE(bool(std::getline(in,line)));
+  EXPECT_EQ(line,"info");
+  ASSERT_TRUE(bool(std::getline(in,line)));
+  EXPECT_EQ(line,"error");
+  in.close();
+
+  ASSERT_TRUE(Log::setFile(nullptr));
+  std::remove(path);
+  }
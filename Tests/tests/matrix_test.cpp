@@ -0,0 +1,196 @@
+#include <Tempest/Matrix4x4>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace testing;
+using namespace Tempest;
+
+namespace {
+
+// scalar reference, same as previous Matrix4x4 implementation
+void refMul(float r[4][4], const float a[4][4], const float b[4][4]) {
+  for(int i=0;i<4;++i)
+    for(int j=0;j<4;++j)
+      r[i][j] = a[0][j]*b[i][0]+a[1][j]*b[i][1]+a[2][j]*b[i][2]+a[3][j]*b[i][3];
+  }
+
+void refProject(const float m[4][4], const Vec3& v, Vec4& out) {
+  out.x = m[0][0]*v.x + m[1][0]*v.y + m[2][0]*v.z + m[3][0];
+  out.y = m[0][1]*v.x + m[1][1]*v.y + m[2][1]*v.z + m[3][1];
+  out.z = m[0][2]*v.x + m[1][2]*v.y + m[2][2]*v.z + m[3][2];
+  out.w = m[0][3]*v.x + m[1][3]*v.y + m[2][3]*v.z + m[3][3];
+  }
+
+const float (&rows(const Matrix4x4& m))[4][4] {
+  return *reinterpret_cast<const float(*)[4][4]>(m.data());
+  }
+
+Matrix4x4 sample() {
+  Matrix4x4 m;
+  m.identity();
+  m.translate(1.f,-2.f,3.f);
+  m.rotate(30.f,0.3f,1.f,0.2f);
+  m.scale(2.f,0.5f,1.5f);
+  return m;
+  }
+
+Matrix4x4 viewProj() {
+  Matrix4x4 p;
+  p.perspective(90.f,1.f,0.1f,100.f);
+  Matrix4x4 v;
+  v.identity();
+  v.translate(0.f,0.f,5.f);
+  p.mul(v);
+  return p;
+  }
+
+void expectNear(const Matrix4x4& a, const Matrix4x4& b, float eps) {
+  for(int i=0;i<4;++i)
+    for(int j=0;j<4;++j)
+      EXPECT_NEAR(a.at(i,j),b.at(i,j),eps) << i << "," << j;
+  }
+
+}
+
+TEST(main,MatrixMul) {
+  Matrix4x4 a = sample();
+  Matrix4x4 b = viewProj();
+
+  float ref[4][4];
+  refMul(ref,rows(a),rows(b));
+
+  expectNear(a*b,Matrix4x4(&ref[0][0]),1e-5f);
+  a.mul(b);
+  expectNear(a,Matrix4x4(&ref[0][0]),1e-5f);
+  }
+
+TEST(main,MatrixInverse) {
+  for(auto m:{sample(),viewProj()}) {
+    Matrix4x4 inv = m;
+    inv.inverse();
+
+    Matrix4x4 id;
+    id.identity();
+    expectNear(m*inv,id,1e-4f);
+    expectNear(inv*m,id,1e-4f);
+    }
+  }
+
+TEST(main,MatrixTranspose) {
+  Matrix4x4 m = sample();
+  Matrix4x4 t = m;
+  t.transpose();
+  for(int i=0;i<4;++i)
+    for(int j=0;j<4;++j)
+      EXPECT_EQ(m.at(i,j),t.at(j,i));
+  }
+
+TEST(main,MatrixProjectMany) {
+  const Matrix4x4 m = viewProj();
+
+  std::vector<Vec3> in(37);
+  for(size_t i=0;i<in.size();++i)
+    in[i] = Vec3(float(i)*0.5f,-float(i),float(i%7));
+
+  std::vector<Vec4> out(in.size());
+  m.projectMany(in.data(),out.data(),in.size());
+
+  std::vector<Vec4> out4(in.size());
+  for(size_t i=0;i<in.size();++i)
+    out4[i] = Vec4(in[i].x,in[i].y,in[i].z,1.f);
+  m.projectMany(out4.data(),out4.data(),out4.size());
+
+  for(size_t i=0;i<in.size();++i) {
+    Vec4 r(in[i].x,in[i].y,in[i].z,1.f);
+    m.project(r);
+    EXPECT_EQ(out[i],r);
+    EXPECT_EQ(out4[i],r);
+    }
+  }
+
+TEST(main,MatrixAabb) {
+  const Matrix4x4 m = sample();
+  const Vec3      a(-1.f,-2.f,0.5f), b(3.f,1.f,2.f);
+
+  Vec3 lo, hi;
+  m.transformAabb(a,b,lo,hi);
+
+  Vec3 clo( 1e9f, 1e9f, 1e9f), chi(-1e9f,-1e9f,-1e9f);
+  for(int i=0;i<8;++i) {
+    Vec3 p((i&1) ? b.x : a.x, (i&2) ? b.y : a.y, (i&4) ? b.z : a.z);
+    m.project(p);
+    clo = Vec3(std::min(clo.x,p.x),std::min(clo.y,p.y),std::min(clo.z,p.z));
+    chi = Vec3(std::max(chi.x,p.x),std::max(chi.y,p.y),std::max(chi.z,p.z));
+    }
+  EXPECT_NEAR(lo.x,clo.x,1e-4f);
+  EXPECT_NEAR(lo.y,clo.y,1e-4f);
+  EXPECT_NEAR(lo.z,clo.z,1e-4f);
+  EXPECT_NEAR(hi.x,chi.x,1e-4f);
+  EXPECT_NEAR(hi.y,chi.y,1e-4f);
+  EXPECT_NEAR(hi.z,chi.z,1e-4f);
+  }
+
+TEST(main,MatrixFrustum) {
+  Vec4 pl[6];
+  viewProj().frustumPlanes(pl);
+
+  auto inside = [&](const Vec3& p) {
+    for(auto& i:pl)
+      if(i.x*p.x+i.y*p.y+i.z*p.z+i.w<0.f)
+        return false;
+    return true;
+    };
+
+  // camera looks along +z from z=-5
+  EXPECT_TRUE (inside(Vec3(0.f,0.f,0.f)));
+  EXPECT_TRUE (inside(Vec3(1.f,-1.f,10.f)));
+  EXPECT_FALSE(inside(Vec3(0.f,0.f,-6.f)));
+  EXPECT_FALSE(inside(Vec3(0.f,0.f,200.f)));
+  EXPECT_FALSE(inside(Vec3(20.f,0.f,0.f)));
+  EXPECT_FALSE(inside(Vec3(0.f,-20.f,0.f)));
+  }
+
+TEST(main,MatrixBench) {
+  using clock = std::chrono::steady_clock;
+  auto ms = [](clock::duration d) {
+    return std::chrono::duration<double,std::milli>(d).count();
+    };
+
+  const Matrix4x4   m = viewProj();
+  const size_t      n = 1<<18;
+  std::vector<Vec3> in(n);
+  std::vector<Vec4> out(n);
+  for(size_t i=0;i<n;++i)
+    in[i] = Vec3(float(i%113),float(i%71),float(i%31));
+
+  auto t0 = clock::now();
+  for(size_t i=0;i<n;++i)
+    refProject(rows(m),in[i],out[i]);
+  auto t1 = clock::now();
+  m.projectMany(in.data(),out.data(),n);
+  auto t2 = clock::now();
+
+  std::vector<Matrix4x4> mat(n/16,sample()), res(mat.size());
+  auto t3 = clock::now();
+  for(size_t i=0;i<mat.size();++i) {
+    float r[4][4];
+    refMul(r,rows(mat[i]),rows(m));
+    res[i].setData(&r[0][0]);
+    }
+  auto t4 = clock::now();
+  for(size_t i=0;i<mat.size();++i)
+    res[i] = mat[i]*m;
+  auto t5 = clock::now();
+
+  std::printf("[          ] project %zu: scalar %.2fms, batch %.2fms\n",n,ms(t1-t0),ms(t2-t1));
+  std::printf("[          ] mul     %zu: scalar %.2fms, simd  %.2fms\n",mat.size(),ms(t4-t3),ms(t5-t4));
+
+  Vec4 r(in[n-1].x,in[n-1].y,in[n-1].z,1.f);
+  m.project(r);
+  EXPECT_EQ(out[n-1],r);
+  expectNear(res.back(),sample()*m,1e-5f);
+  }
@@ -5,6 +5,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <cstring>
+
 using namespace testing;
 using namespace Tempest;
 
@@ -40,6 +42,19 @@ TEST(main,PixmapIO_SymetricIO) {
     }
   }
 
+TEST(main,PixmapCorruptPng) {
+  Pixmap pm("data/img/tst.png");
+  std::vector<uint8_t> mem;
+  MemWriter wr(mem);
+  pm.save(wr,"png");
+
+  // valid signature and header, garbage in image data
+  for(size_t i=64;i<mem.size();++i)
+    mem[i] = uint8_t(i*31);
+  MemReader rd(mem);
+  EXPECT_THROW(Pixmap{rd},std::system_error);
+  }
+
 TEST(main,PixmapConv) {
   Pixmap pm("data/img/tst-dxt5.dds");
   EXPECT_EQ(pm.w(),     512);
@@ -54,3 +69,48 @@ TEST(main,PixmapConv) {
   EXPECT_EQ(px1.format(),Pixmap::Format::RGBA16);
   px1.save("tst-dxt5.png");
   }
+
+TEST(main,PixmapLoadMany) {
+  auto pm = Pixmap::loadMany({"data/img/tst.png","data/img/1.jpg","data/img/tst.png"});
+  ASSERT_EQ(pm.size(),3u);
+  EXPECT_EQ(pm[0].w(),     256);
+  EXPECT_EQ(pm[0].format(),Pixmap::Format::RGBA);
+  EXPECT_EQ(pm[1].w(),     852);
+  EXPECT_EQ(pm[1].format(),Pixmap::Format::RGB);
+  EXPECT_EQ(std::memcmp(pm[0].data(),pm[2].data(),pm[0].dataSize()),0);
+
+  EXPECT_ANY_THROW(Pixmap::loadMany({"data/img/tst.png","data/img/not-exists.png"}));
+  }
+
+TEST(main,PixmapSaveOptions) {
+  Pixmap pm("data/img/tst.png");
+
+  std::vector<uint8_t> mem;
+  MemWriter wr(mem);
+  pm.save(wr,"png",Pixmap::SaveOptions::fast());
+
+  MemReader rd(mem);
+  Pixmap fast(rd);
+  ASSERT_EQ(fast.format(),pm.format());
+  EXPECT_EQ(std::memcmp(fast.data(),pm.data(),pm.dataSize()),0);
+
+  Pixmap::SaveOptions opt;
+  opt.skipAlpha = true;
+  mem.clear();
+  pm.save(wr,"png",opt);
+
+  MemReader rd2(mem);
+  Pixmap opaque(rd2);
+  EXPECT_EQ(opaque.format(),Pixmap::Format::RGB);
+  EXPECT_EQ(opaque.w(),pm.w());
+  }
+
+TEST(main,PixmapSaveAsync) {
+  Pixmap pm("data/img/tst.png");
+  auto   f = Pixmap::saveAsync(Pixmap(pm),"PixmapSaveAsync.png",nullptr,Pixmap::SaveOptions::fast());
+  f.get();
+
+  Pixmap ld("PixmapSaveAsync.png");
+  ASSERT_EQ(ld.dataSize(),pm.dataSize());
+  EXPECT_EQ(std::memcmp(ld.data(),pm.data(),pm.dataSize()),0);
+  }
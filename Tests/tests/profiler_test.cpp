@@ -0,0 +1,96 @@
+#include <Tempest/Profiler>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace Tempest;
+
+static size_t countOf(const std::string& s, const std::string& what) {
+  size_t n = 0;
+  for(size_t at=s.find(what);at!=std::string::npos;at=s.find(what,at+what.size()))
+    ++n;
+  return n;
+  }
+
+static std::string readAll(const char* path) {
+  std::ifstream     in(path);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+  }
+
+TEST(main,ProfilerTrace) {
+  static Profiler::Counter items("test.items");
+
+  const char* path = "profiler_test.json";
+  std::remove(path);
+  Profiler::setEnabled(true);
+
+  const int thCount = 4;
+  const int zones   = 100;
+  std::vector<std::thread> th;
+  for(int i=0;i<thCount;++i)
+    th.emplace_back([](){
+      Profiler::setThreadName("test \"worker\"");
+      for(int r=0;r<zones;++r) {
+        Profiler::Zone z("test.zone");
+        items.add(1);
+        }
+      });
+  for(auto& i:th)
+    i.join();
+  {
+  Profiler::Zone z("test.outer");
+  Profiler::Zone n("test.inner");
+  }
+  Profiler::counter("test.instant",42);
+  Profiler::frame();
+
+  Profiler::setEnabled(false);
+  {
+  Profiler::Zone z("test.disabled");
+  }
+  items.add(1);
+  ASSERT_TRUE(Profiler::dump(path));
+
+  const std::string json = readAll(path);
+  EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["),0u);
+  EXPECT_EQ(countOf(json,"\"name\":\"test.zone\""),size_t(thCount*zones));
+  EXPECT_EQ(countOf(json,"\"name\":\"test.outer\""),1u);
+  EXPECT_EQ(countOf(json,"\"name\":\"test.inner\""),1u);
+  EXPECT_EQ(countOf(json,"test.disabled"),0u);
+  EXPECT_EQ(countOf(json,"test \\\"worker\\\""),size_t(thCount));
+  EXPECT_NE(json.find("\"name\":\"test.instant\",\"pid\":1"),std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"value\":42}"),std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"value\":400}"),std::string::npos);
+  EXPECT_EQ(countOf(json,"\"ph\":\"i\""),1u);
+
+  // rings of finished threads are released after dump
+  ASSERT_TRUE(Profiler::dump(path));
+  EXPECT_EQ(countOf(readAll(path),"test.zone"),0u);
+  std::remove(path);
+  }
+
+TEST(main,ProfilerOverflow) {
+  const char* path = "profiler_overflow_test.json";
+  Profiler::setEnabled(true);
+  std::thread th([](){
+    for(int i=0;i<100000;++i)
+      Profiler::Zone z("overflow.zone");
+    });
+  th.join();
+  Profiler::setEnabled(false);
+  ASSERT_TRUE(Profiler::dump(path));
+
+  const size_t n = countOf(readAll(path),"overflow.zone");
+  EXPECT_GT(n,0u);
+  EXPECT_LT(n,100000u);
+  std::remove(path);
+  }
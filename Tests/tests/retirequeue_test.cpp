@@ -0,0 +1,101 @@
+#include "../graphics/retirequeue.h"
+
+#include <gtest/gtest.h>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct FakeDevice : AbstractGraphicsApi::Device {
+  const char* renderer() const override { return "fake"; }
+  void        waitIdle() override { ++idle; }
+  int         idle = 0;
+  };
+
+struct FakeFence : AbstractGraphicsApi::Fence {
+  void wait() override { signaled = true; }
+  bool wait(uint64_t) override { return signaled; }
+  void reset() override { signaled = false; }
+  bool signaled = false;
+  };
+
+struct Res : AbstractGraphicsApi::Shared {
+  explicit Res(int& cnt):cnt(cnt){}
+  ~Res() override { ++cnt; }
+  int& cnt;
+  };
+
+}
+
+TEST(main,RetireQueueFence) {
+  FakeDevice dev;
+  int        deleted = 0;
+  {
+  RetireQueue q(&dev);
+
+  {
+  DSharedPtr<Res*> r(new Res(deleted));
+  r.handler->retirer = &q;
+  }
+  // nothing submitted: still may be used by next submission
+  q.collect();
+  EXPECT_EQ(deleted,0);
+
+  auto f = new FakeFence();
+  uint64_t s = q.submit([](){});
+  q.track(s,f);
+  {
+  DSharedPtr<Res*> r(new Res(deleted));
+  r.handler->retirer = &q;
+  }
+  q.collect();
+  EXPECT_EQ(deleted,0);
+  EXPECT_EQ(q.pendingCount(),2u);
+
+  f->signaled = true;
+  q.collect();
+  EXPECT_EQ(deleted,1);
+  EXPECT_EQ(q.pendingCount(),1u);
+  EXPECT_EQ(q.takeFence(),f);
+  delete f;
+  }
+  EXPECT_EQ(deleted,2);
+  EXPECT_EQ(dev.idle,1);
+  }
+
+TEST(main,RetireQueueComplete) {
+  FakeDevice dev;
+  int        deleted = 0;
+  {
+  RetireQueue q(&dev);
+  {
+  DSharedPtr<Res*> r(new Res(deleted));
+  r.handler->retirer = &q;
+  }
+  uint64_t s0 = q.submit([](){});
+  {
+  DSharedPtr<Res*> r(new Res(deleted));
+  r.handler->retirer = &q;
+  }
+  uint64_t s1 = q.submit([](){});
+
+  q.complete(s0);
+  q.collect();
+  EXPECT_EQ(deleted,1);
+
+  q.complete(s1);
+  q.collect();
+  EXPECT_EQ(deleted,2);
+
+  q.submit([](){});
+  {
+  DSharedPtr<Res*> r(new Res(deleted));
+  r.handler->retirer = &q;
+  }
+  EXPECT_EQ(deleted,2);
+  }
+  // destructor waits for device and releases the rest
+  EXPECT_EQ(deleted,3);
+  }
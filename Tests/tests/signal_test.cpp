@@ -3,6 +3,12 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
 using namespace testing;
 using namespace Tempest;
 
@@ -88,3 +94,163 @@ TEST(main,SignalCOW1) {
   test.sig();
   EXPECT_EQ(test.log,"func0()func1()func2()");
   }
+
+struct Counter {
+  int  cnt = 0;
+  void inc()     { ++cnt; }
+  void add(int v){ cnt+=v; }
+  };
+
+TEST(main,SignalManySlots) {
+  std::vector<Counter> c(100);
+  Signal<void(int)> sig;
+  for(auto& i:c)
+    sig.bind(&i,&Counter::add);
+  for(size_t i=0;i<c.size();i+=2)
+    sig.ubind(&c[i],&Counter::add);
+  sig(3);
+
+  for(size_t i=0;i<c.size();++i)
+    EXPECT_EQ(c[i].cnt,(i%2)==0 ? 0 : 3);
+
+  Signal<void(int)> moved(std::move(sig));
+  sig(1);
+  moved(1);
+  EXPECT_EQ(c[1].cnt,4);
+  }
+
+TEST(main,SignalDeleteInSlot) {
+  // owner, that deletes itself from handler, as Timer does
+  struct Owner {
+    Signal<void()> sig;
+    int*           cnt = nullptr;
+    void die()   { ++*cnt; delete this; }
+    void after() { ++*cnt; }
+    };
+
+  int cnt = 0;
+  auto* o = new Owner();
+  o->cnt  = &cnt;
+  o->sig.bind(o,&Owner::die);
+  o->sig.bind(o,&Owner::after);
+  o->sig();
+  EXPECT_EQ(cnt,1);
+
+  struct Nested {
+    Signal<void()> sig;
+    int            depth = 0;
+    void run() {
+      if(depth++==0)
+        sig(); else
+        delete this;
+      }
+    };
+  auto* n = new Nested();
+  n->sig.bind(n,&Nested::run);
+  n->sig();
+  }
+
+TEST(main,SignalStorageCopy) {
+  Counter a, b;
+  using Slot = Detail::SgSlot<int>;
+  Detail::SgStorage<Slot,2> src;
+  src.push(Slot::make(&a,&Counter::add));
+  src.push(Slot::make(&b,&Counter::add));
+  src.push(Slot::make(&a,&Counter::add));
+  src.erase(1);
+
+  Detail::SgStorage<Slot,2> cp(src);
+  ASSERT_EQ(cp.count(),2u);
+  int v = 1;
+  for(uint32_t i=0;i<cp.count();++i)
+    cp.data()[i].call(v);
+  EXPECT_EQ(a.cnt,2);
+  EXPECT_EQ(b.cnt,0);
+  }
+
+TEST(main,AtomicSignal) {
+  Counter a, b;
+  AtomicSignal<void(int)> sig;
+  sig.bind(&a,&Counter::add);
+  sig.bind(&b,&Counter::add);
+  sig(2);
+  sig.ubind(&a,&Counter::add);
+  sig(5);
+
+  EXPECT_EQ(a.cnt,2);
+  EXPECT_EQ(b.cnt,7);
+  }
+
+TEST(main,AtomicSignalThreads) {
+  struct Acc {
+    std::atomic<int> cnt{0};
+    void inc() { cnt.fetch_add(1); }
+    };
+
+  Acc a, b;
+  AtomicSignal<void()> sig;
+  sig.bind(&a,&Acc::inc);
+
+  std::vector<std::thread> th;
+  for(int i=0;i<3;++i)
+    th.emplace_back([&](){
+      for(int r=0;r<10000;++r)
+        sig();
+      });
+  for(int i=0;i<1000;++i) {
+    sig.bind(&b,&Acc::inc);
+    sig.ubind(&b,&Acc::inc);
+    }
+  for(auto& i:th)
+    i.join();
+
+  EXPECT_EQ(a.cnt.load(),30000);
+  }
+
+TEST(main,SignalBench) {
+  using clock = std::chrono::steady_clock;
+  auto ms = [](clock::duration d) {
+    return std::chrono::duration<double,std::milli>(d).count();
+    };
+
+  for(size_t slots:{1,4,64}) {
+    std::vector<Counter> c(slots);
+    Signal<void()> sig;
+    for(auto& i:c)
+      sig.bind(&i,&Counter::inc);
+
+    const int emits = int(1000000/slots);
+    auto t0 = clock::now();
+    for(int i=0;i<emits;++i)
+      sig();
+    auto t1 = clock::now();
+    std::printf("[          ] emit %2zu slots x %7d: %.2fms\n",slots,emits,ms(t1-t0));
+    EXPECT_EQ(c[0].cnt,emits);
+    }
+
+  {
+  std::vector<Counter> c(10000);
+  Signal<void()> sig;
+  auto t0 = clock::now();
+  for(auto& i:c)
+    sig.bind(&i,&Counter::inc);
+  for(auto& i:c)
+    sig.ubind(&i,&Counter::inc);
+  auto t1 = clock::now();
+  std::printf("[          ] bind+ubind %zu slots: %.2fms\n",c.size(),ms(t1-t0));
+  sig();
+  EXPECT_EQ(c[0].cnt,0);
+  }
+
+  {
+  Counter c;
+  AtomicSignal<void()> sig;
+  sig.bind(&c,&Counter::inc);
+  auto t0 = clock::now();
+  for(int i=0;i<1000000;++i)
+    sig();
+  auto t1 = clock::now();
+  std::printf("[          ] atomic emit x 1000000: %.2fms\n",ms(t1-t0));
+  EXPECT_EQ(c.cnt,1000000);
+  }
+  }
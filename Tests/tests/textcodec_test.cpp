@@ -5,7 +5,10 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <vector>
 
 using namespace testing;
 using namespace Tempest;
@@ -58,3 +61,136 @@ TEST(main,TextCodec_UTF8_4) {
 
   TextCodec_Base(u8,u16);
   }
+
+TEST(main,TextCodec_Long) {
+#if !defined(_MSC_VER)
+  // crosses vector fast-path boundaries at different offsets
+  std::string    u8;
+  std::u16string u16;
+  for(int i=0;i<100;++i) {
+    u8  += std::string(size_t(i),'a');
+    u16 += std::u16string(size_t(i),u'a');
+    u8  +=  "ß水\U0001f34c";
+    u16 += u"ß水\U0001f34c";
+    }
+  TextCodec_Base(u8,u16);
+  EXPECT_TRUE(TextCodec::validate(u8.data(),u8.size()));
+  EXPECT_TRUE(TextCodec::validate(u16.data(),u16.size()));
+#endif
+  }
+
+TEST(main,TextCodec_Invalid) {
+  const char* cases[] = {
+    "ab\x80""cd",         // stray continuation
+    "ab\xC0\xAF""cd",     // overlong
+    "ab\xED\xA0\x80""cd", // encoded surrogate
+    "ab\xF4\x90\x80\x80", // above U+10FFFF
+    "ab\xE6\xB0",         // truncated
+    "ab\xFF""cd",
+    };
+  for(auto c:cases) {
+    size_t pos = 0;
+    EXPECT_FALSE(TextCodec::validate(c,std::strlen(c),&pos));
+    EXPECT_EQ(pos,2u);
+
+    auto u16 = TextCodec::toUtf16(c);
+    EXPECT_EQ(u16.substr(0,3),u"ab?");
+    }
+
+  const char16_t lone[] = {u'a',0xD800,u'b',0xDC00};
+  size_t pos = 0;
+  EXPECT_FALSE(TextCodec::validate(lone,4,&pos));
+  EXPECT_EQ(pos,1u);
+  EXPECT_EQ(TextCodec::toUtf8(lone,4),"a?b?");
+  }
+
+TEST(main,TextCodec_Buffer) {
+  const char     src[] = "0123456789abcdef0123456789abcdef-\xD0\x96";
+  char16_t       dst[sizeof(src)] = {};
+  auto r = TextCodec::toUtf16(src,sizeof(src)-1,dst);
+  EXPECT_EQ(r.length,34u);
+  EXPECT_EQ(r.errors,0u);
+  EXPECT_EQ(r.firstError,TextCodec::npos);
+  EXPECT_EQ(dst[32],u'-');
+  EXPECT_EQ(dst[33],char16_t(0x0416));
+
+  char back[sizeof(dst)*3] = {};
+  auto r8 = TextCodec::toUtf8(dst,r.length,back);
+  EXPECT_EQ(r8.length,sizeof(src)-1);
+  EXPECT_EQ(std::memcmp(back,src,r8.length),0);
+  }
+
+namespace {
+// reference: naive scalar conversion, without validation
+std::u16string refToUtf16(const std::string& s) {
+  std::u16string out;
+  size_t i=0;
+  while(i<s.size()) {
+    uint8_t  c  = uint8_t(s[i]);
+    uint32_t cp = c;
+    size_t   l  = 1;
+    if(c>=0xF0) { cp = c & 0x07; l = 4; } else
+    if(c>=0xE0) { cp = c & 0x0F; l = 3; } else
+    if(c>=0xC0) { cp = c & 0x1F; l = 2; }
+    for(size_t r=1;r<l;++r)
+      cp = (cp<<6) | (uint8_t(s[i+r]) & 0x3F);
+    if(cp>0xFFFF) {
+      cp -= 0x10000;
+      out.push_back(char16_t(0xD800+(cp>>10)));
+      out.push_back(char16_t(0xDC00+(cp&0x3FF)));
+      } else {
+      out.push_back(char16_t(cp));
+      }
+    i+=l;
+    }
+  return out;
+  }
+}
+
+TEST(main,TextCodecBench) {
+#if !defined(_MSC_VER)
+  struct Corpus { const char* name; std::string text; };
+  Corpus corpus[3] = {
+    {"ascii",    ""},
+    {"cyrillic", ""},
+    {"cjk",      ""},
+    };
+  for(int i=0;i<20000;++i) {
+    corpus[0].text += "The quick brown fox jumps over the lazy dog. ";
+    corpus[1].text += "Съешь же ещё этих мягких булок. ";
+    corpus[2].text += "我能吞下玻璃而不伤身体。";
+    }
+
+  for(auto& c:corpus) {
+    using clock = std::chrono::steady_clock;
+    const int rep = 10;
+
+    auto t0 = clock::now();
+    size_t ref = 0;
+    for(int r=0;r<rep;++r)
+      ref += refToUtf16(c.text).size();
+    auto t1 = clock::now();
+    size_t cvt = 0;
+    std::u16string u16;
+    for(int r=0;r<rep;++r) {
+      u16  = TextCodec::toUtf16(c.text);
+      cvt += u16.size();
+      }
+    auto t2 = clock::now();
+    size_t back = 0;
+    for(int r=0;r<rep;++r)
+      back += TextCodec::toUtf8(u16).size();
+    auto t3 = clock::now();
+
+    EXPECT_EQ(ref,cvt);
+    EXPECT_EQ(back,c.text.size()*rep);
+
+    auto mbs = [&](clock::duration d){
+      double sec = std::chrono::duration<double>(d).count();
+      return double(c.text.size()*rep)/(1024.0*1024.0)/(sec>0 ? sec : 1e-9);
+      };
+    std::printf("[          ] %-8s utf8->16 unchecked: %8.1f MB/s, TextCodec: %8.1f MB/s; utf16->8: %8.1f MB/s\n",
+                c.name,mbs(t1-t0),mbs(t2-t1),mbs(t3-t2));
+    }
+#endif
+  }
@@ -0,0 +1,80 @@
+#include <Tempest/VulkanApi>
+#include <Tempest/Device>
+#include <Tempest/Window>
+#include <Tempest/TextureAtlas>
+#include <Tempest/VectorImage>
+#include <Tempest/Swapchain>
+#include <Tempest/CommandBuffer>
+#include <Tempest/Encoder>
+#include <Tempest/Event>
+#include <Tempest/Log>
+#include <Tempest/Except>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest;
+
+namespace {
+
+struct TestWindow : Window {
+  using Window::dispatchPaintEvent;
+  using Window::hwnd;
+  };
+
+struct Counter : Widget {
+  int paints = 0;
+  void paintEvent(PaintEvent&) override { paints++; }
+  };
+
+}
+
+TEST(main,WidgetLayerCache) {
+  try {
+    VulkanApi    api;
+    Device       device(api);
+    TextureAtlas atlas(device);
+    VectorImage  surface;
+
+    TestWindow wnd;
+    Counter&   w = wnd.addWidget(new Counter());
+    w.setLayer(true);
+
+    // recorded into layer image, then painted directly: no texture yet
+    wnd.dispatchPaintEvent(surface,atlas);
+    EXPECT_EQ(w.paints,2);
+
+    // layer image is up to date
+    wnd.dispatchPaintEvent(surface,atlas);
+    EXPECT_EQ(w.paints,3);
+
+    Swapchain     sw  = device.swapchain(wnd.hwnd());
+    CommandBuffer cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      wnd.dispatchLayers(device,sw,enc);
+    }
+
+    // composited from texture
+    wnd.dispatchPaintEvent(surface,atlas);
+    EXPECT_EQ(w.paints,3);
+
+    // invalidation re-records layer, and paints directly until texture is rendered again
+    w.update();
+    wnd.dispatchPaintEvent(surface,atlas);
+    EXPECT_EQ(w.paints,5);
+
+    {
+      auto enc = cmd.startEncoding(device);
+      wnd.dispatchLayers(device,sw,enc);
+    }
+    wnd.dispatchPaintEvent(surface,atlas);
+    EXPECT_EQ(w.paints,5);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice || e.code()==Tempest::SystemErrc::UnableToCreateWindow)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
@@ -0,0 +1,86 @@
+#include <Tempest/File>
+#include <Tempest/Dir>
+
+#include "assets/assetpack.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace Tempest;
+using Tempest::Detail::AssetPack;
+
+static void usage() {
+  std::printf("usage: tempest-pack [-a align] [-s] <input dir> <output file>\n"
+              "  -a align  data alignment of each entry, in bytes (default 16)\n"
+              "  -s        store entries without compression\n");
+  }
+
+static bool packDir(AssetPack::Writer& pack, const std::string& root, const std::string& rel, bool store, size_t& cnt) {
+  const std::string dir = rel.empty() ? root : root+"/"+rel;
+  bool ok = true;
+  bool ret = Dir::scan(dir,[&](const std::string& name,Dir::FileType type){
+    if(name=="." || name==".." || !ok)
+      return;
+    const std::string path = rel.empty() ? name : rel+"/"+name;
+    if(type==Dir::FT_Dir) {
+      ok = packDir(pack,root,path,store,cnt);
+      return;
+      }
+
+    MappedFile f(root+"/"+path);
+    auto kind = AssetPack::detectType(path.c_str(),f.data(),f.size());
+    pack.add(path.c_str(),f.data(),f.size(),kind,store ? AssetPack::None : AssetPack::Zlib);
+    ++cnt;
+    });
+  return ret && ok;
+  }
+
+int main(int argc,const char** argv) {
+  uint32_t    align = 16;
+  bool        store = false;
+  const char* in    = nullptr;
+  const char* out   = nullptr;
+
+  for(int i=1;i<argc;++i) {
+    if(std::strcmp(argv[i],"-a")==0 && i+1<argc) {
+      align = uint32_t(std::strtoul(argv[++i],nullptr,10));
+      }
+    else if(std::strcmp(argv[i],"-s")==0) {
+      store = true;
+      }
+    else if(in==nullptr) {
+      in = argv[i];
+      }
+    else if(out==nullptr) {
+      out = argv[i];
+      }
+    else {
+      usage();
+      return 1;
+      }
+    }
+
+  if(in==nullptr || out==nullptr || align==0 || (align&(align-1))!=0) {
+    usage();
+    return 1;
+    }
+
+  try {
+    AssetPack::Writer pack(align);
+    size_t            cnt = 0;
+    if(!packDir(pack,in,"",store,cnt)) {
+      std::fprintf(stderr,"unable to scan directory: %s\n",in);
+      return 2;
+      }
+    WFile f(out);
+    pack.save(f);
+    std::printf("%u files packed into %s\n",unsigned(cnt),out);
+    }
+  catch(std::exception& e) {
+    std::fprintf(stderr,"error: %s\n",e.what());
+    return 2;
+    }
+  return 0;
+  }